@@ -0,0 +1,46 @@
+#ifndef _glyphcache_h_
+#define _glyphcache_h_
+
+#include <TFT_eSPI.h>
+
+#define GLYPHCACHE_MAX_GLYPHS 20
+#define GLYPHCACHE_BLEND_LEVELS 32
+
+// Text renderer for a smooth font (.vlw array in PROGMEM) without
+// loadFont()/unloadFont(). The glyph metrics are parsed once and only kept for
+// the characters of the given charset. Anti-aliased pixels are blended against
+// the fixed background with a precomputed colour table, so drawing text is a
+// table lookup per pixel; the glyph bitmaps are read straight from flash.
+class GlyphCache {
+
+    public:
+        GlyphCache();
+        virtual ~GlyphCache();
+
+        bool begin(TFT_eSPI &tft, const uint8_t *font, const char *charset, uint16_t fgColor, uint16_t bgColor);
+
+        int16_t textWidth(const char *text);
+        void drawString(TFT_eSPI &canvas, const char *text, int32_t x, int32_t y, uint8_t datum);
+
+    protected:
+        struct Glyph {
+            uint16_t unicode;
+            uint8_t height;
+            uint8_t width;
+            uint8_t xAdvance;
+            int8_t dX;
+            int16_t dY;
+            const uint8_t *bitmap;
+        };
+
+        const Glyph* findGlyph(uint16_t unicode);
+        void drawGlyph(TFT_eSPI &canvas, const Glyph *glyph, int32_t x, int32_t y);
+
+        Glyph _glyphs[GLYPHCACHE_MAX_GLYPHS];
+        uint8_t _count;
+        int16_t _maxAscent;
+        uint8_t _spaceWidth;
+        uint16_t _blend[GLYPHCACHE_BLEND_LEVELS];
+};
+
+#endif
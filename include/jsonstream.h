@@ -0,0 +1,63 @@
+#ifndef _jsonstream_h_
+#define _jsonstream_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSONSTREAM_MAX_DEPTH 8
+#define JSONSTREAM_MAX_PATH 48
+#define JSONSTREAM_MAX_KEY 24
+#define JSONSTREAM_MAX_VALUE 32
+
+// Called for every scalar value with its path, e.g. "weather[0].icon" or
+// "main.temp". Strings are passed unquoted, numbers and literals as written.
+typedef void (*JsonValueCallback)(void *context, const char *path, const char *value);
+
+// Incremental JSON tokenizer: characters can be fed as they come off the
+// socket, in chunks of any size. Nothing but the current path, key and value
+// is buffered; keys and values longer than the buffers are truncated.
+class JsonStreamParser {
+
+    public:
+        JsonStreamParser(JsonValueCallback callback, void *context);
+        virtual ~JsonStreamParser();
+
+        void reset();
+        void feed(char c);
+        void feed(const char *data, size_t len);
+
+        // the top level value is complete
+        bool isDone();
+        bool hasError();
+
+    protected:
+        enum State {
+            VALUE, VALUE_OR_END, KEY_OR_END, KEY_START, KEY, KEY_ESCAPE, COLON,
+            STRING, STRING_ESCAPE, LITERAL, AFTER_VALUE, DONE, ERROR
+        };
+
+        void push(bool isArray);
+        void pop();
+        void appendPath(const char *segment, bool withDot);
+        void setArrayPath();
+        void appendChar(char *buf, uint8_t &len, uint8_t size, char c);
+        void emit();
+
+        JsonValueCallback _callback;
+        void *_context;
+
+        State _state;
+        uint8_t _depth;
+        bool _isArray[JSONSTREAM_MAX_DEPTH];
+        uint16_t _index[JSONSTREAM_MAX_DEPTH];
+        uint8_t _base[JSONSTREAM_MAX_DEPTH]; // path length of the container
+
+        char _path[JSONSTREAM_MAX_PATH];
+        uint8_t _pathLen;
+        char _key[JSONSTREAM_MAX_KEY];
+        uint8_t _keyLen;
+        char _value[JSONSTREAM_MAX_VALUE];
+        uint8_t _valueLen;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _latency_h_
+#define _latency_h_
+
+#include <Arduino.h>
+
+// bucket 0 counts 0µs, bucket i counts [2^(i-1), 2^i) µs, the last one everything above
+#define LATENCY_BUCKETS 22
+
+// min, max, average and a log2 bucketed histogram of durations in µs
+// record() is a few instructions, so it can be used on every loop() pass
+class LatencyHistogram {
+
+    public:
+        LatencyHistogram();
+
+        void record(uint32_t us);
+        void reset();
+
+        uint32_t getCount() const;
+        uint32_t getMin() const;
+        uint32_t getMax() const;
+        uint32_t getAverage() const;
+        uint32_t getBucket(uint8_t idx) const;
+        // upper bound of the bucket containing the percentile, 0 without samples
+        uint32_t getPercentile(uint8_t percent) const;
+
+        // {"name":"loop","count":12,"min":3,...,"hist":[0,2,...]}
+        size_t toJson(char *buf, size_t size, const char *name) const;
+
+    protected:
+        uint32_t _count;
+        uint32_t _min;
+        uint32_t _max;
+        uint64_t _sum;
+        uint32_t _buckets[LATENCY_BUCKETS];
+};
+
+// records the time from construction to the end of the scope
+class LatencyProbe {
+
+    public:
+        LatencyProbe(LatencyHistogram &histogram) : _histogram(histogram), _start(micros()) {}
+        ~LatencyProbe() { _histogram.record(micros() - _start); }
+
+    protected:
+        LatencyHistogram &_histogram;
+        uint32_t _start;
+};
+
+#endif
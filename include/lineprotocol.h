@@ -0,0 +1,23 @@
+#ifndef _lineprotocol_h_
+#define _lineprotocol_h_
+
+#include <stddef.h>
+
+// Helpers for the line protocol payloads published via MQTT and for the
+// url encoded form of the config page. Plain C strings only, no Arduino
+// dependencies, so this part of the firmware also builds off-device.
+
+// <measurand>,location=<location>,node=<node>,sensor=<sensor> value=<value>
+size_t formatSensorLine(char *buf, size_t size, const char *measurand, const char *location,
+  const char *node, const char *sensor, const char *value);
+
+// value of a field in the field set of a line protocol entry, nullptr if missing
+const char* findField(const char *line, const char *key);
+
+// copy the measurement name or a field value up to the next ',' or ' '
+size_t copyToken(char *buf, size_t size, const char *token);
+
+// url decoded value of a form field in "key1=value1&key2=value2", false if missing
+bool findFormValue(const char *form, const char *key, char *value, size_t size);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef _logring_h_
+#define _logring_h_
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+#define LOGRING_SIZE 4096     // bytes for all records
+#define LOGRING_MAX_ARGS 160  // packed argument bytes of one record
+#define LOGRING_HEADER (2 + 4 + sizeof(PGM_P)) // len, flags, time, format
+
+// one record, args points into the ring and is valid until the next add()
+struct LogRecord {
+  uint32_t id;
+  uint32_t time;
+  bool synced;  // time is UTC, else the uptime in seconds
+  uint8_t level;
+  PGM_P format; // PROGMEM
+  const uint8_t *args;
+  uint8_t argsLength;
+};
+
+struct LogCursor {
+  uint16_t pos;
+  uint16_t remaining;
+  uint32_t id;
+};
+
+// Log records of variable length in a fixed byte ring, the oldest records are
+// dropped when it is full. A record keeps the PROGMEM format and its arguments
+// packed binary (integers and floats 4 bytes, strings copied), the text is only
+// formatted when the record is read.
+// Supported conversions: d i u x X o c (with l or h), f e g, s, S (a PROGMEM
+// string, copied as well) and %%.
+class LogRing {
+
+    public:
+        LogRing();
+
+        // pack the arguments of format into out, returns the number of bytes used
+        static uint8_t pack(PGM_P format, va_list args, uint8_t out[LOGRING_MAX_ARGS]);
+        // args as returned by pack(), returns the id of the new record
+        uint32_t add(uint32_t time, bool synced, uint8_t level, PGM_P format, const uint8_t *args, uint8_t argsLength);
+        // add a copy of a record returned by getLastRaw(), of the same firmware
+        uint32_t addRaw(const uint8_t *raw);
+        // the newest record as stored, the first byte is its length
+        const uint8_t* getLastRaw();
+
+        // iterate from the oldest record: cursor = begin(); while (read(cursor, rec)) {...}
+        LogCursor begin();
+        bool read(LogCursor &cursor, LogRecord &rec);
+        // the newest record
+        bool readLast(LogRecord &rec);
+
+        uint32_t getFirstId();
+        // renumber the records, the oldest gets id
+        void setFirstId(uint32_t id);
+        // the id of the next record
+        uint32_t getNextId();
+        uint16_t getCount();
+
+        // records written before the time was synced get UTC = uptime + bootTime
+        void backfillTime(uint32_t bootTime);
+
+        static size_t format(const LogRecord &rec, char *buf, size_t size);
+
+    protected:
+        uint8_t _buf[LOGRING_SIZE];
+        uint16_t _head;  // write position
+        uint16_t _tail;  // oldest record
+        uint16_t _last;  // newest record
+        uint16_t _count;
+        uint32_t _firstId;
+
+        uint8_t* alloc(uint16_t len);
+        bool fits(uint16_t len);
+        void dropOldest();
+        uint16_t normalize(uint16_t pos);
+};
+
+#endif
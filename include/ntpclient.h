@@ -0,0 +1,62 @@
+#ifndef _ntpclient_h_
+#define _ntpclient_h_
+
+#include <ESP8266WiFi.h>
+
+#define NTP_PORT 123
+#define NTP_LOCAL_PORT 2390
+#define NTP_PACKET_SIZE 48
+#define NTP_TIMEOUT_MS 1000
+#define NTP_DEFAULT_INTERVAL_SEC 1800
+// without an answer the next request follows after 16s, 32s, ... up to 17 min
+#define NTP_RETRY_MIN_SEC 16
+#define NTP_RETRY_MAX_SEC 1024
+// the server name is resolved again after this many unanswered requests in a row
+#define NTP_RESOLVE_AFTER_TIMEOUTS 4
+
+// SNTP client that never blocks: loop() sends a request when one is due and
+// polls for the answer on the following calls. The answer sets the ezTime UTC
+// clock, with the milliseconds and half of the round trip. Failed requests
+// back off, so an unreachable server or a network that is down costs nothing.
+// The server name is resolved once, the lookup blocks; again only after
+// NTP_RESOLVE_AFTER_TIMEOUTS unanswered requests in a row.
+// ezTime's own NTP updates must be off: setInterval(0).
+class NtpClient {
+
+    public:
+        NtpClient();
+
+        void setServer(const char *server);
+        void setInterval(uint32_t seconds);
+        // sends or receives, returns true if the time has just been set
+        bool loop();
+        // the next loop() sends a request
+        void update();
+
+        uint32_t getRequests() { return _requests; }
+        uint32_t getFailures() { return _failures; }
+        // round trip of the last answer
+        uint32_t getRoundTripMs() { return _roundTrip; }
+
+    protected:
+        bool send();
+        bool receive();
+        void fail();
+
+        WiFiUDP _udp;
+        bool _udpStarted;
+        char _server[64];
+        IPAddress _ip;
+        bool _resolved;
+        bool _waiting;      // for the answer to the request sent at _sentMs
+        uint32_t _sentMs;
+        uint32_t _nextMs;   // millis() of the next request
+        uint32_t _interval; // ms between updates
+        uint32_t _retry;    // ms after the next failure
+        uint8_t _timeouts;  // unanswered requests in a row
+        uint32_t _requests;
+        uint32_t _failures;
+        uint32_t _roundTrip;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef _scheduler_h_
+#define _scheduler_h_
+
+#include <Arduino.h>
+#include "latency.h"
+
+#define SCHEDULER_MAX_TASKS 12
+
+// due tasks run in this order within one pass
+#define TASK_PRIORITY_HIGH 0   // acquisition
+#define TASK_PRIORITY_NORMAL 1 // network
+#define TASK_PRIORITY_LOW 2    // UI, web server, OTA
+
+typedef void (*TaskFunction)();
+
+struct Task {
+  const char *name;
+  TaskFunction function;
+  uint32_t interval;    // ms, 0 = on every pass
+  uint32_t nextRun;     // millis() of the next deadline
+  uint32_t budget;      // µs, a run taking longer is an overrun
+  uint8_t priority;
+  bool enabled;
+  bool running;
+  uint32_t runs;
+  uint32_t overruns;
+  uint32_t lastDuration; // µs
+  LatencyHistogram latency;
+};
+
+typedef void (*OverrunHandler)(const Task &task, uint32_t duration);
+
+// cooperative scheduler, call loop() from the Arduino loop()
+// Deadlines are absolute: a task is re-armed relative to its last deadline, not
+// to the time it has run, so it doesn't drift. Deadlines missed completely are
+// skipped, a task never runs twice in a row to catch up.
+// loop() may be called from within a task (e.g. to wait), a running task is
+// skipped then.
+// All tasks live in a fixed table, nothing is allocated.
+class Scheduler {
+
+    public:
+        Scheduler();
+
+        // returns the task id, -1 if the table is full
+        // the first run is one interval after adding
+        int8_t add(const char *name, TaskFunction function, uint32_t interval, uint8_t priority, uint32_t budget);
+        void setEnabled(int8_t id, bool enabled);
+        // the new interval counts from now
+        void setInterval(int8_t id, uint32_t interval);
+        void setOverrunHandler(OverrunHandler handler);
+        // clear the latency histograms of all tasks
+        void resetLatency();
+
+        // run all due tasks, in order of priority
+        void loop();
+
+        uint8_t getTaskCount();
+        const Task& getTask(uint8_t idx);
+
+    protected:
+        Task _tasks[SCHEDULER_MAX_TASKS];
+        uint8_t _order[SCHEDULER_MAX_TASKS]; // task ids sorted by priority
+        uint8_t _count;
+        OverrunHandler _overrunHandler;
+
+        void run(Task &task);
+};
+
+#endif
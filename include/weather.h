@@ -2,28 +2,83 @@
 #define _weather_h_
 
 #include <ESP8266WiFi.h>
+#include "jsonstream.h"
 
 #define OPENWEATHERMAP_SRV "api.openweathermap.org"
 
+#define WEATHER_ICON_LENGTH 8 // "04n.bmp"
+
+// current weather as delivered by openweathermap.org
+struct WeatherData {
+  char icon[WEATHER_ICON_LENGTH]; // bitmap name, e.g. "04n.bmp"
+  float temperature;              // °C
+  float feelsLike;                // °C
+  float pressure;                 // hPa
+  float windSpeed;                // m/s
+  uint16_t windDeg;
+  uint8_t humidity;               // %
+  uint8_t clouds;                 // %
+  uint32_t sunrise;               // UTC
+  uint32_t sunset;                // UTC
+  uint32_t dt;                    // time of the measurement (UTC)
+  uint32_t fetched;               // time of the API call (UTC), 0 if unknown
+};
 
 // get Weather data from openweathermap.org
-// sent request for data
+// requestWeatherData() sends the request, loop() reads the response piecewise
+// without blocking. The client uses its own connection, so MQTT and the web
+// server are not disturbed while a forecast downloads. Only the connect blocks,
+// the server address is cached, so there is no DNS lookup per request.
+// The last data is cached, isExpired() tells if it is older than the TTL.
 class WeatherClient {
 
     public:
-        WeatherClient(WiFiClient* client);
+        WeatherClient();
         virtual ~WeatherClient();
 
-        void readWeatherData();
+        void requestWeatherData();
+        // process the pending response, returns true if new weather data has arrived
+        bool loop();
+        bool isBusy();
+        // take over weather data fetched by another node
+        void setWeatherData(const WeatherData &data);
 
-        const String getIcon();
+        void setTtl(uint32_t seconds);
+        bool isExpired();
+        // seconds since the cached data was fetched, since it was set if the time is unknown
+        uint32_t getAge();
+
+        const WeatherData& getWeatherData();
+        const char* getIcon();
         const float getTemperature();
         bool isValid();
 
+        // line protocol: weather,node=<node> icon="04n",temperature=7.54,...,fetched=1602956848i
+        size_t toLineProtocol(char *buf, size_t size, const char *node);
+        static bool fromLineProtocol(const char *line, WeatherData &data);
+
     protected:
-        WiFiClient* _client;
-        String icon;
-        float temperatur;
+        enum State { IDLE, HEADERS, BODY };
+
+        static void onJsonValue(void *context, const char *path, const char *value);
+        void setState(State state);
+        bool finish();
+
+        WiFiClient _client;
+        State _state;
+        unsigned long _stateStart;
+        uint8_t _headerEndMatch;
+        JsonStreamParser _parser;
+        IPAddress _ip;
+        bool _resolved;
+
+        WeatherData _data;
+        unsigned long _updated; // millis() when _data was set
+        uint32_t _ttl;          // seconds
+
+        // values of the response currently parsed
+        WeatherData _pending;
+        bool _hasTemperatur;
 };
 
-#endif
\ No newline at end of file
+#endif
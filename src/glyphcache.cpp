@@ -0,0 +1,132 @@
+#include "glyphcache.h"
+
+// .vlw layout: 6 x int32 header, 7 x int32 metrics per glyph, then the
+// 8 bit alpha bitmaps of all glyphs in the same order (all values big endian)
+#define VLW_HEADER_SIZE 24
+#define VLW_METRICS_SIZE 28
+
+static int32_t readVlwInt(const uint8_t *p) {
+  return ((uint32_t) pgm_read_byte(p) << 24) | ((uint32_t) pgm_read_byte(p+1) << 16) 
+       | ((uint32_t) pgm_read_byte(p+2) << 8) | pgm_read_byte(p+3);
+}
+
+// decode one UTF-8 character (up to 3 bytes) and advance text
+static uint16_t nextCodepoint(const char *&text) {
+  uint8_t c = (uint8_t) *text++;
+  if ((c & 0xE0) == 0xC0 && *text) {
+    return ((c & 0x1F) << 6) | ((uint8_t) *text++ & 0x3F);
+  }
+  if ((c & 0xF0) == 0xE0 && text[0] && text[1]) {
+    uint16_t u = ((c & 0x0F) << 12) | (((uint8_t) *text++ & 0x3F) << 6);
+    return u | ((uint8_t) *text++ & 0x3F);
+  }
+  return c;
+}
+
+GlyphCache::GlyphCache() : _count(0), _maxAscent(0), _spaceWidth(0) {
+}
+
+GlyphCache::~GlyphCache() {
+}
+
+bool GlyphCache::begin(TFT_eSPI &tft, const uint8_t *font, const char *charset, uint16_t fgColor, uint16_t bgColor) {
+  _count = 0;
+  _maxAscent = 0;
+
+  uint16_t gCount = readVlwInt(font);
+  int32_t ascent = readVlwInt(font + 16);
+  int32_t descent = readVlwInt(font + 20);
+  _spaceWidth = (ascent + descent) * 2 / 7; // same as TFT_eSPI
+
+  const uint8_t *metrics = font + VLW_HEADER_SIZE;
+  const uint8_t *bitmap = metrics + gCount * VLW_METRICS_SIZE;
+  for (uint16_t i = 0; i < gCount; ++i, metrics += VLW_METRICS_SIZE) {
+    Glyph g;
+    g.unicode  = readVlwInt(metrics);
+    g.height   = readVlwInt(metrics + 4);
+    g.width    = readVlwInt(metrics + 8);
+    g.xAdvance = readVlwInt(metrics + 12);
+    g.dY       = readVlwInt(metrics + 16);
+    g.dX       = readVlwInt(metrics + 20);
+    g.bitmap   = bitmap;
+    bitmap += g.width * g.height;
+
+    // the baseline is derived from all printable glyphs, as TFT_eSPI does,
+    // so the text lands on the same pixels as with loadFont()
+    if (g.unicode > 0x20 && g.unicode < 0xA0 && g.dY > _maxAscent) _maxAscent = g.dY;
+
+    const char *p = charset;
+    while (*p) {
+      if (nextCodepoint(p) == g.unicode) {
+        if (_count < GLYPHCACHE_MAX_GLYPHS) _glyphs[_count++] = g;
+        break;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < GLYPHCACHE_BLEND_LEVELS; ++i) {
+    uint8_t alpha = (i << 3) | (i >> 2);
+    _blend[i] = tft.alphaBlend(alpha, fgColor, bgColor);
+  }
+
+  return _count > 0;
+}
+
+const GlyphCache::Glyph* GlyphCache::findGlyph(uint16_t unicode) {
+  for (uint8_t i = 0; i < _count; ++i) {
+    if (_glyphs[i].unicode == unicode) return &_glyphs[i];
+  }
+  return nullptr;
+}
+
+int16_t GlyphCache::textWidth(const char *text) {
+  int16_t width = 0;
+  while (*text) {
+    const Glyph *g = findGlyph(nextCodepoint(text));
+    if (g == nullptr) {
+      width += _spaceWidth + 1;
+      continue;
+    }
+    if (width == 0 && g->dX < 0) width -= g->dX;
+    if (*text) {
+      width += g->xAdvance;
+    } else {
+      width += g->dX + g->width;
+    }
+  }
+  return width;
+}
+
+void GlyphCache::drawString(TFT_eSPI &canvas, const char *text, int32_t x, int32_t y, uint8_t datum) {
+  if (datum == TR_DATUM) {
+    x -= textWidth(text);
+  } else if (datum == TC_DATUM) {
+    x -= textWidth(text) / 2;
+  }
+
+  while (*text) {
+    const Glyph *g = findGlyph(nextCodepoint(text));
+    if (g == nullptr) {
+      x += _spaceWidth + 1;
+      continue;
+    }
+    drawGlyph(canvas, g, x + g->dX, y + _maxAscent - g->dY);
+    x += g->xAdvance;
+  }
+}
+
+void GlyphCache::drawGlyph(TFT_eSPI &canvas, const Glyph *glyph, int32_t x, int32_t y) {
+  const uint8_t *p = glyph->bitmap;
+  for (uint8_t row = 0; row < glyph->height; ++row) {
+    // draw runs of equal colour, background pixels are left untouched
+    uint8_t runStart = 0;
+    uint8_t runLevel = 0;
+    for (uint8_t col = 0; col <= glyph->width; ++col) {
+      uint8_t level = (col < glyph->width) ? (pgm_read_byte(p++) >> 3) : 0;
+      if (level == runLevel) continue;
+      if (runLevel > 0) canvas.drawFastHLine(x + runStart, y + row, col - runStart, _blend[runLevel]);
+      runStart = col;
+      runLevel = level;
+    }
+  }
+}
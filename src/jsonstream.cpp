@@ -0,0 +1,219 @@
+#include "jsonstream.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isLiteralChar(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+JsonStreamParser::JsonStreamParser(JsonValueCallback callback, void *context) : _callback(callback), _context(context) {
+  reset();
+}
+
+JsonStreamParser::~JsonStreamParser() {
+}
+
+void JsonStreamParser::reset() {
+  _state = VALUE;
+  _depth = 0;
+  _path[0] = '\0';
+  _pathLen = 0;
+  _key[0] = '\0';
+  _keyLen = 0;
+  _value[0] = '\0';
+  _valueLen = 0;
+}
+
+bool JsonStreamParser::isDone() {
+  return _state == DONE;
+}
+
+bool JsonStreamParser::hasError() {
+  return _state == ERROR;
+}
+
+void JsonStreamParser::feed(const char *data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    feed(data[i]);
+  }
+}
+
+void JsonStreamParser::appendChar(char *buf, uint8_t &len, uint8_t size, char c) {
+  if (len < size - 1) {
+    buf[len++] = c;
+    buf[len] = '\0';
+  }
+}
+
+void JsonStreamParser::appendPath(const char *segment, bool withDot) {
+  if (withDot && _pathLen > 0) appendChar(_path, _pathLen, JSONSTREAM_MAX_PATH, '.');
+  while (*segment) appendChar(_path, _pathLen, JSONSTREAM_MAX_PATH, *segment++);
+}
+
+void JsonStreamParser::setArrayPath() {
+  char segment[8];
+  _pathLen = _base[_depth - 1];
+  _path[_pathLen] = '\0';
+  snprintf(segment, sizeof(segment), "[%u]", _index[_depth - 1]);
+  appendPath(segment, false);
+}
+
+void JsonStreamParser::push(bool isArray) {
+  if (_depth >= JSONSTREAM_MAX_DEPTH) {
+    _state = ERROR;
+    return;
+  }
+  _isArray[_depth] = isArray;
+  _index[_depth] = 0;
+  _base[_depth] = _pathLen;
+  ++_depth;
+  if (isArray) {
+    setArrayPath();
+    _state = VALUE_OR_END;
+  } else {
+    _state = KEY_OR_END;
+  }
+}
+
+void JsonStreamParser::pop() {
+  --_depth;
+  _pathLen = _base[_depth];
+  _path[_pathLen] = '\0';
+  _state = (_depth == 0) ? DONE : AFTER_VALUE;
+}
+
+void JsonStreamParser::emit() {
+  if (_callback != nullptr) _callback(_context, _path, _value);
+  _value[0] = '\0';
+  _valueLen = 0;
+  if (_depth == 0) {
+    _state = DONE;
+  } else {
+    _state = AFTER_VALUE;
+  }
+}
+
+void JsonStreamParser::feed(char c) {
+  switch (_state) {
+    case VALUE_OR_END:
+      if (isWhitespace(c)) return;
+      if (c == ']') {
+        pop();
+        return;
+      }
+      _state = VALUE;
+      // fall through
+    case VALUE:
+      if (isWhitespace(c)) return;
+      if (c == '{') {
+        push(false);
+      } else if (c == '[') {
+        push(true);
+      } else if (c == '"') {
+        _state = STRING;
+      } else if (isLiteralChar(c)) {
+        appendChar(_value, _valueLen, JSONSTREAM_MAX_VALUE, c);
+        _state = LITERAL;
+      } else {
+        _state = ERROR;
+      }
+      return;
+
+    case KEY_OR_END:
+      if (isWhitespace(c)) return;
+      if (c == '}') {
+        pop();
+        return;
+      }
+      _state = KEY_START;
+      // fall through
+    case KEY_START:
+      if (isWhitespace(c)) return;
+      if (c == '"') {
+        _key[0] = '\0';
+        _keyLen = 0;
+        _state = KEY;
+      } else {
+        _state = ERROR;
+      }
+      return;
+
+    case KEY:
+      if (c == '\\') {
+        _state = KEY_ESCAPE;
+      } else if (c == '"') {
+        _state = COLON;
+      } else {
+        appendChar(_key, _keyLen, JSONSTREAM_MAX_KEY, c);
+      }
+      return;
+
+    case KEY_ESCAPE:
+      appendChar(_key, _keyLen, JSONSTREAM_MAX_KEY, c);
+      _state = KEY;
+      return;
+
+    case COLON:
+      if (isWhitespace(c)) return;
+      if (c == ':') {
+        _pathLen = _base[_depth - 1];
+        _path[_pathLen] = '\0';
+        appendPath(_key, true);
+        _state = VALUE;
+      } else {
+        _state = ERROR;
+      }
+      return;
+
+    case STRING:
+      if (c == '\\') {
+        _state = STRING_ESCAPE;
+      } else if (c == '"') {
+        emit();
+      } else {
+        appendChar(_value, _valueLen, JSONSTREAM_MAX_VALUE, c);
+      }
+      return;
+
+    case STRING_ESCAPE:
+      // escaped characters are taken literally, \uXXXX is kept as "uXXXX"
+      appendChar(_value, _valueLen, JSONSTREAM_MAX_VALUE, c == 'n' ? '\n' : c == 't' ? '\t' : c);
+      _state = STRING;
+      return;
+
+    case LITERAL:
+      if (isLiteralChar(c)) {
+        appendChar(_value, _valueLen, JSONSTREAM_MAX_VALUE, c);
+        return;
+      }
+      emit();
+      if (_state == AFTER_VALUE) feed(c);
+      return;
+
+    case AFTER_VALUE:
+      if (isWhitespace(c)) return;
+      if (c == ',') {
+        if (_isArray[_depth - 1]) {
+          ++_index[_depth - 1];
+          setArrayPath();
+          _state = VALUE;
+        } else {
+          _state = KEY_START;
+        }
+      } else if ((c == '}' && !_isArray[_depth - 1]) || (c == ']' && _isArray[_depth - 1])) {
+        pop();
+      } else {
+        _state = ERROR;
+      }
+      return;
+
+    case DONE:
+    case ERROR:
+      return;
+  }
+}
@@ -0,0 +1,76 @@
+#include "latency.h"
+
+LatencyHistogram::LatencyHistogram() {
+  reset();
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  uint8_t idx = us == 0 ? 0 : 32 - __builtin_clz(us);
+  if (idx >= LATENCY_BUCKETS) idx = LATENCY_BUCKETS - 1;
+  ++_buckets[idx];
+  ++_count;
+  _sum += us;
+  if (us < _min) _min = us;
+  if (us > _max) _max = us;
+}
+
+void LatencyHistogram::reset() {
+  _count = 0;
+  _min = UINT32_MAX;
+  _max = 0;
+  _sum = 0;
+  memset(_buckets, 0, sizeof(_buckets));
+}
+
+uint32_t LatencyHistogram::getCount() const {
+  return _count;
+}
+
+uint32_t LatencyHistogram::getMin() const {
+  return _count > 0 ? _min : 0;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+  return _max;
+}
+
+uint32_t LatencyHistogram::getAverage() const {
+  return _count > 0 ? (uint32_t) (_sum / _count) : 0;
+}
+
+uint32_t LatencyHistogram::getBucket(uint8_t idx) const {
+  return idx < LATENCY_BUCKETS ? _buckets[idx] : 0;
+}
+
+uint32_t LatencyHistogram::getPercentile(uint8_t percent) const {
+  if (_count == 0) return 0;
+
+  uint64_t rank = ((uint64_t) _count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKETS - 1; ++i) {
+    seen += _buckets[i];
+    if (seen >= rank) {
+      // the bucket bound, but never more than the real maximum
+      return min(i == 0 ? 0 : (1UL << i) - 1, (unsigned long) _max);
+    }
+  }
+  return _max;
+}
+
+size_t LatencyHistogram::toJson(char *buf, size_t size, const char *name) const {
+  int len = snprintf(buf, size, "{\"name\":\"%s\",\"count\":%lu,\"min\":%lu,\"max\":%lu,\"avg\":%lu,\"p50\":%lu,\"p99\":%lu,\"hist\":[",
+    name,
+    (unsigned long) _count,
+    (unsigned long) getMin(),
+    (unsigned long) _max,
+    (unsigned long) getAverage(),
+    (unsigned long) getPercentile(50),
+    (unsigned long) getPercentile(99));
+  for (uint8_t i = 0; i < LATENCY_BUCKETS && len < (int) size; ++i) {
+    len += snprintf(buf + len, size - len, "%s%lu", i > 0 ? "," : "", (unsigned long) _buckets[i]);
+  }
+  if (len < (int) size) {
+    len += snprintf(buf + len, size - len, "]}");
+  }
+  return min((size_t) len, size - 1);
+}
@@ -0,0 +1,64 @@
+#include "lineprotocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t formatSensorLine(char *buf, size_t size, const char *measurand, const char *location,
+  const char *node, const char *sensor, const char *value) {
+  int len = snprintf(buf, size, "%s,location=%s,node=%s,sensor=%s value=%s", measurand, location, node, sensor, value);
+  return len < 0 ? 0 : (size_t) len;
+}
+
+const char* findField(const char *line, const char *key) {
+  const char *fields = strchr(line, ' ');
+  size_t keyLen = strlen(key);
+  while (fields != nullptr) {
+    ++fields;
+    if (strncmp(fields, key, keyLen) == 0 && fields[keyLen] == '=') return fields + keyLen + 1;
+    fields = strchr(fields, ',');
+  }
+  return nullptr;
+}
+
+size_t copyToken(char *buf, size_t size, const char *token) {
+  if (size == 0) return 0;
+  size_t len = strcspn(token, ", ");
+  if (len >= size) len = size - 1;
+  memcpy(buf, token, len);
+  buf[len] = '\0';
+  return len;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool findFormValue(const char *form, const char *key, char *value, size_t size) {
+  size_t keyLen = strlen(key);
+  const char *field = form;
+  // the key has to start a field, "show" must not match "remote-show"
+  while (field != nullptr && !(strncmp(field, key, keyLen) == 0 && field[keyLen] == '=')) {
+    field = strchr(field, '&');
+    if (field != nullptr) ++field;
+  }
+  if (field == nullptr) return false;
+
+  const char *src = field + keyLen + 1;
+  size_t len = 0;
+  while (*src != '\0' && *src != '&' && len + 1 < size) {
+    char c = *src++;
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && hexValue(src[0]) >= 0 && hexValue(src[1]) >= 0) {
+      c = (char) (hexValue(src[0]) << 4 | hexValue(src[1]));
+      src += 2;
+    }
+    value[len++] = c;
+  }
+  if (size > 0) value[len] = '\0';
+  return true;
+}
@@ -0,0 +1,272 @@
+#include "logring.h"
+
+#define LOGRING_SYNCED 0x80
+
+LogRing::LogRing() : _head(0), _tail(0), _last(0), _count(0), _firstId(0) {
+}
+
+uint8_t LogRing::pack(PGM_P format, va_list args, uint8_t out[LOGRING_MAX_ARGS]) {
+  uint8_t len = 0;
+  PGM_P p = format;
+  char c;
+  while ((c = pgm_read_byte(p++)) != '\0') {
+    if (c != '%') continue;
+
+    bool isLong = false;
+    while ((c = pgm_read_byte(p)) != '\0' && strchr("-+ #0123456789.lhz", c) != nullptr) {
+      if (c == 'l' || c == 'z') isLong = true;
+      ++p;
+    }
+    if (c == '\0') break;
+    ++p;
+
+    switch (c) {
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+        uint32_t v = isLong ? (uint32_t) va_arg(args, unsigned long) : (uint32_t) va_arg(args, unsigned int);
+        if (len + sizeof(v) > LOGRING_MAX_ARGS) return len;
+        memcpy(out + len, &v, sizeof(v));
+        len += sizeof(v);
+        break;
+      }
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+        float v = (float) va_arg(args, double);
+        if (len + sizeof(v) > LOGRING_MAX_ARGS) return len;
+        memcpy(out + len, &v, sizeof(v));
+        len += sizeof(v);
+        break;
+      }
+      case 's': {
+        const char *v = va_arg(args, const char *);
+        if (v == nullptr) v = "(null)";
+        if (len + 1 > LOGRING_MAX_ARGS) return len;
+        // a long string is truncated to the remaining space
+        size_t n = strnlen(v, LOGRING_MAX_ARGS - len - 1);
+        memcpy(out + len, v, n);
+        out[len + n] = '\0';
+        len += n + 1;
+        break;
+      }
+      case 'S': {
+        PGM_P v = va_arg(args, PGM_P);
+        if (v == nullptr) v = PSTR("(null)");
+        if (len + 1 > LOGRING_MAX_ARGS) return len;
+        size_t n = strnlen_P(v, LOGRING_MAX_ARGS - len - 1);
+        memcpy_P(out + len, v, n);
+        out[len + n] = '\0';
+        len += n + 1;
+        break;
+      }
+      default: // %% or not supported
+        break;
+    }
+  }
+  return len;
+}
+
+// a 0 length marks the unused end of the buffer
+uint16_t LogRing::normalize(uint16_t pos) {
+  return (pos >= LOGRING_SIZE || _buf[pos] == 0) ? 0 : pos;
+}
+
+// Without wrap the records are in [tail, head), with wrap in [tail, end) and [0, head).
+bool LogRing::fits(uint16_t len) {
+  if (_count == 0) {
+    _head = _tail = 0;
+    return true;
+  }
+  if (_tail < _head) {
+    if (LOGRING_SIZE - _head >= len) return true;
+    if (_tail >= len) {
+      if (_head < LOGRING_SIZE) _buf[_head] = 0;
+      _head = 0;
+      return true;
+    }
+    return false;
+  }
+  return _tail - _head >= len;
+}
+
+void LogRing::dropOldest() {
+  _tail += _buf[_tail];
+  --_count;
+  ++_firstId;
+  if (_count == 0) {
+    _head = _tail = 0;
+  } else {
+    _tail = normalize(_tail);
+  }
+}
+
+// room for a new record of len bytes, drops the oldest records if needed
+uint8_t* LogRing::alloc(uint16_t len) {
+  while (!fits(len)) {
+    dropOldest();
+  }
+  _last = _head;
+  _head += len;
+  ++_count;
+  return _buf + _last;
+}
+
+uint32_t LogRing::add(uint32_t time, bool synced, uint8_t level, PGM_P format, const uint8_t *args, uint8_t argsLength) {
+  uint16_t len = LOGRING_HEADER + argsLength;
+
+  uint8_t *rec = alloc(len);
+  rec[0] = len;
+  rec[1] = (level & ~LOGRING_SYNCED) | (synced ? LOGRING_SYNCED : 0);
+  memcpy(rec + 2, &time, sizeof(time));
+  memcpy(rec + 6, &format, sizeof(format));
+  memcpy(rec + LOGRING_HEADER, args, argsLength);
+  return _firstId + _count - 1;
+}
+
+uint32_t LogRing::addRaw(const uint8_t *raw) {
+  memcpy(alloc(raw[0]), raw, raw[0]);
+  return _firstId + _count - 1;
+}
+
+const uint8_t* LogRing::getLastRaw() {
+  return _count > 0 ? _buf + _last : nullptr;
+}
+
+LogCursor LogRing::begin() {
+  LogCursor cursor = { .pos = _tail, .remaining = _count, .id = _firstId };
+  return cursor;
+}
+
+bool LogRing::read(LogCursor &cursor, LogRecord &rec) {
+  if (cursor.remaining == 0) return false;
+
+  cursor.pos = normalize(cursor.pos);
+  const uint8_t *r = _buf + cursor.pos;
+  rec.id = cursor.id;
+  rec.level = r[1] & ~LOGRING_SYNCED;
+  rec.synced = (r[1] & LOGRING_SYNCED) != 0;
+  memcpy(&rec.time, r + 2, sizeof(rec.time));
+  memcpy(&rec.format, r + 6, sizeof(rec.format));
+  rec.args = r + LOGRING_HEADER;
+  rec.argsLength = r[0] - LOGRING_HEADER;
+
+  cursor.pos += r[0];
+  --cursor.remaining;
+  ++cursor.id;
+  return true;
+}
+
+bool LogRing::readLast(LogRecord &rec) {
+  LogCursor cursor = { .pos = _last, .remaining = (uint16_t) (_count > 0 ? 1 : 0), .id = getNextId() - 1 };
+  return read(cursor, rec);
+}
+
+uint32_t LogRing::getFirstId() {
+  return _firstId;
+}
+
+void LogRing::setFirstId(uint32_t id) {
+  _firstId = id;
+}
+
+uint32_t LogRing::getNextId() {
+  return _firstId + _count;
+}
+
+uint16_t LogRing::getCount() {
+  return _count;
+}
+
+void LogRing::backfillTime(uint32_t bootTime) {
+  uint16_t pos = _tail;
+  for (uint16_t i = 0; i < _count; ++i) {
+    pos = normalize(pos);
+    uint8_t *r = _buf + pos;
+    if ((r[1] & LOGRING_SYNCED) == 0) {
+      uint32_t time;
+      memcpy(&time, r + 2, sizeof(time));
+      time += bootTime;
+      memcpy(r + 2, &time, sizeof(time));
+      r[1] |= LOGRING_SYNCED;
+    }
+    pos += r[0];
+  }
+}
+
+size_t LogRing::format(const LogRecord &rec, char *buf, size_t size) {
+  if (size == 0) return 0;
+
+  const uint8_t *arg = rec.args;
+  const uint8_t *argsEnd = rec.args + rec.argsLength;
+  size_t len = 0;
+  char spec[16];
+  PGM_P p = rec.format;
+  char c;
+  while ((c = pgm_read_byte(p++)) != '\0' && len + 1 < size) {
+    if (c != '%') {
+      buf[len++] = c;
+      continue;
+    }
+
+    // the conversion without length modifiers, the arguments are 4 bytes
+    uint8_t specLength = 0;
+    spec[specLength++] = '%';
+    while ((c = pgm_read_byte(p)) != '\0' && strchr("-+ #0123456789.lhz", c) != nullptr) {
+      if (c != 'l' && c != 'h' && c != 'z' && specLength < sizeof(spec) - 2) spec[specLength++] = c;
+      ++p;
+    }
+    if (c == '\0') break;
+    ++p;
+    spec[specLength++] = c;
+    spec[specLength] = '\0';
+
+    int n = 0;
+    switch (c) {
+      case '%':
+        buf[len++] = '%';
+        break;
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+        uint32_t v;
+        if (arg + sizeof(v) > argsEnd) {
+          n = snprintf(buf + len, size - len, "?");
+          break;
+        }
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        if (c == 'd' || c == 'i' || c == 'c') {
+          n = snprintf(buf + len, size - len, spec, (int) (int32_t) v);
+        } else {
+          n = snprintf(buf + len, size - len, spec, (unsigned int) v);
+        }
+        break;
+      }
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+        float v;
+        if (arg + sizeof(v) > argsEnd) {
+          n = snprintf(buf + len, size - len, "?");
+          break;
+        }
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        n = snprintf(buf + len, size - len, spec, (double) v);
+        break;
+      }
+      case 'S': // packed like s
+        spec[specLength - 1] = 's';
+        // fall through
+      case 's': {
+        size_t available = argsEnd - arg;
+        size_t sl = strnlen((const char *) arg, available);
+        if (sl == available) {
+          n = snprintf(buf + len, size - len, "?");
+          break;
+        }
+        n = snprintf(buf + len, size - len, spec, (const char *) arg);
+        arg += sl + 1;
+        break;
+      }
+      default:
+        n = snprintf(buf + len, size - len, "%s", spec);
+    }
+    if (n > 0) len += min((size_t) n, size - len - 1);
+  }
+  buf[len] = '\0';
+  return len;
+}
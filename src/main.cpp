@@ -20,14 +20,22 @@
 
 #include <FS.h>
 #include <LittleFS.h>
+#include <coredecls.h> // crc32
 
-#include <Ticker.h>
 #include <TFT_eSPI.h> // Hardware-specific library
 
 #include "Landasans36.h"
 #include "Landasans48.h"
+#include "glyphcache.h"
+#include "scheduler.h"
+#include "logring.h"
+#include "latency.h"
+#include "lineprotocol.h"
+#include "ntpclient.h"
 #define FONT_MIDDLE Landasans36
 #define FONT_LARGE Landasans48
+// all characters rendered with the smooth fonts
+#define FONT_CHARSET "0123456789+-.:°C%?"
 
 // +++++++++++++++++++
 const char COMPILE_INFO[] PROGMEM = {__DATE__ " " __TIME__ " - v2.1"};
@@ -38,9 +46,28 @@ const char COMPILE_INFO[] PROGMEM = {__DATE__ " " __TIME__ " - v2.1"};
 #define SENSORNODE_VERSION 1
 #endif
 
+// set SENSORNODE_DEEPSLEEP in platformio.ini, requires GPIO16 connected to RST
+#ifndef SENSORNODE_DEEPSLEEP
+#define SENSORNODE_DEEPSLEEP 0
+#endif
+
 #define DEFAULT_NODE_NAME "F42-NODE"
 #define MQTT_SERVER "mqtt.thomo.de"
 #define MY_NTP_SERVER "ntp.thomo.de"
+#define NTP_SYNC_SEC 1800
+// POSIX TZ rules, no timezone server lookup needed (Germany)
+#define DEFAULT_TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"
+// the weather leader publishes the parsed weather data retained on this topic
+#define WEATHER_SHARE_TOPIC "sensornode/weather"
+// shared weather data older than this many forecast cycles is stale
+#define WEATHER_SHARE_STALE_CYCLES 2
+// reconnect backoff, doubled after each failed attempt
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 120000
+// connecting to the broker blocks for at most this time
+#define MQTT_CONNECT_TIMEOUT_MS 2000
+// max. size of a received or a weather message
+#define MQTT_MESSAGE_SIZE 256
 
 #define DEFAULT_ROOT_TOPIC "tmp"
 
@@ -50,6 +77,12 @@ const char COMPILE_INFO[] PROGMEM = {__DATE__ " " __TIME__ " - v2.1"};
 
 #include "weather.h"
 #define DISP_GRID 0
+// the widest BMP drawBmp() can draw and its static pixel block (a 40x40 icon in one go)
+#define BMP_MAX_WIDTH 160
+#define BMP_BLOCK_PIXELS (40 * 40)
+// the widget sprite covers the largest widget area
+#define DISP_SPRITE_WIDTH 100
+#define DISP_SPRITE_HEIGHT 40
 
 
 // +++++++++++++++++++
@@ -86,6 +119,9 @@ const String CONFIG_FILE = "/config.cfg";
             do { if (MYDEBUG) Serial.printf(frmt, __VA_ARGS__); } while (0)
 
 // --- update cadence ---
+// seconds; 0 would make the task run on every pass
+#define MIN_CYCLE_SEC 1L
+#define MAX_CYCLE_SEC 65535L
 uint16_t updateSensorsTimeout = 30;
 uint16_t updateWeatherForecastTimeout = 5*60;
 
@@ -113,35 +149,84 @@ boolean hasDisplay = true;
 boolean hasDisplay = false;
 #endif
 TFT_eSPI tft = TFT_eSPI();
+TFT_eSprite widgetSprite = TFT_eSprite(&tft);
+GlyphCache largeGlyphs;
+GlyphCache middleGlyphs;
 
 // --- Network ---
 WiFiManager wifiManager;
 ESP8266WebServer espServer(80);
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
+unsigned long mqttNextAttempt = 0;
+uint32_t mqttBackoff = MQTT_BACKOFF_MIN_MS;
+uint16_t mqttFailures = 0;      // since the last connect
+uint32_t mqttConnects = 0;
+uint32_t mqttMissedValues = 0;  // not published while disconnected
 Timezone myTZ;
+String timezoneRules = DEFAULT_TIMEZONE;
+boolean timeSynced = false;
+NtpClient ntp;
 
-WeatherClient wc = WeatherClient(&espClient);
+WeatherClient wc;
+// one node fetches the weather data and shares it with all other nodes
+boolean weatherLeader = false;
+boolean wifiStaticIp = false; // reuse the last DHCP lease on a fast reconnect
+time_t sharedWeatherTime = 0; // fetch time (UTC) of the last shared weather data
 
 char webSendBuffer[SIZE_WEBSENDBUFFER] = "";
 
+// Change counter for /state: every change of the config, a sensor value or a
+// remote value gets the next version.
+uint32_t stateVersion = 1;
+uint32_t configVersion = 1;  // config and the sensor list
+uint32_t remotesVersion = 1; // remote values
+
+uint32_t nextStateVersion() {
+  return ++stateVersion;
+}
+
 String configHtml = "";
 String nodeName = DEFAULT_NODE_NAME;
 String rootTopic = DEFAULT_ROOT_TOPIC;
 float nodeAltitude = 282.0f;
 
 String showSensor = "";
-
+// source of the outdoor value on the display, OUTDOOR_OPENWEATHERMAP or a remote value
+#define OUTDOOR_OPENWEATHERMAP "owm"
+String showOutdoor = OUTDOOR_OPENWEATHERMAP;
+
+// values published by other nodes, received via MQTT subscription
+#define MAX_REMOTE_VALUES 4
+#define REMOTE_SOURCE_LENGTH 64
+struct RemoteValue {
+  char source[REMOTE_SOURCE_LENGTH]; // topic in dot notation, e.g. "home.outside.garden"
+  char topic[REMOTE_SOURCE_LENGTH];
+  char measurand[16];
+  char value[12];
+  unsigned long updated;
+};
+RemoteValue remotes[MAX_REMOTE_VALUES];
+
+// fixed buffers, so reading and publishing the sensors doesn't allocate
+#define SENSOR_ID_LENGTH 17        // DS18B20 address as hex
+#define SENSOR_TYPE_LENGTH 8       // "DS18B20"
+#define SENSOR_LOCATION_LENGTH 31
+#define ROOT_TOPIC_LENGTH 21       // 20 chars, as in the config form
+#define SENSOR_TOPIC_LENGTH (ROOT_TOPIC_LENGTH + SENSOR_LOCATION_LENGTH)
+#define SENSOR_MEASURAND_LENGTH 12 // "temperature"
+#define SENSOR_VALUE_LENGTH 12
 struct SensorData {
   bool enabled;
   DeviceAddress addr;
-  String id;
-  String type;
-  String location;
-  String topic;
-  String measurand;
-  String value;
+  char id[SENSOR_ID_LENGTH];
+  char type[SENSOR_TYPE_LENGTH];
+  char location[SENSOR_LOCATION_LENGTH];
+  char topic[SENSOR_TOPIC_LENGTH];
+  char measurand[SENSOR_MEASURAND_LENGTH];
+  char value[SENSOR_VALUE_LENGTH];
   float correction;
+  uint32_t version; // of the value
 };
 
 SensorData tmpSensor = { 
@@ -153,7 +238,8 @@ SensorData tmpSensor = {
   .topic="", 
   .measurand="", 
   .value="",
-  .correction=0.0f
+  .correction=0.0f,
+  .version=0
 };
 
 SensorData sensors[MAX_SENSORS]; 
@@ -163,40 +249,568 @@ SensorData sensors[MAX_SENSORS];
 #define LOGLEVEL_WARN 1
 #define LOGLEVEL_ERROR 0
 
-#define LOGLINE_LENGTH (128-3-1)
-struct LogLine {
-  uint8_t timestamp[3]; // hh|mm|ss
-  uint8_t level; // ERROR,WARN,INFO,DEBUG
-  char message[LOGLINE_LENGTH];
+// Records keep the PROGMEM format and the packed arguments, the text is only
+// formatted when it is read (web, serial).
+#define LOGLINE_LENGTH 160
+// 1 also prints each record to Serial, formatted when it is added
+#ifndef LOG_SERIAL
+#define LOG_SERIAL 0
+#endif
+LogRing logRing;
+
+// every module has its own level, set in the config dialog
+#define LOGMODULE_SYSTEM 0
+#define LOGMODULE_SENSOR 1
+#define LOGMODULE_MQTT 2
+#define LOGMODULE_WEB 3
+#define LOGMODULE_WIFI 4
+#define LOGMODULE_DISPLAY 5
+#define LOGMODULE_COUNT 6
+const char* const logModuleNames[LOGMODULE_COUNT] = { "system", "sensor", "mqtt", "web", "wifi", "display" };
+uint8_t logLevels[LOGMODULE_COUNT] = { LOGLEVEL_INFO, LOGLEVEL_INFO, LOGLEVEL_INFO, LOGLEVEL_INFO, LOGLEVEL_INFO, LOGLEVEL_INFO };
+
+// One per log_printf call: the same message again within the window is only
+// counted, the count is logged with the next different message or when the
+// window has passed.
+#define LOG_REPEAT_WINDOW_MS 300000
+struct LogSite {
+  PGM_P format;
+  uint32_t hash;   // of the arguments, the format is the same
+  uint32_t since;  // millis() of the last logged message
+  uint16_t repeated;
+  uint8_t level;
+  bool used;
+  LogSite *next;   // all used sites
 };
-// 1k = 8 lines
-char logbuf[LOGLINE_LENGTH];
-#define LOGLINE_CNT (8 * 5)
-LogLine logs[LOGLINE_CNT];
-int8_t lastLogLine = LOGLINE_CNT - 1;
-int32_t lastLogId = -1;
-
-void logPrefix(uint8_t level) {
-  ++lastLogLine;
-  ++lastLogId;
-  if (lastLogLine >= LOGLINE_CNT) lastLogLine = 0;
-  logs[lastLogLine].timestamp[0] = myTZ.hour();
-  logs[lastLogLine].timestamp[1] = myTZ.minute();
-  logs[lastLogLine].timestamp[2] = myTZ.second();
-  logs[lastLogLine].level = level;
-}
-
-void log(uint8_t level, const char *msg) {
-  logPrefix(level);  
-  Serial.println(msg);
-  strlcpy(logs[lastLogLine].message, msg, LOGLINE_LENGTH); 
-}
-
-void log(uint8_t level, const __FlashStringHelper *msg) {
-  logPrefix(level);  
-  Serial.println(msg);
-  strncpy_P(logs[lastLogLine].message, (const char *) msg, LOGLINE_LENGTH);
-  logs[lastLogLine].message[LOGLINE_LENGTH-1] = '\0';
+LogSite *logSites = nullptr;
+
+void mirrorLogRecord();
+
+void addLogRecord(uint8_t level, PGM_P format, const uint8_t *args, uint8_t argsLength) {
+  logRing.add(timeSynced ? UTC.now() : millis() / 1000, timeSynced, level, format, args, argsLength);
+  mirrorLogRecord();
+#if LOG_SERIAL
+  LogRecord rec;
+  char line[LOGLINE_LENGTH];
+  logRing.readLast(rec);
+  LogRing::format(rec, line, sizeof(line));
+  Serial.println(line);
+#endif
+}
+
+// format is PROGMEM, not filtered
+void logp(uint8_t level, PGM_P format, ...) {
+  uint8_t args[LOGRING_MAX_ARGS];
+  va_list list;
+  va_start(list, format);
+  uint8_t len = LogRing::pack(format, list, args);
+  va_end(list);
+  addLogRecord(level, format, args, len);
+}
+
+void logRepeated(LogSite &site) {
+  if (site.repeated > 0) {
+    logp(site.level, PSTR("'%S' repeated %u times"), site.format, site.repeated);
+    site.repeated = 0;
+  }
+}
+
+void logSite(LogSite &site, uint8_t level, PGM_P format, ...) {
+  uint8_t args[LOGRING_MAX_ARGS];
+  va_list list;
+  va_start(list, format);
+  uint8_t len = LogRing::pack(format, list, args);
+  va_end(list);
+
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (uint8_t i = 0; i < len; ++i) {
+    hash = (hash ^ args[i]) * 16777619u;
+  }
+  uint32_t now = millis();
+  if (site.used && site.hash == hash && now - site.since < LOG_REPEAT_WINDOW_MS) {
+    ++site.repeated;
+    return;
+  }
+
+  logRepeated(site);
+  if (!site.used) {
+    site.used = true;
+    site.next = logSites;
+    logSites = &site;
+  }
+  site.format = format;
+  site.hash = hash;
+  site.since = now;
+  site.level = level;
+  addLogRecord(level, format, args, len);
+}
+
+// log the counts of the sites whose window has passed
+void logRepeatedSites() {
+  uint32_t now = millis();
+  for (LogSite *site = logSites; site != nullptr; site = site->next) {
+    if (site->repeated > 0 && now - site->since >= LOG_REPEAT_WINDOW_MS) {
+      logRepeated(*site);
+    }
+  }
+}
+
+// Filtered by the level of the module, a filtered call costs one compare and
+// doesn't evaluate its arguments. format must be a string literal.
+#define log_printf(module, level, format, ...) do { \
+    if ((level) <= logLevels[module]) { \
+      static LogSite site; \
+      logSite(site, level, PSTR(format), ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+// NTP is synced the first time, fill in the time of all log lines written before
+void backfillLogTimes() {
+  logRing.backfillTime(UTC.now() - millis() / 1000);
+}
+// ------------------------------------------------------------------------------------------------
+
+// --- RTC memory ---
+// State that survives resets and deep sleep, but not a power loss.
+// The first 128 bytes of the RTC user memory are used by OTA.
+#define RTC_STATE_OFFSET 32 // in 4 byte blocks
+#define RTC_STATE_MAGIC 0x534E0002
+#define RTC_MAX_SENSORS 5
+#define RTC_NAME_LENGTH 21
+#define RTC_LOCATION_LENGTH 16
+#define RTC_QUEUE_SIZE 8
+
+struct RtcSensor {
+  uint8_t addr[8];  // DS18B20 address, the sensor id for all other sensors
+  char type[8];
+  char measurand;   // first letter of the measurand
+  uint8_t enabled;
+  int16_t correction; // 1/100
+  char location[RTC_LOCATION_LENGTH];
+};
+
+// the last good WiFi connection, used for a fast reconnect without scan and DHCP
+struct RtcWifi {
+  uint8_t valid;
+  uint8_t channel;
+  uint8_t bssid[6];
+  uint8_t staticIp; // the config, needed before LittleFS is read
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+};
+
+// heap low-water marks since power on and the last reset reasons
+#define RTC_RESET_REASONS 4
+#define RESTART_LOW_HEAP 1
+struct RtcHeap {
+  uint32_t minFreeHeap;
+  uint32_t minMaxBlock;
+  uint32_t minFreeStack;
+  uint8_t maxFragmentation;
+  uint8_t restartCause; // RESTART_*, set before a controlled restart
+  uint16_t bootCount;
+  uint8_t resetReasons[RTC_RESET_REASONS]; // REASON_*, the latest first
+};
+
+// a sample that could not be published yet
+struct RtcSample {
+  uint8_t sensor;
+  float value;
+};
+
+struct RtcState {
+  uint32_t magic;
+  uint32_t crc; // of everything behind this field
+  RtcWifi wifi;
+  RtcHeap heap;
+#if SENSORNODE_DEEPSLEEP
+  // deep sleep: config and sensors, so a wake up doesn't need LittleFS and sensor discovery
+  uint8_t hasConfig;
+  uint8_t sensorCount;
+  uint16_t sensorsTimeout;
+  float altitude;
+  char nodeName[RTC_NAME_LENGTH];
+  char rootTopic[RTC_NAME_LENGTH];
+  RtcSensor sensors[RTC_MAX_SENSORS];
+  uint8_t queueCount;
+  RtcSample queue[RTC_QUEUE_SIZE];
+#endif
+};
+static_assert(sizeof(RtcState) <= 512 - RTC_STATE_OFFSET * 4, "RtcState doesn't fit into the RTC user memory");
+RtcState rtcState;
+
+uint32_t rtcStateCrc() {
+  return crc32((uint8_t *) &rtcState + 2 * sizeof(uint32_t), sizeof(RtcState) - 2 * sizeof(uint32_t));
+}
+
+// returns false and resets rtcState if the RTC memory holds no valid state
+bool readRtcState() {
+  ESP.rtcUserMemoryRead(RTC_STATE_OFFSET, (uint32_t *) &rtcState, sizeof(RtcState));
+  if (rtcState.magic == RTC_STATE_MAGIC && rtcState.crc == rtcStateCrc()) {
+    return true;
+  }
+  memset(&rtcState, 0, sizeof(RtcState));
+  rtcState.magic = RTC_STATE_MAGIC;
+  return false;
+}
+
+void writeRtcState() {
+  rtcState.crc = rtcStateCrc();
+  ESP.rtcUserMemoryWrite(RTC_STATE_OFFSET, (uint32_t *) &rtcState, sizeof(RtcState));
+}
+
+// The log records not yet flushed to LittleFS, in the RTC memory behind the
+// state, so they survive a watchdog or exception reset. The records are stored
+// as in the log ring, their formats are only valid for the same firmware.
+#if SENSORNODE_DEEPSLEEP
+// A deep sleep build keeps its config in the RTC memory, no record fits behind it.
+void clearRtcLog(uint32_t nextId) {}
+void moveRtcLogIds(uint32_t offset) {}
+void mirrorLogRecord() {}
+bool restoreRtcLog() { return false; }
+#else
+#define RTC_LOG_MAGIC 0x534C0002
+#define RTC_LOG_OFFSET (RTC_STATE_OFFSET + sizeof(RtcState) / 4)
+#define RTC_LOG_HEADER 16
+#define RTC_LOG_SIZE (512 - RTC_LOG_OFFSET * 4 - RTC_LOG_HEADER)
+
+struct RtcLog {
+  uint32_t magic;
+  uint32_t build; // firmwareId()
+  uint32_t firstId;
+  uint16_t used;
+  uint16_t count;
+  uint8_t data[RTC_LOG_SIZE];
+};
+static_assert(sizeof(RtcState) % 4 == 0 && sizeof(RtcLog) == RTC_LOG_HEADER + RTC_LOG_SIZE, "RtcLog must follow RtcState");
+RtcLog rtcLog;
+
+// The build: a hash of the compile time and the address of COMPILE_INFO, it
+// moves with the other PROGMEM strings when any code changes.
+uint32_t firmwareId() {
+  char info[sizeof(COMPILE_INFO)];
+  strcpy_P(info, COMPILE_INFO);
+  return crc32(info, strlen(info)) ^ (uint32_t) (uintptr_t) COMPILE_INFO;
+}
+
+void writeRtcLog() {
+  // only the used part
+  ESP.rtcUserMemoryWrite(RTC_LOG_OFFSET, (uint32_t *) &rtcLog, (RTC_LOG_HEADER + rtcLog.used + 3) & ~3);
+}
+
+void clearRtcLog(uint32_t nextId) {
+  rtcLog.magic = RTC_LOG_MAGIC;
+  rtcLog.build = firmwareId();
+  rtcLog.firstId = nextId;
+  rtcLog.used = 0;
+  rtcLog.count = 0;
+  writeRtcLog();
+}
+
+// copy the newest log record, drop the oldest ones if it is full
+void mirrorLogRecord() {
+  if (rtcLog.magic != RTC_LOG_MAGIC) return; // not restored yet
+  const uint8_t *raw = logRing.getLastRaw();
+  uint8_t len = raw[0];
+  if (len > RTC_LOG_SIZE) return;
+
+  if (rtcLog.count == 0) {
+    rtcLog.firstId = logRing.getNextId() - 1;
+  }
+  while (rtcLog.used + len > RTC_LOG_SIZE) {
+    uint8_t oldest = rtcLog.data[0];
+    rtcLog.used -= oldest;
+    memmove(rtcLog.data, rtcLog.data + oldest, rtcLog.used);
+    --rtcLog.count;
+    ++rtcLog.firstId;
+  }
+  memcpy(rtcLog.data + rtcLog.used, raw, len);
+  rtcLog.used += len;
+  ++rtcLog.count;
+  writeRtcLog();
+}
+
+// put the records of the last run back into the log ring, returns false if there are none
+bool restoreRtcLog() {
+  ESP.rtcUserMemoryRead(RTC_LOG_OFFSET, (uint32_t *) &rtcLog, sizeof(RtcLog));
+  bool valid = rtcLog.magic == RTC_LOG_MAGIC && rtcLog.build == firmwareId() && rtcLog.used <= RTC_LOG_SIZE;
+  uint16_t pos = 0;
+  for (uint16_t i = 0; valid && i < rtcLog.count; ++i) {
+    valid = pos + LOGRING_HEADER <= rtcLog.used && rtcLog.data[pos] >= LOGRING_HEADER;
+    pos += rtcLog.data[pos];
+  }
+  if (!valid || pos != rtcLog.used) {
+    clearRtcLog(logRing.getNextId());
+    return false;
+  }
+
+  logRing.setFirstId(rtcLog.firstId);
+  for (pos = 0; pos < rtcLog.used; pos += rtcLog.data[pos]) {
+    logRing.addRaw(rtcLog.data + pos);
+  }
+  return true;
+}
+
+// the ids of the log ring moved by offset
+void moveRtcLogIds(uint32_t offset) {
+  rtcLog.firstId += offset;
+  writeRtcLog();
+}
+#endif
+
+const char* resetReasonName(uint8_t reason) {
+  switch (reason) {
+    case REASON_DEFAULT_RST: return "power on";
+    case REASON_WDT_RST: return "hardware watchdog";
+    case REASON_EXCEPTION_RST: return "exception";
+    case REASON_SOFT_WDT_RST: return "software watchdog";
+    case REASON_SOFT_RESTART: return "restart";
+    case REASON_DEEP_SLEEP_AWAKE: return "deep sleep";
+    case REASON_EXT_SYS_RST: return "reset pin";
+    default: return "unknown";
+  }
+}
+
+// count the boot and keep its reset reason, called once in setup()
+void recordBoot() {
+  RtcHeap &rh = rtcState.heap;
+  uint8_t reason = ESP.getResetInfoPtr()->reason;
+  ++rh.bootCount;
+  memmove(&rh.resetReasons[1], &rh.resetReasons[0], RTC_RESET_REASONS - 1);
+  rh.resetReasons[0] = reason;
+
+  uint8_t level = reason == REASON_DEFAULT_RST || reason == REASON_SOFT_RESTART || reason == REASON_EXT_SYS_RST ? LOGLEVEL_INFO : LOGLEVEL_WARN;
+  log_printf(LOGMODULE_SYSTEM, level, "Boot %u, reset reason: %s%s", rh.bootCount, resetReasonName(reason),
+    rh.restartCause == RESTART_LOW_HEAP ? " (low heap)" : "");
+  rh.restartCause = 0;
+  writeRtcState();
+}
+
+// --- log file ---
+// The log records are appended in batches to a LittleFS file, one line per
+// record: "<id> <time> <synced> <level> <message>". A full file is rotated,
+// the previous one is kept.
+#define LOGFILE "/log.txt"
+#define LOGFILE_OLD "/log.1.txt"
+#define LOGFILE_MAX_SIZE 16384
+#define LOGFILE_FLUSH_SEC 60
+uint32_t logFlushedId = 0; // the next record to write
+bool logIdsRestored = false;
+
+void setLogFirstId(uint32_t id) {
+  uint32_t offset = id - logRing.getFirstId();
+  logRing.setFirstId(id);
+  logFlushedId += offset;
+  moveRtcLogIds(offset);
+}
+
+// the id of the last record in the file, -1 if there is none
+int32_t readLastLogFileId(const char *filename) {
+  File f = LittleFS.open(filename, "r");
+  if (!f) return -1;
+
+  char buf[LOGLINE_LENGTH + 32];
+  size_t size = f.size();
+  size_t start = size > sizeof(buf) - 1 ? size - (sizeof(buf) - 1) : 0;
+  f.seek(start);
+  size_t len = f.read((uint8_t *) buf, sizeof(buf) - 1);
+  f.close();
+  buf[len] = '\0';
+  // the start of the last line
+  while (len > 0 && buf[len - 1] == '\n') buf[--len] = '\0';
+  char *line = strrchr(buf, '\n');
+  if (line == nullptr) {
+    if (start > 0 || len == 0) return -1;
+    line = buf;
+  } else {
+    ++line;
+  }
+  return (int32_t) strtoul(line, nullptr, 10);
+}
+
+// continue the ids of the file if the RTC memory had none, LittleFS must be mounted
+void initLogFile() {
+  if (logIdsRestored) return;
+  int32_t lastId = readLastLogFileId(LOGFILE);
+  if (lastId < 0) lastId = readLastLogFileId(LOGFILE_OLD);
+  if (lastId >= 0) {
+    setLogFirstId(lastId + 1);
+  }
+  logIdsRestored = true;
+}
+
+void flushLogFile() {
+  if (logFlushedId == logRing.getNextId()) return;
+  if (!LittleFS.begin()) return;
+
+  File f = LittleFS.open(LOGFILE, "a");
+  if (f) {
+    char line[LOGLINE_LENGTH + 32];
+    LogCursor cursor = logRing.begin();
+    LogRecord rec;
+    while (logRing.read(cursor, rec)) {
+      if (rec.id < logFlushedId) continue;
+      size_t len = snprintf(line, sizeof(line), "%lu %lu %u %u ", (unsigned long) rec.id, (unsigned long) rec.time, rec.synced, rec.level);
+      len += LogRing::format(rec, line + len, sizeof(line) - len - 1);
+      line[len++] = '\n';
+      f.write((const uint8_t *) line, len);
+    }
+    bool full = f.size() >= LOGFILE_MAX_SIZE;
+    f.close();
+    if (full) {
+      LittleFS.remove(LOGFILE_OLD);
+      LittleFS.rename(LOGFILE, LOGFILE_OLD);
+    }
+    logFlushedId = logRing.getNextId();
+    clearRtcLog(logFlushedId);
+  }
+  LittleFS.end();
+}
+
+// --- syslog ---
+// The log records are sent via UDP to a collector, every few seconds all new
+// ones: as RFC 5424 syslog messages, one per datagram (RFC 5426), or as plain
+// lines "<node> <level> <message>" packed into datagrams. The log ring is the
+// queue, at most SYSLOG_QUEUE_MAX records are pending, older ones are dropped.
+#define SYSLOG_DEFAULT_PORT 514
+#define SYSLOG_FLUSH_SEC 5
+#define SYSLOG_QUEUE_MAX 64
+#define SYSLOG_DATAGRAM_SIZE 1024
+#define SYSLOG_FACILITY 16 // local0
+WiFiUDP syslogUdp;
+String syslogServer = "";   // host[:port], empty = off
+boolean syslogPlain = false;
+IPAddress syslogIp;         // of syslogServer, resolved once
+uint16_t syslogPort = 0;    // 0 = not resolved yet
+uint32_t syslogSentId = 0;  // the next record to send, set in setup()
+uint32_t syslogSent = 0;
+uint32_t syslogDropped = 0;
+
+const char* logLevelName(uint8_t level) {
+  switch (level) {
+    case LOGLEVEL_ERROR: return "ERROR";
+    case LOGLEVEL_WARN: return "WARN";
+    case LOGLEVEL_INFO: return "INFO";
+    default: return "DEBUG";
+  }
+}
+
+uint8_t syslogSeverity(uint8_t level) {
+  switch (level) {
+    case LOGLEVEL_ERROR: return 3;
+    case LOGLEVEL_WARN: return 4;
+    case LOGLEVEL_INFO: return 6;
+    default: return 7;
+  }
+}
+
+size_t formatSyslogRecord(const LogRecord &rec, char *buf, size_t size) {
+  int len;
+  if (syslogPlain) {
+    len = snprintf(buf, size, "%s %s ", nodeName.c_str(), logLevelName(rec.level));
+  } else {
+    // 20 characters, the compiler assumes up to 5 digit years and 3 digit fields
+    char tstamp[28] = "-";
+    if (rec.synced) {
+      time_t t = rec.time;
+      snprintf(tstamp, sizeof(tstamp), "%04u-%02u-%02uT%02u:%02u:%02uZ",
+        UTC.year(t), UTC.month(t), UTC.day(t), UTC.hour(t), UTC.minute(t), UTC.second(t));
+    }
+    len = snprintf(buf, size, "<%u>1 %s %s sensornode - - - ",
+      SYSLOG_FACILITY * 8 + syslogSeverity(rec.level), tstamp, nodeName.c_str());
+  }
+  size_t used = min((size_t) max(len, 0), size - 1);
+  return used + LogRing::format(rec, buf + used, size - used);
+}
+
+void setSyslogServer(const String &server) {
+  syslogServer = server;
+  syslogPort = 0;
+}
+
+// a failed lookup is retried with the next flush
+bool resolveSyslogServer() {
+  if (syslogPort != 0) return true;
+  char host[64];
+  strlcpy(host, syslogServer.c_str(), sizeof(host));
+  char *colon = strchr(host, ':');
+  uint16_t port = SYSLOG_DEFAULT_PORT;
+  if (colon != nullptr) {
+    *colon = '\0';
+    port = atoi(colon + 1);
+  }
+  if (port == 0 || !WiFi.hostByName(host, syslogIp)) return false;
+  syslogPort = port;
+  return true;
+}
+
+void syslogTask() {
+  if (syslogServer.length() == 0 || WiFi.status() != WL_CONNECTED) return;
+
+  uint32_t nextId = logRing.getNextId();
+  uint32_t oldest = max(logRing.getFirstId(), nextId > SYSLOG_QUEUE_MAX ? nextId - SYSLOG_QUEUE_MAX : 0);
+  if (syslogSentId < oldest) {
+    syslogDropped += oldest - syslogSentId;
+    syslogSentId = oldest;
+  }
+  if (syslogSentId == nextId) return;
+
+  if (!resolveSyslogServer()) return;
+
+  char line[LOGLINE_LENGTH + 64];
+  size_t datagram = 0; // bytes in the open datagram
+  LogCursor cursor = logRing.begin();
+  LogRecord rec;
+  while (logRing.read(cursor, rec)) {
+    if (rec.id < syslogSentId) continue;
+
+    size_t len = formatSyslogRecord(rec, line, sizeof(line));
+    if (syslogPlain) {
+      if (datagram > 0 && datagram + len + 1 > SYSLOG_DATAGRAM_SIZE) {
+        syslogUdp.endPacket();
+        datagram = 0;
+      }
+      if (datagram == 0) {
+        syslogUdp.beginPacket(syslogIp, syslogPort);
+      }
+      line[len++] = '\n';
+      syslogUdp.write((const uint8_t *) line, len);
+      datagram += len;
+    } else {
+      syslogUdp.beginPacket(syslogIp, syslogPort);
+      syslogUdp.write((const uint8_t *) line, len);
+      syslogUdp.endPacket();
+    }
+    ++syslogSent;
+  }
+  if (datagram > 0) {
+    syslogUdp.endPacket();
+  }
+  syslogSentId = nextId;
+}
+// ------------------------------------------------------------------------------------------------
+
+// --- Display statistics ---
+// Pixels written to the panel over SPI, 2 bytes per pixel. A window is one
+// address window setup (fillRect, pushImage, pushSprite). The direct drawing
+// fallback without sprite only counts the cleared areas, not the glyphs.
+struct DisplayStats {
+  uint32_t frames;     // display() calls
+  uint32_t bytes;
+  uint32_t windows;
+  uint32_t lastBytes;  // of the last frame
+  uint16_t lastWindows;
+  uint8_t lastWidgets; // redrawn widgets
+};
+DisplayStats displayStats;
+
+void countPanelWrite(TFT_eSPI &canvas, int32_t w, int32_t h) {
+  if (&canvas != &tft) return; // a sprite, drawing is in memory
+  displayStats.lastBytes += w * h * 2;
+  ++displayStats.lastWindows;
 }
 // ------------------------------------------------------------------------------------------------
 
@@ -223,7 +837,7 @@ void drawBmp(TFT_eSPI &tft, const char *filename, int16_t x, int16_t y) {
   if (LittleFS.begin()) {
     // debug_println("Init LittleFS - successful.");
   } else {
-    Serial.println(F("Error while init LittleFS."));
+    log_printf(LOGMODULE_DISPLAY, LOGLEVEL_ERROR, "Error while init LittleFS.");
     return;
   }
 
@@ -231,7 +845,7 @@ void drawBmp(TFT_eSPI &tft, const char *filename, int16_t x, int16_t y) {
   bmpFS = LittleFS.open(filename, "r");
 
   if (!bmpFS) {
-    Serial.printf("File not found: %s\n", filename);
+    log_printf(LOGMODULE_DISPLAY, LOGLEVEL_ERROR, "File not found: %s", filename);
     return;
   }
 
@@ -257,9 +871,9 @@ void drawBmp(TFT_eSPI &tft, const char *filename, int16_t x, int16_t y) {
       Serial.printf("Compression not supported: %d\n", i);
       Serial.println("BMP format not recognized.");
 
+    } else if (w == 0 || w > BMP_MAX_WIDTH) {
+      log_printf(LOGMODULE_DISPLAY, LOGLEVEL_ERROR, "BMP too wide: %s", filename);
     } else {
-      y += h - 1;
-
       bool oldSwapBytes = tft.getSwapBytes();
       tft.setSwapBytes(true);
       bmpFS.seek(seekOffset);
@@ -267,24 +881,32 @@ void drawBmp(TFT_eSPI &tft, const char *filename, int16_t x, int16_t y) {
       uint16_t padding = (4 - ((w * 3) & 3)) & 3;
       uint8_t lineBuffer[w * 3 + padding];
 
-      for (row = 0; row < h; row++)
-      {
-
-        bmpFS.read(lineBuffer, sizeof(lineBuffer));
-        uint8_t *bptr = lineBuffer;
-        uint16_t *tptr = (uint16_t *)lineBuffer;
-        // Convert 24 to 16 bit colours
-        for (uint16_t col = 0; col < w; col++)
-        {
-          b = *bptr++;
-          g = *bptr++;
-          r = *bptr++;
-          *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+      // convert the image in as few blocks as fit into the static block,
+      // an icon is pushed as one
+      static uint16_t block[BMP_BLOCK_PIXELS];
+      uint16_t blockRows = BMP_BLOCK_PIXELS / w;
+      // y is the bottom line as the BMP image is stored bottom up
+      y += h - 1;
+      row = 0;
+      while (row < h) {
+        uint16_t rows = min(blockRows, (uint16_t)(h - row));
+        for (uint16_t line = 0; line < rows; ++line) {
+          bmpFS.read(lineBuffer, sizeof(lineBuffer));
+          uint8_t *bptr = lineBuffer;
+          uint16_t *tptr = block + (rows - 1 - line) * w;
+          // Convert 24 to 16 bit colours
+          for (uint16_t col = 0; col < w; col++)
+          {
+            b = *bptr++;
+            g = *bptr++;
+            r = *bptr++;
+            *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+          }
         }
-
-        // Push the pixel row to screen, pushImage will crop the line if needed
-        // y is decremented as the BMP image is drawn bottom up
-        tft.pushImage(x, y--, w, 1, (uint16_t *)lineBuffer);
+        row += rows;
+        // pushImage will crop the block if needed
+        tft.pushImage(x, y - row + 1, w, rows, block);
+        countPanelWrite(tft, w, rows);
       }
       tft.setSwapBytes(oldSwapBytes);
       // Serial.print("Loaded in "); Serial.print(millis() - startTime);
@@ -297,60 +919,178 @@ void drawBmp(TFT_eSPI &tft, const char *filename, int16_t x, int16_t y) {
   LittleFS.end();
 }
 
+// --- retained display model ---
+// Each widget remembers what is currently shown on the panel and is only
+// redrawn when its rendered content changes.
+#define DISP_ICON_LENGTH 16
+struct DisplayModel {
+  bool valid; // false -> next display() repaints the whole screen
+  char outIcon[DISP_ICON_LENGTH];
+  char outTemp[9];
+  char inVal[9];
+  char timebuf[6];
+  char datebuf[7];
+};
+DisplayModel shown = { .valid = false, .outIcon = "", .outTemp = "", .inVal = "", .timebuf = "", .datebuf = "" };
+
+// screen area of a widget, covers the glyph extents of the rendered text
+struct DisplayArea {
+  int16_t x, y, w, h;
+};
+const DisplayArea DISP_ICON_AREA    = { 10,   4,  40,  40};
+const DisplayArea DISP_OUTTEMP_AREA = { 50,  14, 100,  37};
+const DisplayArea DISP_INVAL_AREA   = { 50,  60, 100,  37};
+const DisplayArea DISP_TIME_AREA    = { 10, 103,  60,  25};
+const DisplayArea DISP_DATE_AREA    = { 90, 103,  70,  25};
+
+bool isWidgetChanged(char *shownValue, const char *value, size_t size) {
+  if (shown.valid && strcmp(shownValue, value) == 0) return false;
+  strlcpy(shownValue, value, size);
+  return true;
+}
+
+void clearArea(TFT_eSPI &tft, const DisplayArea &area) {
+  tft.fillRect(area.x, area.y, area.w, area.h, TFT_WHITE);
+  countPanelWrite(tft, area.w, area.h);
+}
+
+// x0/y0 is the screen position of the canvas origin
+void drawSeparator(TFT_eSPI &canvas, int16_t x0, int16_t y0) {
+  canvas.drawLine(15 - x0, 92 - y0, 144 - x0, 92 - y0, TFT_BLUE);
+  canvas.drawLine(15 - x0, 93 - y0, 144 - x0, 93 - y0, TFT_BLUE);
+}
+
+
+typedef void (*WidgetRenderer)(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *value);
+
+void renderIcon(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *icon) {
+  drawBmp(canvas, icon, 11 - x0, 5 - y0);
+}
+
+void renderOutTemp(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *outTemp) {
+  largeGlyphs.drawString(canvas, outTemp, 150 - x0, 7 - y0, TR_DATUM);
+}
+
+void renderInVal(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *inVal) {
+  // the separator runs through the lower part of the value area
+  drawSeparator(canvas, x0, y0);
+  largeGlyphs.drawString(canvas, inVal, 150 - x0, 53 - y0, TR_DATUM);
+}
+
+void renderTime(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *timebuf) {
+  middleGlyphs.drawString(canvas, timebuf, 70 - x0, 98 - y0, TR_DATUM);
+}
+
+void renderDate(TFT_eSPI &canvas, int16_t x0, int16_t y0, const char *datebuf) {
+  middleGlyphs.drawString(canvas, datebuf, 90 - x0, 98 - y0, TL_DATUM);
+}
+
+// Render a widget into the off-screen sprite and push its area to the panel
+// as one block. The sprite is created once by setupDisplay(), if the heap was
+// too short for it the widget is drawn straight to the panel.
+void renderWidget(TFT_eSPI &tft, const DisplayArea &area, WidgetRenderer render, const char *value) {
+  if (widgetSprite.created()) {
+    widgetSprite.fillRect(0, 0, area.w, area.h, TFT_WHITE);
+    render(widgetSprite, area.x, area.y, value);
+    widgetSprite.pushSprite(area.x, area.y, 0, 0, area.w, area.h);
+    countPanelWrite(tft, area.w, area.h);
+  } else {
+    clearArea(tft, area);
+    render(tft, 0, 0, value);
+  }
+}
+
 void display(TFT_eSPI &tft, const char* inTemp, const char* outTemp, const char* icon, const char* timebuf, const char* datebuf) {
-  tft.fillScreen(TFT_WHITE);
+  bool fullRedraw = !shown.valid;
+  bool iconChanged = isWidgetChanged(shown.outIcon, icon, sizeof(shown.outIcon));
+  bool outTempChanged = isWidgetChanged(shown.outTemp, outTemp, sizeof(shown.outTemp));
+  bool inValChanged = isWidgetChanged(shown.inVal, inTemp, sizeof(shown.inVal));
+  bool timeChanged = isWidgetChanged(shown.timebuf, timebuf, sizeof(shown.timebuf));
+  bool dateChanged = isWidgetChanged(shown.datebuf, datebuf, sizeof(shown.datebuf));
+  shown.valid = true;
+  displayStats.lastBytes = 0;
+  displayStats.lastWindows = 0;
+  displayStats.lastWidgets = iconChanged + outTempChanged + inValChanged + timeChanged + dateChanged;
+
   tft.setTextSize(1);
   tft.setTextColor(TFT_BLACK);
 
-  if (DISP_GRID) {
-    int incr = 10;
-    for (int i = 0; i < 128; i = i + incr)
-    {
-      tft.drawLine(0, i, 159, i, TFT_GREEN);
-    }
-    for (int i = 0; i < 160; i = i + incr)
-    {
-      tft.drawLine(i, 0, i, 127, TFT_GREEN);
-    }
+  if (fullRedraw) {
+    tft.fillScreen(TFT_WHITE);
+    countPanelWrite(tft, tft.width(), tft.height());
 
-    int d = 38;
-    tft.drawRect(10,  4, d, d, TFT_RED);
-    tft.drawRect(10, 50, d, d, TFT_RED);
+    if (DISP_GRID) {
+      int incr = 10;
+      for (int i = 0; i < 128; i = i + incr)
+      {
+        tft.drawLine(0, i, 159, i, TFT_GREEN);
+      }
+      for (int i = 0; i < 160; i = i + incr)
+      {
+        tft.drawLine(i, 0, i, 127, TFT_GREEN);
+      }
 
-    tft.drawRect(50,  4, 100, d, TFT_RED);
-    tft.drawRect(50, 50, 100, d, TFT_RED);
+      int d = 38;
+      tft.drawRect(10,  4, d, d, TFT_RED);
+      tft.drawRect(10, 50, d, d, TFT_RED);
 
-    tft.drawRect(10, 100, 60, 22, TFT_RED);
-    tft.drawRect(90, 100, 60, 22, TFT_RED);
+      tft.drawRect(50,  4, 100, d, TFT_RED);
+      tft.drawRect(50, 50, 100, d, TFT_RED);
 
-  }
-
-  drawBmp(tft, icon, 11, 5);
-  drawBmp(tft, "in_d.bmp",  12, 53);
+      tft.drawRect(10, 100, 60, 22, TFT_RED);
+      tft.drawRect(90, 100, 60, 22, TFT_RED);
+    }
 
-  tft.drawLine(15, 92, 144, 92, TFT_BLUE);
-  tft.drawLine(15, 93, 144, 93, TFT_BLUE);
+    drawBmp(tft, "in_d.bmp",  12, 53);
+    drawSeparator(tft, 0, 0);
+  }
 
-  tft.loadFont(FONT_LARGE);
-  tft.setTextDatum(TR_DATUM);
-  tft.drawString(outTemp, 150,  7);
-  tft.drawString(inTemp,  150, 53);
-  tft.unloadFont();
+  if (iconChanged) renderWidget(tft, DISP_ICON_AREA, renderIcon, icon);
+  if (outTempChanged) renderWidget(tft, DISP_OUTTEMP_AREA, renderOutTemp, outTemp);
+  if (inValChanged) renderWidget(tft, DISP_INVAL_AREA, renderInVal, inTemp);
+  if (timeChanged) renderWidget(tft, DISP_TIME_AREA, renderTime, timebuf);
+  if (dateChanged) renderWidget(tft, DISP_DATE_AREA, renderDate, datebuf);
 
-  tft.loadFont(FONT_MIDDLE);
-  tft.drawString(timebuf, 70, 98);
-  tft.setTextDatum(TL_DATUM);
-  tft.drawString(datebuf, 90, 98);
-  tft.unloadFont();
+  ++displayStats.frames;
+  displayStats.bytes += displayStats.lastBytes;
+  displayStats.windows += displayStats.lastWindows;
 }
 
 void update();
 void fetchWeatherData();
+bool isSharedWeatherFresh();
 void setupDisplay();
 void updateDisplay();
 
-Ticker timer1(update, updateSensorsTimeout * 1000);
-Ticker timer2(fetchWeatherData, updateWeatherForecastTimeout * 1000);
+Scheduler scheduler;
+int8_t sensorTask = -1;
+int8_t weatherTask = -1;
+
+// --- Latency statistics ---
+// the tasks have their own histograms, these are the parts of update() and the whole loop() pass
+#define STATS_PUBLISH_CYCLE_SEC 300
+enum LatencySection { SECTION_LOOP, SECTION_FETCH, SECTION_PUBLISH, SECTION_DISPLAY, SECTION_COUNT };
+const char* sectionNames[SECTION_COUNT] = { "loop", "fetchSensorValues", "sendMQTTData", "updateDisplay" };
+LatencyHistogram sectionLatency[SECTION_COUNT];
+boolean publishStats = false;
+
+// --- Heap telemetry ---
+#define HEAP_SAMPLE_CYCLE_MS 1000
+#define DEFAULT_HEAP_LIMIT 4096
+// a limit near the free heap of a running node would restart it over and over
+#define HEAP_LIMIT_MAX_PERCENT 50
+// restart before the allocator fails, 0 = never
+uint32_t heapLimit = DEFAULT_HEAP_LIMIT;
+uint32_t bootFreeHeap = 0; // at the end of setup()
+// low-water marks since boot
+uint32_t minFreeHeap = UINT32_MAX;
+uint32_t minMaxBlock = UINT32_MAX;
+uint8_t maxFragmentation = 0;
+
+// the highest heap limit that is applied
+uint32_t maxHeapLimit() {
+  return (bootFreeHeap > 0 ? bootFreeHeap : ESP.getFreeHeap()) / 100 * HEAP_LIMIT_MAX_PERCENT;
+}
 
 void addr2hex(const uint8_t* da, char hex[17]) {
   snprintf(hex, 17, "%02X%02X%02X%02X%02X%02X%02X%02X", da[0], da[1], da[2], da[3], da[4], da[5], da[6], da[7]);
@@ -358,80 +1098,237 @@ void addr2hex(const uint8_t* da, char hex[17]) {
 
 uint8_t numberOfSensors() {
   uint8_t idx = 0;
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {++idx;}
+  while (idx < MAX_SENSORS && sensors[idx].id[0] != '\0') {++idx;}
   return idx;
 }
 
-void addSensor(const String& id, const String& type, const String& measurand) {
-  uint8_t idx = 0;
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {++idx;}
+void addSensor(const char *id, const char *type, const char *measurand) {
+  uint8_t idx = numberOfSensors();
   if (idx < MAX_SENSORS) {
     sensors[idx].enabled = false;
-    sensors[idx].id = id;
-    sensors[idx].type = type;
-    sensors[idx].location = id;
-    sensors[idx].topic = id;
-    sensors[idx].measurand = measurand;
-    sensors[idx].value = "?";
-    debug_println("Add "+type+" sensor("+id+")");
+    strlcpy(sensors[idx].id, id, SENSOR_ID_LENGTH);
+    strlcpy(sensors[idx].type, type, SENSOR_TYPE_LENGTH);
+    strlcpy(sensors[idx].location, id, SENSOR_LOCATION_LENGTH);
+    strlcpy(sensors[idx].topic, id, SENSOR_TOPIC_LENGTH);
+    strlcpy(sensors[idx].measurand, measurand, SENSOR_MEASURAND_LENGTH);
+    strcpy(sensors[idx].value, "?");
+    configVersion = nextStateVersion();
+    debug_printf("Add %s sensor(%s)\n", type, id);
   }
 }
 
-String getSensorLocation(const String& id) {
-  uint8_t idx = 0;
-  while (!sensors[idx].id.equals(id) && idx < MAX_SENSORS) {++idx;}
-  return (idx < MAX_SENSORS) ? sensors[idx].location : ""; 
+// an I2C sensor, the id is the address and the first letter of the measurand
+void addSensor(const String& addr, const char *type, const char *measurand) {
+  char id[SENSOR_ID_LENGTH];
+  snprintf(id, SENSOR_ID_LENGTH, "%s%c", addr.c_str(), measurand[0]);
+  addSensor(id, type, measurand);
 }
 
-SensorData& getSensorData(const String& id) {
+// MAX_SENSORS if there is no such sensor
+uint8_t sensorIndex(const char *id) {
   uint8_t idx = 0;
-  while (!sensors[idx].id.equals(id) && idx < MAX_SENSORS) {++idx;}
+  while (idx < MAX_SENSORS && strcmp(sensors[idx].id, id) != 0) {++idx;}
+  return idx;
+}
+
+SensorData& getSensorData(const char *id) {
+  uint8_t idx = sensorIndex(id);
   return idx < MAX_SENSORS ? sensors[idx] : tmpSensor;
 }
 
-void updateSensorTopic(const String& id) {
-  getSensorData(id).topic = rootTopic + "." + getSensorData(id).location;
-  getSensorData(id).topic.replace(".", "/");
-  debug_println("-> Sensor("+id+").topic = '"+getSensorData(id).topic+"'");
+SensorData& getSensorData(const String& id) {
+  return getSensorData(id.c_str());
+}
+
+void updateSensorTopic(SensorData &sd) {
+  snprintf(sd.topic, SENSOR_TOPIC_LENGTH, "%s.%s", rootTopic.c_str(), sd.location);
+  for (char *c = sd.topic; *c != '\0'; ++c) {
+    if (*c == '.') *c = '/';
+  }
+  debug_printf("-> Sensor(%s).topic = '%s'\n", sd.id, sd.topic);
 }
 
 void updateSensorTopics() {
-  uint8_t idx = 0;
   debug_println("Update sensor topics with rootTopic: " + rootTopic);
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {
-    updateSensorTopic(sensors[idx].id);
-    ++idx;
+  for (uint8_t idx = 0; idx < numberOfSensors(); ++idx) {
+    updateSensorTopic(sensors[idx]);
+  }
+}
+
+// --- Capture ---
+// Raw, uncorrected readings are appended to CAPTURE_FILE or published to MQTT, so
+// the processing can be tuned offline on real traces (tools/replay). Format (little endian):
+//   "SNC1", uint8 sensor count, per sensor: id[17], measurand[12], float correction
+//   then per reading: uint32 time, uint8 sensor index (| CAPTURE_UPTIME), float raw value
+// The sensor table is repeated after a boot and when the config changed.
+// Over MQTT the sensor table is published retained to <topic>/<node>/capture/sensors
+// and the readings of each cycle to <topic>/<node>/capture/data, so the messages of
+// `mosquitto_sub -N -t '<topic>/<node>/capture/#'` make up a capture file.
+#define CAPTURE_FILE "/capture.bin"
+#define CAPTURE_MAGIC "SNC1"
+#define CAPTURE_MAX_SIZE (64 * 1024)
+#define CAPTURE_UPTIME 0x80 // the time is the uptime in seconds, NTP was not synced yet
+struct __attribute__((packed)) CaptureSensor {
+  char id[SENSOR_ID_LENGTH];
+  char measurand[SENSOR_MEASURAND_LENGTH];
+  float correction;
+};
+struct __attribute__((packed)) CaptureRecord {
+  uint32_t time;
+  uint8_t sensor;
+  float raw;
+};
+boolean captureEnabled = false;
+boolean captureMqtt = false; // publish instead of writing CAPTURE_FILE
+bool captureTableDue = true; // the sensor table has to be written before the next readings
+// the readings of one cycle, written with a single append
+CaptureRecord captureBuffer[MAX_SENSORS];
+uint8_t captureCount = 0;
+
+void saveConfig();
+
+// idx into sensors[], readings of unknown sensors are not recorded
+void captureReading(uint8_t idx, float raw) {
+  if (!captureEnabled || captureCount >= MAX_SENSORS || idx >= MAX_SENSORS) return;
+  CaptureRecord &cr = captureBuffer[captureCount++];
+  cr.time = timeSynced ? UTC.now() : millis() / 1000;
+  cr.sensor = idx | (timeSynced ? 0 : CAPTURE_UPTIME);
+  cr.raw = raw;
+}
+
+size_t captureTableSize() {
+  return 5 + numberOfSensors() * sizeof(CaptureSensor);
+}
+
+void writeCaptureTable(Print &out) {
+  uint8_t cnt = numberOfSensors();
+  out.write((const uint8_t *) CAPTURE_MAGIC, 4);
+  out.write(&cnt, 1);
+  for (uint8_t i = 0; i < cnt; ++i) {
+    CaptureSensor cs;
+    memcpy(cs.id, sensors[i].id, SENSOR_ID_LENGTH);
+    memcpy(cs.measurand, sensors[i].measurand, SENSOR_MEASURAND_LENGTH);
+    cs.correction = sensors[i].correction;
+    out.write((const uint8_t *) &cs, sizeof(cs));
+  }
+}
+
+void writeCaptureFile() {
+  if (!LittleFS.begin()) {
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_ERROR, "Error while init LittleFS.");
+    return;
+  }
+  File f = LittleFS.open(CAPTURE_FILE, "a");
+  size_t tableSize = captureTableDue || f.size() == 0 ? captureTableSize() : 0;
+  if (!f) {
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_ERROR, "Open capture file failed.");
+  } else if (f.size() + tableSize + captureCount * sizeof(CaptureRecord) > CAPTURE_MAX_SIZE) {
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_WARN, "Capture file is full, capture stopped.");
+    captureEnabled = false;
+  } else {
+    if (tableSize > 0) writeCaptureTable(f);
+    captureTableDue = false;
+    f.write((const uint8_t *) captureBuffer, captureCount * sizeof(CaptureRecord));
+  }
+  f.close();
+  LittleFS.end();
+  if (!captureEnabled) {
+    // saved, or the node would capture again after a reboot and stop at once
+    saveConfig();
+    configVersion = nextStateVersion();
+  }
+}
+
+// the readings are lost while the broker is not connected
+void publishCapture() {
+  if (!mqttClient.connected()) return;
+
+  char topic[64]; // <topic>/<node>/capture/sensors
+  snprintf(topic, sizeof(topic), "%s.%s.capture.", rootTopic.c_str(), nodeName.c_str());
+  for (char *c = topic; *c != '\0'; ++c) {
+    if (*c == '.') *c = '/';
+  }
+  size_t len = strlen(topic);
+  if (captureTableDue) {
+    // larger than the MQTT buffer with many sensors, so it is streamed
+    strlcpy(topic + len, "sensors", sizeof(topic) - len);
+    if (!mqttClient.beginPublish(topic, captureTableSize(), true)) return;
+    writeCaptureTable(mqttClient);
+    if (!mqttClient.endPublish()) return;
+    captureTableDue = false;
+  }
+  strlcpy(topic + len, "data", sizeof(topic) - len);
+  mqttClient.publish(topic, (const uint8_t *) captureBuffer, captureCount * sizeof(CaptureRecord));
+}
+
+void flushCapture() {
+  if (captureCount == 0) return;
+  if (captureMqtt) {
+    publishCapture();
+  } else {
+    writeCaptureFile();
+  }
+  captureCount = 0;
+}
+
+// the processing of a raw reading, no side effects
+float processReading(float raw, float correction) {
+  return raw + correction;
+}
+
+// idx into sensors[], MAX_SENSORS for an unknown sensor
+void setSensorDataValue(uint8_t idx, float v) {
+  SensorData &sd = idx < MAX_SENSORS ? sensors[idx] : tmpSensor;
+  captureReading(idx, v);
+  char value[SENSOR_VALUE_LENGTH];
+  snprintf(value, SENSOR_VALUE_LENGTH, "%.2f", processReading(v, sd.correction));
+  if (strcmp(value, sd.value) != 0) {
+    strcpy(sd.value, value);
+    sd.version = nextStateVersion();
   }
 }
 
-void setSensorDataValue(const String& id, float v) {
-  SensorData &sd = getSensorData(id);
-  sd.value = String(v + sd.correction, 2);
+void setSensorDataValue(const char *id, float v) {
+  setSensorDataValue(sensorIndex(id), v);
+}
+
+// an I2C sensor value, see addSensor()
+void setSensorDataValue(const String& addr, char measurand, float v) {
+  char id[SENSOR_ID_LENGTH];
+  snprintf(id, SENSOR_ID_LENGTH, "%s%c", addr.c_str(), measurand);
+  setSensorDataValue(id, v);
 }
 
+void readSensorValues();
+
 void fetchSensorValues() {
+  LatencyProbe probe(sectionLatency[SECTION_FETCH]);
   // request to all devices on the bus
   dsSensors.requestTemperatures();
+  readSensorValues();
+}
 
+// read all sensors, the OneWire conversion has to be requested before
+void readSensorValues() {
   for (uint8_t i = 0; i < oneWireDeviceCount; ++i) {
     float tempC = dsSensors.getTempC(sensors[i].addr);
-    setSensorDataValue(sensors[i].id, tempC);
+    setSensorDataValue(i, tempC);
   }
 
   if (bmeAddr.length() > 0) {
-    setSensorDataValue(bmeAddr+"t",bme.readTemperature());
-    setSensorDataValue(bmeAddr+"h",bme.readHumidity());
-    setSensorDataValue(bmeAddr+"p",bme.seaLevelForAltitude(nodeAltitude, bme.readPressure()));
+    setSensorDataValue(bmeAddr, 't', bme.readTemperature());
+    setSensorDataValue(bmeAddr, 'h', bme.readHumidity());
+    setSensorDataValue(bmeAddr, 'p', bme.seaLevelForAltitude(nodeAltitude, bme.readPressure()));
   }
 
   if (si70xxAddr.length() > 0) {
-    setSensorDataValue(si70xxAddr+"h",si70xx.readHumidity());
-    setSensorDataValue(si70xxAddr+"t",si70xx.readTemperature());
+    setSensorDataValue(si70xxAddr, 'h', si70xx.readHumidity());
+    setSensorDataValue(si70xxAddr, 't', si70xx.readTemperature());
   }
 
   if (htu21Addr.length() > 0) {
-    setSensorDataValue(htu21Addr+"h",htu21.readHumidity());
-    setSensorDataValue(htu21Addr+"t",htu21.readTemperature());
+    setSensorDataValue(htu21Addr, 'h', htu21.readHumidity());
+    setSensorDataValue(htu21Addr, 't', htu21.readTemperature());
   }
 
   setSensorDataValue(ANALOG_SENSOR_ADDR, 1.0 * analogRead(A0));
@@ -461,20 +1358,19 @@ void printKV(const String& k, const String& v) {
   espClient.print("\"");
 }
 
-String findData(const String& line, const String& key) {
-  int sIndex = line.indexOf(key+"=");
-  if (sIndex < 0) return "";
-  sIndex += (key.length() + 1);
-
-  String result;
-  int eIndex = line.indexOf("&", sIndex);
-  if (eIndex > 0) {
-    result = line.substring(sIndex, eIndex);
-  } else {
-    result = line.substring(sIndex);
-  }
-  
+// the form field value, url decoded
+#define FORM_VALUE_LENGTH 80
+String findRawData(const String& line, const String& key) {
+  char value[FORM_VALUE_LENGTH];
+  if (!findFormValue(line.c_str(), key.c_str(), value, FORM_VALUE_LENGTH)) return "";
+
+  String result = value;
   result.trim();
+  return result;
+}
+
+String findData(const String& line, const String& key) {
+  String result = findRawData(line, key);
   result.toLowerCase();
   return result;
 } 
@@ -486,12 +1382,12 @@ void writeConfigLine(File& f, const String& line) {
 
 void saveConfig() {
   if (!LittleFS.begin()) {
-    log(LOGLEVEL_ERROR, F("Error while init LittleFS."));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_ERROR, "Error while init LittleFS.");
     return;
   }
   File f = LittleFS.open(CONFIG_FILE, "w");
   if (!f) {
-    log(LOGLEVEL_ERROR, F("Open config file to write failed!"));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_ERROR, "Open config file to write failed!");
   } else {
     debug_println("Save config file ... ");
 
@@ -500,25 +1396,67 @@ void saveConfig() {
     writeConfigLine(f, "altitude=" + String(nodeAltitude, 2));
     writeConfigLine(f, "sto=" + String(updateSensorsTimeout, 10));
     writeConfigLine(f, "wfcto=" + String(updateWeatherForecastTimeout, 10));
+    writeConfigLine(f, "tz=" + timezoneRules);
+    writeConfigLine(f, "heaplimit=" + String(heapLimit, 10));
+    char levels[LOGMODULE_COUNT + 1];
+    for (uint8_t i = 0; i < LOGMODULE_COUNT; ++i) {
+      levels[i] = '0' + logLevels[i];
+    }
+    levels[LOGMODULE_COUNT] = '\0';
+    writeConfigLine(f, "loglevels=" + String(levels));
 
     if (hasDisplay) {
       writeConfigLine(f, "hasDisplay");
     }
+
+    if (weatherLeader) {
+      writeConfigLine(f, "wfclead");
+    }
+
+    if (wifiStaticIp) {
+      writeConfigLine(f, "wifistatic");
+    }
+
+    if (publishStats) {
+      writeConfigLine(f, "statsmqtt");
+    }
+
+    if (captureEnabled) {
+      writeConfigLine(f, "capture");
+    }
+
+    if (captureMqtt) {
+      writeConfigLine(f, "capturemqtt");
+    }
+
+    if (syslogServer.length() > 0) {
+      writeConfigLine(f, "syslog=" + syslogServer);
+    }
+
+    if (syslogPlain) {
+      writeConfigLine(f, "syslogplain");
+    }
     
     if (showSensor.length() > 0) {
       writeConfigLine(f, "show=" + showSensor);
     }
+
+    writeConfigLine(f, "outdoor=" + showOutdoor);
+    for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+      if (remotes[i].source[0] != '\0') {
+        writeConfigLine(f, "remote-" + String(i) + "=" + remotes[i].source);
+      }
+    }
     
-    uint8_t idx = 0;
-    while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {
-      writeConfigLine(f, "sensor-" + sensors[idx].id + "=" + sensors[idx].location);
-      writeConfigLine(f, "sensor.enabled-" + sensors[idx].id + "=" + sensors[idx].enabled);
-      writeConfigLine(f, "sensor.correction-" + sensors[idx].id + "=" + sensors[idx].correction);
-      ++idx;
+    for (uint8_t idx = 0; idx < numberOfSensors(); ++idx) {
+      String id = sensors[idx].id;
+      writeConfigLine(f, "sensor-" + id + "=" + sensors[idx].location);
+      writeConfigLine(f, "sensor.enabled-" + id + "=" + sensors[idx].enabled);
+      writeConfigLine(f, "sensor.correction-" + id + "=" + sensors[idx].correction);
     }
     
     f.close();
-    log(LOGLEVEL_INFO, F("Saved config."));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "Saved config.");
   }
 
   LittleFS.end();
@@ -528,94 +1466,429 @@ bool isNewValue(const String& oldValue, const String& newValue) {
   return newValue.length() > 0 && !oldValue.equals(newValue);
 }
 
-void handleGetRoot() {
-  espServer.send(200, "text/html", configHtml);   
+bool isNewValue(const char *oldValue, const String& newValue) {
+  return newValue.length() > 0 && !newValue.equals(oldValue);
+}
+
+RemoteValue* findRemoteValue(const String& source) {
+  for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+    if (remotes[i].source[0] != '\0' && source.equals(remotes[i].source)) return &remotes[i];
+  }
+  return nullptr;
+}
+
+// set the source of a remote value, an empty source clears the entry
+void setRemoteSource(uint8_t idx, const String& source) {
+  RemoteValue &rv = remotes[idx];
+  if (rv.topic[0] != '\0' && mqttClient.connected()) {
+    mqttClient.unsubscribe(rv.topic);
+  }
+  strlcpy(rv.source, source.c_str(), REMOTE_SOURCE_LENGTH);
+  strlcpy(rv.topic, rv.source, REMOTE_SOURCE_LENGTH);
+  for (char *c = rv.topic; *c; ++c) {
+    if (*c == '.') *c = '/';
+  }
+  strcpy(rv.measurand, "");
+  strcpy(rv.value, "?");
+  rv.updated = 0;
+  if (rv.topic[0] != '\0' && mqttClient.connected()) {
+    mqttClient.subscribe(rv.topic);
+  }
+}
+
+void subscribeRemoteValues() {
+  for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+    if (remotes[i].topic[0] != '\0') mqttClient.subscribe(remotes[i].topic);
+  }
+}
+
+// --- Web server statistics ---
+// latency and response size per handler, the handlers send via sendWeb*() to count the bytes
+#define WEB_HANDLER_CNT 12
+struct WebHandlerStats {
+  const char *name;
+  uint32_t bytes;
+  uint32_t maxBytes;
+  LatencyHistogram latency;
+};
+WebHandlerStats webStats[WEB_HANDLER_CNT];
+uint8_t webStatsCount = 0;
+uint32_t webResponseBytes = 0; // of the current response
+
+void sendWebContent(const char *content) {
+  webResponseBytes += strlen(content);
+  espServer.sendContent(content);
+}
+
+void sendWeb(int code, const char *contentType, const char *content) {
+  webResponseBytes += strlen(content);
+  espServer.send(code, contentType, content);
+}
+
+void runWebHandler(uint8_t idx, void (*handler)()) {
+  webResponseBytes = 0;
+  uint32_t start = micros();
+  handler();
+  WebHandlerStats &ws = webStats[idx];
+  ws.latency.record(micros() - start);
+  ws.bytes += webResponseBytes;
+  ws.maxBytes = max(ws.maxBytes, webResponseBytes);
+}
+
+uint8_t addWebStats(const char *name) {
+  if (webStatsCount == WEB_HANDLER_CNT) return WEB_HANDLER_CNT - 1; // share the last entry
+  webStats[webStatsCount].name = name;
+  return webStatsCount++;
+}
+
+// register a handler whose runs are measured, name is "<method> <uri>"
+void onWeb(const char *uri, HTTPMethod method, const char *name, void (*handler)()) {
+  uint8_t idx = addWebStats(name);
+  espServer.on(uri, method, [idx, handler]() { runWebHandler(idx, handler); });
+}
+
+void handleGetRoot() {
+  sendWeb(200, "text/html", configHtml.c_str());   
+}
+
+// the config as JSON in webSendBuffer
+void formatConfigJson() {
+  int len = snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, 
+    "{\"version\":%d,\"build\":\"%s\",\"sensorcycle\":%d,\"forecastcycle\":%d,\"node\":\"%s\",\"topic\":\"%s\",\"altitude\":\"%-.2f\",\"tz\":\"%s\",\"heaplimit\":%lu,\"display\":%d,\"forecastleader\":%d,\"staticip\":%d,\"publishstats\":%d,\"capture\":%d,\"capturemqtt\":%d,\"syslog\":\"%s\",\"syslogplain\":%d,\"show\":\"%s\",\"outdoor\":\"%s\",\"remotes\":[", 
+    SENSORNODE_VERSION,
+    COMPILE_INFO,
+    updateSensorsTimeout,
+    updateWeatherForecastTimeout,
+    nodeName.c_str(),
+    rootTopic.c_str(),
+    nodeAltitude,
+    timezoneRules.c_str(),
+    (unsigned long) heapLimit,
+    hasDisplay,
+    weatherLeader,
+    wifiStaticIp,
+    publishStats,
+    captureEnabled,
+    captureMqtt,
+    syslogServer.c_str(),
+    syslogPlain,
+    showSensor.c_str(),
+    showOutdoor.c_str()
+  );
+  for (uint8_t i = 0; i < MAX_REMOTE_VALUES && len < (int) SIZE_WEBSENDBUFFER; ++i) {
+    len += snprintf(webSendBuffer + len, SIZE_WEBSENDBUFFER - len, "%s{\"source\":\"%s\",\"measurand\":\"%s\",\"value\":\"%s\"}",
+      i > 0 ? "," : "", remotes[i].source, remotes[i].measurand, remotes[i].value);
+  }
+  for (uint8_t i = 0; i < LOGMODULE_COUNT && len < (int) SIZE_WEBSENDBUFFER; ++i) {
+    len += snprintf(webSendBuffer + len, SIZE_WEBSENDBUFFER - len, "%s\"%s\":%u",
+      i > 0 ? "," : "],\"loglevels\":{", logModuleNames[i], logLevels[i]);
+  }
+  strncat(webSendBuffer, "}}", SIZE_WEBSENDBUFFER - strlen(webSendBuffer));
+}
+
+void handleGetConfig() {
+  formatConfigJson();
+  sendWeb(200, "application/json", webSendBuffer);   
+}
+
+// all sensors as JSON in webSendBuffer
+void formatSensorsJson() {
+  strcpy(webSendBuffer, "{");
+
+  char sep[2];
+  sep[0]='\0';
+  sep[1]='\0';
+
+  char oneSensorBuf[SIZE_JSON_ONE_SENSOR];
+  uint8_t idx = 0;
+  while (idx < MAX_SENSORS && sensors[idx].id[0] != '\0') {
+    snprintf(oneSensorBuf, SIZE_JSON_ONE_SENSOR, 
+            //     keys: e, l, t, m, v, c, s
+            "%s\"%s\":{\"enabled\":%d,\"location\":\"%s\",\"type\":\"%s\",\"measurand\":\"%s\",\"value\":\"%s\",\"correction\":\"%-.2f\",\"show\":%d}", 
+            sep, 
+            sensors[idx].id, 
+            sensors[idx].enabled, 
+            sensors[idx].location, 
+            sensors[idx].type, 
+            sensors[idx].measurand, 
+            sensors[idx].value,
+            sensors[idx].correction,
+            showSensor.equals(sensors[idx].id));
+    sep[0]=',';
+    strncat(webSendBuffer, oneSensorBuf, SIZE_WEBSENDBUFFER - strlen(webSendBuffer));
+    ++idx;
+  }
+  strncat(webSendBuffer, "}", SIZE_WEBSENDBUFFER - strlen(webSendBuffer));
+}
+
+void handleGetSensors() {
+  formatSensorsJson();
+  sendWeb(200, "application/json", webSendBuffer);   
+}
+
+// the cached weather data, an expired cache triggers a new request to the API
+void handleGetWeather() {
+  if (wc.isExpired() && (weatherLeader || !isSharedWeatherFresh())) {
+    wc.requestWeatherData();
+  }
+  const WeatherData &wd = wc.getWeatherData();
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER,
+    "{\"valid\":%d,\"age\":%u,\"ttl\":%d,\"icon\":\"%.3s\",\"temperature\":%.2f,\"feels_like\":%.2f,\"pressure\":%.1f,\"humidity\":%u,"
+    "\"wind_speed\":%.2f,\"wind_deg\":%u,\"clouds\":%u,\"sunrise\":%lu,\"sunset\":%lu,\"dt\":%lu,\"fetched\":%lu}",
+    wc.isValid(), (unsigned) wc.getAge(), updateWeatherForecastTimeout, wd.icon, wd.temperature, wd.feelsLike, wd.pressure, wd.humidity,
+    wd.windSpeed, wd.windDeg, wd.clouds, (unsigned long) wd.sunrise, (unsigned long) wd.sunset,
+    (unsigned long) wd.dt, (unsigned long) wd.fetched);
+  sendWeb(200, "application/json", webSendBuffer);
+}
+
+// latency of the tasks and loop() sections in µs, /stats?reset=1 clears all histograms
+void handleGetStats() {
+  bool reset = espServer.hasArg("reset");
+
+  espServer.chunkedResponseModeStart(200, "application/json");
+  const RtcHeap &rh = rtcState.heap;
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "{\"uptime\":%lu,\"heap\":{\"free\":%lu,\"maxblock\":%lu,\"fragmentation\":%u,"
+    "\"minfree\":%lu,\"minmaxblock\":%lu,\"maxfragmentation\":%u,\"limit\":%lu},",
+    millis() / 1000, (unsigned long) ESP.getFreeHeap(), (unsigned long) ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation(),
+    (unsigned long) minFreeHeap, (unsigned long) minMaxBlock, maxFragmentation, (unsigned long) heapLimit);
+  sendWebContent(webSendBuffer);
+  // low-water marks since power on
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "\"rtc\":{\"boots\":%u,\"minfree\":%lu,\"minmaxblock\":%lu,\"maxfragmentation\":%u,\"minfreestack\":%lu,\"resets\":[",
+    rh.bootCount, (unsigned long) rh.minFreeHeap, (unsigned long) rh.minMaxBlock, rh.maxFragmentation, (unsigned long) rh.minFreeStack);
+  sendWebContent(webSendBuffer);
+  for (uint8_t i = 0; i < RTC_RESET_REASONS && i < rh.bootCount; ++i) {
+    snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "%s\"%s\"", i > 0 ? "," : "", resetReasonName(rh.resetReasons[i]));
+    sendWebContent(webSendBuffer);
+  }
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "]},\"mqtt\":{\"connected\":%d,\"connects\":%lu,\"failures\":%u,\"backoff\":%lu,\"missed\":%lu},",
+    mqttClient.connected(), (unsigned long) mqttConnects, mqttFailures, (unsigned long) mqttBackoff, (unsigned long) mqttMissedValues);
+  sendWebContent(webSendBuffer);
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "\"syslog\":{\"sent\":%lu,\"dropped\":%lu},",
+    (unsigned long) syslogSent, (unsigned long) syslogDropped);
+  sendWebContent(webSendBuffer);
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "\"ntp\":{\"requests\":%lu,\"failures\":%lu,\"roundtrip\":%lu},",
+    (unsigned long) ntp.getRequests(), (unsigned long) ntp.getFailures(), (unsigned long) ntp.getRoundTripMs());
+  sendWebContent(webSendBuffer);
+  const DisplayStats &ds = displayStats;
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "\"display\":{\"frames\":%lu,\"bytes\":%lu,\"windows\":%lu,\"lastbytes\":%lu,\"lastwindows\":%u,\"lastwidgets\":%u},",
+    (unsigned long) ds.frames, (unsigned long) ds.bytes, (unsigned long) ds.windows, (unsigned long) ds.lastBytes, ds.lastWindows, ds.lastWidgets);
+  sendWebContent(webSendBuffer);
+  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "\"buckets\":%d,\"tasks\":[", LATENCY_BUCKETS);
+  sendWebContent(webSendBuffer);
+  for (uint8_t i = 0; i < scheduler.getTaskCount(); ++i) {
+    const Task &task = scheduler.getTask(i);
+    snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "%s{\"runs\":%lu,\"overruns\":%lu,\"budget\":%lu,\"latency\":",
+      i > 0 ? "," : "", (unsigned long) task.runs, (unsigned long) task.overruns, (unsigned long) task.budget);
+    sendWebContent(webSendBuffer);
+    task.latency.toJson(webSendBuffer, SIZE_WEBSENDBUFFER, task.name);
+    sendWebContent(webSendBuffer);
+    sendWebContent("}");
+  }
+  if (reset) {
+    scheduler.resetLatency();
+  }
+  sendWebContent("],\"web\":[");
+  for (uint8_t i = 0; i < webStatsCount; ++i) {
+    const WebHandlerStats &ws = webStats[i];
+    snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, "%s{\"bytes\":%lu,\"maxbytes\":%lu,\"latency\":",
+      i > 0 ? "," : "", (unsigned long) ws.bytes, (unsigned long) ws.maxBytes);
+    sendWebContent(webSendBuffer);
+    ws.latency.toJson(webSendBuffer, SIZE_WEBSENDBUFFER, ws.name);
+    sendWebContent(webSendBuffer);
+    sendWebContent("}");
+    if (reset) {
+      webStats[i].bytes = 0;
+      webStats[i].maxBytes = 0;
+      webStats[i].latency.reset();
+    }
+  }
+  sendWebContent("],\"sections\":[");
+  for (uint8_t i = 0; i < SECTION_COUNT; ++i) {
+    if (i > 0) sendWebContent(",");
+    sectionLatency[i].toJson(webSendBuffer, SIZE_WEBSENDBUFFER, sectionNames[i]);
+    sendWebContent(webSendBuffer);
+    if (reset) {
+      sectionLatency[i].reset();
+    }
+  }
+  sendWebContent("]}");
+  espServer.chunkedResponseFinalize();
+}
+
+// the raw readings
+void handleGetCapture() {
+  if (!LittleFS.begin()) {
+    sendWeb(500, "text/plain", "LittleFS not available");
+    return;
+  }
+  File f = LittleFS.open(CAPTURE_FILE, "r");
+  if (!f) {
+    sendWeb(404, "text/plain", "No capture file");
+  } else {
+    webResponseBytes += f.size();
+    espServer.streamFile(f, "application/octet-stream");
+    f.close();
+  }
+  LittleFS.end();
+}
+
+// POST /capture deletes the readings, a GET must not change anything
+void handlePostCapture() {
+  if (!LittleFS.begin()) {
+    sendWeb(500, "text/plain", "LittleFS not available");
+    return;
+  }
+  LittleFS.remove(CAPTURE_FILE);
+  LittleFS.end();
+  captureTableDue = true;
+  log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Capture file deleted.");
+  sendWeb(200, "application/json", "{\"size\":0}");
+}
+
+#define LOGFILE_PAGE_LINES 30
+
+void sendLogEntry(char sep[2], uint32_t time, bool synced, uint8_t level, const char *msg) {
+  char tstamp[13];
+  sendWebContent(sep);
+  sendWebContent("{\"time\":\"");
+  if (synced) {
+    time_t t = time;
+    snprintf(tstamp, sizeof(tstamp), "%02d:%02d:%02d", myTZ.hour(t, UTC_TIME), myTZ.minute(t, UTC_TIME), myTZ.second(t, UTC_TIME));
+  } else {
+    snprintf(tstamp, sizeof(tstamp), "+%lus", (unsigned long) time); // uptime
+  }
+  sendWebContent(tstamp);
+  sendWebContent("\",\"level\":\"");
+  sendWebContent(logLevelName(level));
+  sendWebContent("\",\"msg\":\"");
+  sendWebContent(msg);
+  sendWebContent("\"}");
+  sep[0] = ',';
+}
+
+// the lines of the log files from startId up to the first id in the ring, returns
+// the next id or 0 if the page isn't full
+uint32_t sendLogFileEntries(char sep[2], uint32_t startId) {
+  if (!LittleFS.begin()) return 0;
+
+  const char *files[] = { LOGFILE_OLD, LOGFILE };
+  char line[LOGLINE_LENGTH + 32];
+  uint8_t lines = 0;
+  uint32_t nextId = 0;
+  for (uint8_t i = 0; i < 2 && nextId == 0; ++i) {
+    File f = LittleFS.open(files[i], "r");
+    if (!f) continue;
+    while (f.available()) {
+      size_t len = f.readBytesUntil('\n', line, sizeof(line) - 1);
+      line[len] = '\0';
+      char *p = line;
+      uint32_t id = strtoul(p, &p, 10);
+      uint32_t time = strtoul(p, &p, 10);
+      bool synced = strtoul(p, &p, 10) != 0;
+      uint8_t level = strtoul(p, &p, 10);
+      if (id < startId) continue;
+      if (id >= logRing.getFirstId()) break;
+
+      sendLogEntry(sep, time, synced, level, *p == ' ' ? p + 1 : p);
+      if (++lines == LOGFILE_PAGE_LINES) {
+        nextId = id + 1;
+        break;
+      }
+    }
+    f.close();
+  }
+  LittleFS.end();
+  return nextId;
+}
+
+// "logs":[...],"nextId":n with the records from startId on
+void sendLogEntries(uint32_t startId) {
+  char line[LOGLINE_LENGTH];
+  char sep[2] = " ";
+  sendWebContent("\"logs\":[");
+  uint32_t nextId = 0;
+  if (startId < logRing.getFirstId()) {
+    nextId = sendLogFileEntries(sep, startId);
+  }
+  if (nextId == 0) {
+    LogCursor cursor = logRing.begin();
+    LogRecord rec;
+    while (logRing.read(cursor, rec)) {
+      if (rec.id < startId) continue;
+      LogRing::format(rec, line, sizeof(line));
+      sendLogEntry(sep, rec.time, rec.synced, rec.level, line);
+    }
+    nextId = logRing.getNextId();
+  }
+  snprintf(line, sizeof(line), "],\"nextId\":%lu", (unsigned long) nextId);
+  sendWebContent(line);
 }
 
-void handleGetConfig() {
-  snprintf(webSendBuffer, SIZE_WEBSENDBUFFER, 
-    "{\"version\":%d,\"build\":\"%s\",\"sensorcycle\":%d,\"forecastcycle\":%d,\"node\":\"%s\",\"topic\":\"%s\",\"altitude\":\"%-.2f\",\"display\":%d}", 
-    SENSORNODE_VERSION,
-    COMPILE_INFO,
-    updateSensorsTimeout,
-    updateWeatherForecastTimeout,
-    nodeName.c_str(),
-    rootTopic.c_str(),
-    nodeAltitude,
-    hasDisplay
-  );
-  espServer.send(200, "application/json", webSendBuffer);   
+// the value of a numeric query argument, 0 if it is missing; looked up by
+// index as arg(name)/hasArg(name) construct a String for the name
+uint32_t numericArg(const char *name) {
+  for (int i = 0; i < espServer.args(); ++i) {
+    if (strcmp(espServer.argName(i).c_str(), name) == 0) {
+      return strtoul(espServer.arg(i).c_str(), nullptr, 10);
+    }
+  }
+  return 0;
 }
 
-void handleGetSensors() {
-  strcpy(webSendBuffer, "{");
-
-  char sep[2];
-  sep[0]='\0';
-  sep[1]='\0';
+// the log records from id on, older ones are paged from the log files
+void handleGetLogs() {
+  uint32_t startId = numericArg("id");
 
-  char oneSensorBuf[SIZE_JSON_ONE_SENSOR];
-  uint8_t idx = 0;
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {
-    snprintf(oneSensorBuf, SIZE_JSON_ONE_SENSOR, 
-            //     keys: e, l, t, m, v, c, s
-            "%s\"%s\":{\"enabled\":%d,\"location\":\"%s\",\"type\":\"%s\",\"measurand\":\"%s\",\"value\":\"%s\",\"correction\":\"%-.2f\",\"show\":%d}", 
-            sep, 
-            sensors[idx].id.c_str(), 
-            sensors[idx].enabled, 
-            sensors[idx].location.c_str(), 
-            sensors[idx].type.c_str(), 
-            sensors[idx].measurand.c_str(), 
-            sensors[idx].value.c_str(),
-            sensors[idx].correction,
-            showSensor.equals(sensors[idx].id));
-    sep[0]=',';
-    strncat(webSendBuffer, oneSensorBuf, SIZE_WEBSENDBUFFER - strlen(webSendBuffer));
-    ++idx;
-  }
-  strncat(webSendBuffer, "}", SIZE_WEBSENDBUFFER - strlen(webSendBuffer));
-  espServer.send(200, "application/json", webSendBuffer);   
+  espServer.chunkedResponseModeStart(200, "application/json");
+  sendWebContent("{");
+  sendLogEntries(startId);
+  sendWebContent("}");
+  espServer.chunkedResponseFinalize();
 }
 
-void handleGetLogs() {
-  int32_t startId = 0;
-  if (espServer.args() == 1 && espServer.hasArg("id")) {
-    startId = max(espServer.arg(0).toInt(), 0L);
-  }
-  
+// What the config page shows, changed since the version ?since= (0 = all): the
+// config and the sensor list, the changed sensor and remote values and the log
+// records from ?id= on. Answers right away, also if nothing has changed: a wait
+// here would hold up the web server, the page polls instead.
+// A version ahead of stateVersion is from before a reboot, it gets everything.
+void handleGetState() {
+  uint32_t since = numericArg("since");
+  uint32_t logId = numericArg("id");
+  if (since > stateVersion) since = 0;
+
+  char buf[SIZE_JSON_ONE_SENSOR];
   espServer.chunkedResponseModeStart(200, "application/json");
-  espServer.sendContent("{\"nextId\":");
-  sprintf(logbuf, "%d", lastLogId + 1);
-  espServer.sendContent(logbuf);
-  espServer.sendContent(",\"logs\":[");
-  if (startId <= lastLogId) {
-    int8_t cnt = (int8_t) min(lastLogId - startId + 1, LOGLINE_CNT);
-    int8_t idx = (lastLogId - cnt) % LOGLINE_CNT;
-    char sep[2] = " ";
-    char tstamp[9];
-    for (uint8_t i = 0; i < cnt; ++i) {
-      ++idx;
-      if (idx == LOGLINE_CNT) idx = 0;
-      if (strlen(logs[idx].message) == 0) continue;
-
-      espServer.sendContent(sep);
-      espServer.sendContent("{\"time\":\"");
-      snprintf(tstamp, 9, "%02d:%02d:%02d", logs[idx].timestamp[0], logs[idx].timestamp[1], logs[idx].timestamp[2]);
-      espServer.sendContent(tstamp);
-      espServer.sendContent("\",\"level\":\"");
-      switch(logs[idx].level) {
-        case LOGLEVEL_ERROR: espServer.sendContent("ERROR"); break;
-        case LOGLEVEL_WARN: espServer.sendContent("WARN"); break;
-        case LOGLEVEL_INFO: espServer.sendContent("INFO"); break; 
-        default: espServer.sendContent("DEBUG");
-      }
-      espServer.sendContent("\",\"msg\":\"");
-      espServer.sendContent(logs[idx].message);
-      espServer.sendContent("\"}");
+  snprintf(buf, sizeof(buf), "{\"version\":%lu,", (unsigned long) stateVersion);
+  sendWebContent(buf);
+  if (configVersion > since) {
+    sendWebContent("\"config\":");
+    formatConfigJson();
+    sendWebContent(webSendBuffer);
+    sendWebContent(",\"sensors\":");
+    formatSensorsJson();
+    sendWebContent(webSendBuffer);
+    sendWebContent(",");
+  } else {
+    sendWebContent("\"values\":{");
+    char sep[2] = "";
+    for (uint8_t i = 0; i < MAX_SENSORS && sensors[i].id[0] != '\0'; ++i) {
+      if (sensors[i].version <= since) continue;
+      snprintf(buf, sizeof(buf), "%s\"%s\":\"%s\"", sep, sensors[i].id, sensors[i].value);
+      sendWebContent(buf);
       sep[0] = ',';
     }
+    sendWebContent("},");
+    if (remotesVersion > since) {
+      sendWebContent("\"remotes\":[");
+      for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+        snprintf(buf, sizeof(buf), "%s{\"measurand\":\"%s\",\"value\":\"%s\"}", i > 0 ? "," : "", remotes[i].measurand, remotes[i].value);
+        sendWebContent(buf);
+      }
+      sendWebContent("],");
+    }
   }
-  espServer.sendContent("]}");
+  sendLogEntries(logId);
+  sendWebContent("}");
   espServer.chunkedResponseFinalize();
 }
 
@@ -635,7 +1908,10 @@ void handlePostRoot() {
   }
 
   newValue = findData(content, "topic");
-  if (isNewValue(rootTopic, newValue)) {
+  if (newValue.length() >= ROOT_TOPIC_LENGTH) {
+    // the sensor topics would be cut
+    log_printf(LOGMODULE_WEB, LOGLEVEL_WARN, "Topic too long, max. %u chars.", ROOT_TOPIC_LENGTH - 1);
+  } else if (isNewValue(rootTopic, newValue)) {
     rootTopic = newValue;
     updateSensorTopics();
     needSave = true;
@@ -650,16 +1926,17 @@ void handlePostRoot() {
 
   newValue = findData(content, "sensorcycle");
   if (isNewValue(String(updateSensorsTimeout, 10), newValue)) {
-    updateSensorsTimeout = max(1L,newValue.toInt());
-    timer1.interval(updateSensorsTimeout * 1000);
+    updateSensorsTimeout = constrain(newValue.toInt(), MIN_CYCLE_SEC, MAX_CYCLE_SEC);
+    scheduler.setInterval(sensorTask, updateSensorsTimeout * 1000);
     needSave = true;
   }
 
 #if SENSORNODE_VERSION >= SENSORNODE_WITH_DISPLAY_VERSION
   newValue = findData(content, "forecastcycle");
   if (isNewValue(String(updateWeatherForecastTimeout, 10), newValue)) {
-    updateWeatherForecastTimeout = newValue.toInt();
-    timer2.interval(updateWeatherForecastTimeout * 1000);
+    updateWeatherForecastTimeout = constrain(newValue.toInt(), MIN_CYCLE_SEC, MAX_CYCLE_SEC);
+    scheduler.setInterval(weatherTask, updateWeatherForecastTimeout * 1000);
+    wc.setTtl(updateWeatherForecastTimeout);
     needSave = true;
   }
 
@@ -673,23 +1950,109 @@ void handlePostRoot() {
   hasDisplay = false;
 #endif
 
+  for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+    newValue = findData(content, "remote-" + String(i));
+    if (!newValue.equals(remotes[i].source)) {
+      setRemoteSource(i, newValue);
+      needSave = true;
+    }
+  }
+
+  newValue = findData(content, "outdoor");
+  if (isNewValue(showOutdoor, newValue)) {
+    showOutdoor = newValue;
+    needSave = true;
+  }
+
+  newValue = findData(content, "forecastleader");
+  if (weatherLeader != (newValue.length() > 0)) {
+    weatherLeader = newValue.length() > 0;
+    needSave = true;
+  }
+
+  newValue = findRawData(content, "tz");
+  if (newValue.length() > 0 && isNewValue(timezoneRules, newValue)) {
+    timezoneRules = newValue;
+    myTZ.setPosix(timezoneRules);
+    needSave = true;
+  }
+
+  newValue = findData(content, "heaplimit");
+  if (newValue.length() > 0 && isNewValue(String(heapLimit, 10), newValue)) {
+    long limit = max(0L, newValue.toInt());
+    if ((uint32_t) limit > maxHeapLimit()) {
+      log_printf(LOGMODULE_WEB, LOGLEVEL_WARN, "Heap limit %ld too high, max. %lu bytes.", limit, (unsigned long) maxHeapLimit());
+    } else {
+      heapLimit = limit;
+      needSave = true;
+    }
+  }
+
+  for (uint8_t i = 0; i < LOGMODULE_COUNT; ++i) {
+    newValue = findData(content, "log-" + String(logModuleNames[i]));
+    if (newValue.length() > 0 && isNewValue(String(logLevels[i]), newValue)) {
+      logLevels[i] = constrain(newValue.toInt(), LOGLEVEL_ERROR, LOGLEVEL_DEBUG);
+      needSave = true;
+    }
+  }
+
+  // empty = off
+  newValue = findRawData(content, "syslog");
+  if (!newValue.equals(syslogServer)) {
+    setSyslogServer(newValue);
+    needSave = true;
+  }
+
+  newValue = findData(content, "syslogplain");
+  if (syslogPlain != (newValue.length() > 0)) {
+    syslogPlain = newValue.length() > 0;
+    needSave = true;
+  }
+
+  newValue = findData(content, "capture");
+  if (captureEnabled != (newValue.length() > 0)) {
+    captureEnabled = newValue.length() > 0;
+    needSave = true;
+  }
+
+  newValue = findData(content, "capturemqtt");
+  if (captureMqtt != (newValue.length() > 0)) {
+    captureMqtt = newValue.length() > 0;
+    needSave = true;
+  }
+
+  newValue = findData(content, "publishstats");
+  if (publishStats != (newValue.length() > 0)) {
+    publishStats = newValue.length() > 0;
+    needSave = true;
+  }
+
+  newValue = findData(content, "staticip");
+  if (wifiStaticIp != (newValue.length() > 0)) {
+    wifiStaticIp = newValue.length() > 0;
+    needSave = true;
+  }
+
   uint8_t idx = 0;
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {
-    String key = "loc-" + sensors[idx].id;
+  while (idx < MAX_SENSORS && sensors[idx].id[0] != '\0') {
+    String key = "loc-" + String(sensors[idx].id);
     newValue = findData(content, key);
-    if (isNewValue(sensors[idx].location, newValue)) {
-      sensors[idx].location = newValue;
-      updateSensorTopic(sensors[idx].id);
+    if (newValue.length() >= SENSOR_LOCATION_LENGTH) {
+      // truncated it would differ from the posted value on every POST
+      log_printf(LOGMODULE_WEB, LOGLEVEL_WARN, "Location of %s too long, max. %u chars.", sensors[idx].id, SENSOR_LOCATION_LENGTH - 1);
+    } else if (isNewValue(sensors[idx].location, newValue)) {
+      strlcpy(sensors[idx].location, newValue.c_str(), SENSOR_LOCATION_LENGTH);
+      updateSensorTopic(sensors[idx]);
       needSave = true;
     }
 
-    key = "en-" + sensors[idx].id;
+    key = "en-" + String(sensors[idx].id);
     newValue = findData(content, key);
     bool newEnabled = newValue.equals("on");
-    needSave = needSave || (sensors[idx].enabled == newEnabled);
+    needSave = needSave || (sensors[idx].enabled != newEnabled);
     sensors[idx].enabled = newEnabled;
 
-    key = "cor-" + sensors[idx].id;
+    key = "cor-" + String(sensors[idx].id);
     newValue = findData(content, key);
     if (isNewValue(String(sensors[idx].correction, 2), newValue)) {
       sensors[idx].correction = newValue.toFloat();
@@ -707,7 +2070,12 @@ void handlePostRoot() {
     ++idx;
   }
 
-  if (needSave) saveConfig();
+  if (needSave) {
+    saveConfig();
+    configVersion = nextStateVersion();
+    // the corrections may have changed
+    captureTableDue = true;
+  }
   if (needSensorFetch) fetchSensorValues();
   
   if (needSave || needSensorFetch) updateDisplay();
@@ -717,14 +2085,14 @@ void handlePostRoot() {
 }
 
 void handleError() {
-  espServer.send(404, "text/plain", "404: Not found");
+  sendWeb(404, "text/plain", "404: Not found");
 }
 
 void loadConfigHtml() {
   configHtml = "";
   File f = LittleFS.open(CONFIG_HTML, "r");
   if (!f) {
-    log(LOGLEVEL_ERROR,F("HTML file not found/open failed"));
+    log_printf(LOGMODULE_WEB, LOGLEVEL_ERROR, "HTML file not found/open failed");
     configHtml = "HTML file not found/open failed";
   } else {
     while(f.available()) {
@@ -737,7 +2105,7 @@ void loadConfigHtml() {
 void loadConfigFile() {
   File f = LittleFS.open(CONFIG_FILE, "r");
   if (!f) {
-    log(LOGLEVEL_WARN, F("Config file not found/open failed - use default values"));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_WARN, "Config file not found/open failed - use default values");
   } else {
     debug_println(F("Load config file ... "));
     uint8_t idx = 0;
@@ -746,25 +2114,74 @@ void loadConfigFile() {
       line.remove(line.length()-1); // remove CR f
       debug_println("cfgline: '"+line+"'");
 
-      if (line.indexOf("node=") >= 0) {
+      if (line.indexOf("tz=") == 0) {
+        timezoneRules = line.substring(sizeof("tz=")-1);
+        myTZ.setPosix(timezoneRules);
+        debug_println("-> tz='"+timezoneRules+"'");
+      } else if (line.indexOf("heaplimit=") == 0) {
+        heapLimit = line.substring(sizeof("heaplimit=")-1).toInt();
+        debug_printf("-> heaplimit='%lu'\n", (unsigned long) heapLimit);
+      } else if (line.indexOf("loglevels=") == 0) {
+        // one digit per module
+        String levels = line.substring(sizeof("loglevels=")-1);
+        for (uint8_t i = 0; i < LOGMODULE_COUNT && i < levels.length(); ++i) {
+          logLevels[i] = constrain(levels.charAt(i) - '0', LOGLEVEL_ERROR, LOGLEVEL_DEBUG);
+        }
+        debug_println("-> loglevels='"+levels+"'");
+      } else if (line.indexOf("syslog=") == 0) {
+        setSyslogServer(line.substring(sizeof("syslog=")-1));
+        debug_println("-> syslog='"+syslogServer+"'");
+      } else if (line.indexOf("syslogplain") == 0) {
+        syslogPlain = true;
+        debug_println(F("-> syslogplain"));
+      } else if (line.indexOf("node=") >= 0) {
         nodeName = line.substring(sizeof("node=")-1);
         debug_println("-> node='"+nodeName+"'");
       } else if (line.indexOf("topic=") >= 0) {
-        rootTopic = line.substring(sizeof("topic=")-1);
-        debug_println("-> rootTopic='"+rootTopic+"'");
-        updateSensorTopics();
+        String topic = line.substring(sizeof("topic=")-1);
+        debug_println("-> rootTopic='"+topic+"'");
+        if (topic.length() >= ROOT_TOPIC_LENGTH) {
+          log_printf(LOGMODULE_SYSTEM, LOGLEVEL_WARN, "Topic too long, max. %u chars.", ROOT_TOPIC_LENGTH - 1);
+        } else {
+          rootTopic = topic;
+          updateSensorTopics();
+        }
       } else if (line.indexOf("altitude=") >= 0) {
         String altitude = line.substring(sizeof("altitude=")-1);
         nodeAltitude = altitude.toFloat();
         debug_println("-> altitude='"+altitude+"'");
       } else if (line.indexOf("sto=") >= 0) {
-        updateSensorsTimeout = line.substring(sizeof("sto=")-1).toInt();
+        updateSensorsTimeout = constrain(line.substring(sizeof("sto=")-1).toInt(), MIN_CYCLE_SEC, MAX_CYCLE_SEC);
         debug_printf("-> sto='%d'\n", updateSensorsTimeout);
-        timer1.interval(updateSensorsTimeout * 1000);
       } else if (line.indexOf("wfcto=") >= 0) {
-        updateWeatherForecastTimeout = line.substring(sizeof("wfcto=")-1).toInt();
+        updateWeatherForecastTimeout = constrain(line.substring(sizeof("wfcto=")-1).toInt(), MIN_CYCLE_SEC, MAX_CYCLE_SEC);
         debug_printf("-> wfcto='%d'\n", updateWeatherForecastTimeout);
-        timer2.interval(updateWeatherForecastTimeout * 1000);
+        wc.setTtl(updateWeatherForecastTimeout);
+      } else if (line.indexOf("remote-") == 0) {
+        int eq = line.indexOf("=");
+        uint8_t i = line.substring(sizeof("remote-") - 1, eq).toInt();
+        if (i < MAX_REMOTE_VALUES) {
+          setRemoteSource(i, line.substring(eq + 1));
+          debug_println("-> remote-" + String(i) + "='" + remotes[i].source + "'");
+        }
+      } else if (line.indexOf("outdoor=") == 0) {
+        showOutdoor = line.substring(sizeof("outdoor=")-1);
+        debug_println("-> outdoor='" + showOutdoor + "'");
+      } else if (line.indexOf("wfclead") >= 0) {
+        weatherLeader = true;
+        debug_println(F("-> wfclead"));
+      } else if (line.indexOf("capturemqtt") == 0) {
+        captureMqtt = true;
+        debug_println(F("-> capturemqtt"));
+      } else if (line.indexOf("capture") == 0) {
+        captureEnabled = true;
+        debug_println(F("-> capture"));
+      } else if (line.indexOf("statsmqtt") >= 0) {
+        publishStats = true;
+        debug_println(F("-> statsmqtt"));
+      } else if (line.indexOf("wifistatic") >= 0) {
+        wifiStaticIp = true;
+        debug_println(F("-> wifistatic"));
       } else if (line.indexOf("hasDisplay") >= 0) {
 #if SENSORNODE_VERSION >= SENSORNODE_WITH_DISPLAY_VERSION
         hasDisplay = true;
@@ -793,16 +2210,17 @@ void loadConfigFile() {
         int eq = line.indexOf("=");
         String id = line.substring(sizeof("sensor-") - 1, eq);
         String location = line.substring(eq + 1);
-        getSensorData(id).location = location;
+        SensorData &sd = getSensorData(id);
+        strlcpy(sd.location, location.c_str(), SENSOR_LOCATION_LENGTH);
         debug_println("-> Sensor("+id+").location='"+location+"'");
-        updateSensorTopic(id);
+        updateSensorTopic(sd);
         idx = numberOfSensors();
       }
       debug_println("-- #Sensors: " + String(idx) + " ----------------------------------");
     }
     f.close();
 
-    log(LOGLEVEL_INFO, F("Config file loaded."));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "Config file loaded.");
   }
 }
 
@@ -811,54 +2229,78 @@ void loadConfig() {
   if (LittleFS.begin()) {
     debug_println(F("Init LittleFS - successful."));
   } else {
-    log(LOGLEVEL_ERROR, F("Error while init LittleFS."));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_ERROR, "Error while init LittleFS.");
     return;
   }
 
   loadConfigHtml();
   loadConfigFile();
+  initLogFile();
+  configVersion = nextStateVersion();
 
   LittleFS.end();
 }
 
+// measurand + location + node + sensor + value + fix + null
+// 20 + 30 + 30 + 20 + 20 + ",location=,node=,sensor= value=" + 1 => 100 + 23 + 1 = 144
+#define DATALINE_LENGTH 144
+
+bool publishSensorValue(uint8_t idx, const char *value, char dataLine[DATALINE_LENGTH]) {
+  const SensorData &sd = sensors[idx];
+  formatSensorLine(dataLine, DATALINE_LENGTH, sd.measurand, sd.location, nodeName.c_str(), sd.type, value);
+
+  bool published = mqttClient.publish(sd.topic, dataLine);
+  log_printf(LOGMODULE_MQTT, LOGLEVEL_DEBUG, "MQTT sensor %u: %.2f", idx, atof(value));
+  debug_println(dataLine);
+  return published;
+}
+
 void sendMQTTData() {
-  // measurand + location + node + sensor + value + fix + null
-  // 20 + 30 + 30 + 20 + 20 + ",location=,node=,sensor= value=" + 1 => 100 + 23 + 1 = 144
-  char dataLine[144]; 
+  LatencyProbe probe(sectionLatency[SECTION_PUBLISH]);
+  static bool firstPublish = true;
+  char dataLine[DATALINE_LENGTH]; 
 
-  uint8_t idx = 0;
-  while (sensors[idx].id.length() > 0 && idx < MAX_SENSORS) {
+  if (!mqttClient.connected()) {
+    for (uint8_t i = 0; i < numberOfSensors(); ++i) {
+      if (sensors[i].enabled) ++mqttMissedValues;
+    }
+    return;
+  }
+
+  for (uint8_t idx = 0; idx < numberOfSensors(); ++idx) {
     if (sensors[idx].enabled) {
-      sprintf(dataLine,"%s,location=%s,node=%s,sensor=%s value=%s", 
-        sensors[idx].measurand.c_str(), 
-        sensors[idx].location.c_str(), 
-        nodeName.c_str(), 
-        sensors[idx].type.c_str(), 
-        sensors[idx].value.c_str());
-
-      mqttClient.publish(sensors[idx].topic.c_str(), dataLine);
-      snprintf(logbuf, LOGLINE_LENGTH, "MQTT topic: %s, msg: %s", sensors[idx].topic.c_str(), dataLine);
-      log(LOGLEVEL_INFO,logbuf);
-      debug_println(dataLine);
+      publishSensorValue(idx, sensors[idx].value, dataLine);
     }
+  }
 
-    ++idx;
+  if (firstPublish) {
+    firstPublish = false;
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_INFO, "First publish %lu ms after boot.", millis());
   }
 }
 
+// one connect attempt per call, failed attempts back off exponentially with random jitter,
+// so a fleet of nodes doesn't reconnect all at once after a broker restart
 void mqttReconnect() {
-  // Loop until we're reconnected
-  while (!mqttClient.connected()) {
-    debug_println(F("MQTT Try to connect ... "));
-    // Attempt to connect
-    if (mqttClient.connect(nodeName.c_str())) {
-      log(LOGLEVEL_INFO, F("MQTT Connected."));
-    } else {
-      snprintf(logbuf, LOGLINE_LENGTH, "MQTT Connection failed, rc=%d. Try again in 5 seconds.", mqttClient.state());
-      log(LOGLEVEL_WARN, logbuf);
-      // Wait 5 seconds before retrying
-      delay(5000);
-    }
+  if ((long) (millis() - mqttNextAttempt) < 0) return;
+
+  debug_println(F("MQTT Try to connect ... "));
+  if (mqttClient.connect(nodeName.c_str())) {
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_INFO, "MQTT Connected after %u failed attempts, %lu sensor values missed.",
+      mqttFailures, (unsigned long) mqttMissedValues);
+    mqttClient.subscribe(WEATHER_SHARE_TOPIC);
+    subscribeRemoteValues();
+    ++mqttConnects;
+    mqttFailures = 0;
+    mqttMissedValues = 0;
+    mqttBackoff = MQTT_BACKOFF_MIN_MS;
+  } else {
+    ++mqttFailures;
+    // equal jitter: wait between half and the whole backoff
+    uint32_t wait = mqttBackoff / 2 + random(mqttBackoff / 2 + 1);
+    mqttNextAttempt = millis() + wait;
+    mqttBackoff = min(mqttBackoff * 2, (uint32_t) MQTT_BACKOFF_MAX_MS);
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_WARN, "MQTT Connection failed, rc=%d. Try again in %lu ms.", mqttClient.state(), (unsigned long) wait);
   }
 }
 
@@ -869,18 +2311,16 @@ void setupOneWireSensors() {
 
   // locate devices on the bus
   if (oneWireDeviceCount > 0) {
-    snprintf(logbuf, LOGLINE_LENGTH, "Found %d OneWire devices.", oneWireDeviceCount);
-    log(LOGLEVEL_INFO, logbuf);
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Found %d OneWire devices.", oneWireDeviceCount);
   } else  {
-    log(LOGLEVEL_INFO, F("No OneWire devices found."));
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "No OneWire devices found.");
   }
 
   DeviceAddress addr;
   // search for devices on the bus and assign based on an index.
   for (uint8_t i = 0; i < oneWireDeviceCount; ++i) {
     if (!dsSensors.getAddress(addr, i)) {
-      snprintf(logbuf, LOGLINE_LENGTH, "Unable to find address for Device %d", i); 
-      log(LOGLEVEL_ERROR, logbuf);
+      log_printf(LOGMODULE_SENSOR, LOGLEVEL_ERROR, "Unable to find address for Device %d", i);
     } else {
       char hexbuf[17];
       addr2hex(addr, hexbuf);
@@ -899,15 +2339,14 @@ void setupI2CSensors() {
   } else if (bme.begin(0x77)) {
     bmeAddr = "77";
   } else {
-    log(LOGLEVEL_INFO, F("No BME280 sensor found."));
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "No BME280 sensor found.");
   }
 
   if (bmeAddr.length() > 0) {
-    snprintf(logbuf, LOGLINE_LENGTH, "Found BME280 sensor on 0x%s", bmeAddr.c_str());
-    log(LOGLEVEL_INFO, logbuf);
-    addSensor(bmeAddr+"h", "BME280", "humidity");
-    addSensor(bmeAddr+"p", "BME280", "pressure");
-    addSensor(bmeAddr+"t", "BME280", "temperature");
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Found BME280 sensor on 0x%s", bmeAddr.c_str());
+    addSensor(bmeAddr, "BME280", "humidity");
+    addSensor(bmeAddr, "BME280", "pressure");
+    addSensor(bmeAddr, "BME280", "temperature");
   }
 
   if (si70xx.begin()) {
@@ -924,22 +2363,21 @@ void setupI2CSensors() {
       default:
         model="Si70xx";
     }
-    snprintf(logbuf, LOGLINE_LENGTH, "Found %s sensor!", model.c_str());
-    log(LOGLEVEL_INFO, logbuf);
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Found %s sensor!", model.c_str());
     si70xxAddr = "40";
-    addSensor(si70xxAddr+"h", model, "humidity");
-    addSensor(si70xxAddr+"t", model, "temperature");
+    addSensor(si70xxAddr, model.c_str(), "humidity");
+    addSensor(si70xxAddr, model.c_str(), "temperature");
   } else {
-    log(LOGLEVEL_INFO, F("No Si70xx sensor found."));
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "No Si70xx sensor found.");
   }
 
   if (si70xxAddr.length() == 0 && htu21.begin()) { // si70xx and htu21 have the same i2c addr 0x40
-    log(LOGLEVEL_INFO, F("Found HTU21 sensor!"));
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Found HTU21 sensor!");
     htu21Addr = "40";
-    addSensor(htu21Addr+"h", "HTU21", "humidity");
-    addSensor(htu21Addr+"t", "HTU21", "temperature");
+    addSensor(htu21Addr, "HTU21", "humidity");
+    addSensor(htu21Addr, "HTU21", "temperature");
   } else {
-    log(LOGLEVEL_INFO, F("No HTU21 sensor found."));
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "No HTU21 sensor found.");
   }
 }
 
@@ -947,6 +2385,213 @@ void setupAnalogSensor() {
   addSensor(ANALOG_SENSOR_ADDR, "LDR", "brightness");
 }
 
+#define WIFI_FAST_TIMEOUT_MS 3000
+
+// connect with the BSSID, channel and optional the IP lease of the last good connection,
+// this skips the scan and DHCP
+bool connectWifiFast() {
+  RtcWifi &rw = rtcState.wifi;
+  if (!rw.valid) return false;
+
+  unsigned long start = millis();
+  WiFi.mode(WIFI_STA);
+  if (wifiStaticIp && rw.ip != 0) {
+    WiFi.config(IPAddress(rw.ip), IPAddress(rw.gateway), IPAddress(rw.mask), IPAddress(rw.dns));
+  }
+  WiFi.begin(WiFi.SSID().c_str(), WiFi.psk().c_str(), rw.channel, rw.bssid);
+  while (WiFi.status() != WL_CONNECTED && millis() - start < WIFI_FAST_TIMEOUT_MS) {
+    delay(10);
+  }
+
+  if (WiFi.status() != WL_CONNECTED) {
+    log_printf(LOGMODULE_WIFI, LOGLEVEL_WARN, "WIFI Fast connect failed.");
+    // the AP or the lease may have changed, next time do the full scan and DHCP
+    rw.valid = false;
+    writeRtcState();
+    WiFi.disconnect();
+    WiFi.config(IPAddress((uint32_t) 0), IPAddress((uint32_t) 0), IPAddress((uint32_t) 0));
+    return false;
+  }
+  log_printf(LOGMODULE_WIFI, LOGLEVEL_INFO, "WIFI Fast connect in %lu ms.", millis() - start);
+  return true;
+}
+
+void storeWifiConnection() {
+  RtcWifi &rw = rtcState.wifi;
+  rw.valid = true;
+  rw.staticIp = wifiStaticIp;
+  rw.channel = WiFi.channel();
+  memcpy(rw.bssid, WiFi.BSSID(), sizeof(rw.bssid));
+  rw.ip = WiFi.localIP();
+  rw.gateway = WiFi.gatewayIP();
+  rw.mask = WiFi.subnetMask();
+  rw.dns = WiFi.dnsIP();
+  writeRtcState();
+}
+
+#if SENSORNODE_DEEPSLEEP
+// after a power on or the reset button the node stays awake this long, so it
+// can be configured via the web page, not after a wake up from deep sleep
+#define DEEPSLEEP_CONFIG_WINDOW_SEC 120
+#define DEEPSLEEP_WIFI_TIMEOUT_MS 10000
+#define DEEPSLEEP_CONVERSION_TIMEOUT_MS 800
+
+// keep config and sensors in RTC memory - if they don't fit, the next wake up loads them as usual
+void storeRtcConfig() {
+  uint8_t cnt = numberOfSensors();
+  rtcState.hasConfig = cnt <= RTC_MAX_SENSORS
+    && nodeName.length() < RTC_NAME_LENGTH && rootTopic.length() < RTC_NAME_LENGTH;
+  rtcState.sensorCount = cnt;
+  rtcState.sensorsTimeout = updateSensorsTimeout;
+  rtcState.altitude = nodeAltitude;
+  strlcpy(rtcState.nodeName, nodeName.c_str(), RTC_NAME_LENGTH);
+  strlcpy(rtcState.rootTopic, rootTopic.c_str(), RTC_NAME_LENGTH);
+
+  for (uint8_t i = 0; i < cnt && rtcState.hasConfig; ++i) {
+    RtcSensor &rs = rtcState.sensors[i];
+    if (strlen(sensors[i].location) >= RTC_LOCATION_LENGTH || strlen(sensors[i].type) >= sizeof(rs.type)) {
+      rtcState.hasConfig = false;
+      break;
+    }
+    if (i < oneWireDeviceCount) {
+      memcpy(rs.addr, sensors[i].addr, sizeof(rs.addr));
+    } else {
+      strlcpy((char *) rs.addr, sensors[i].id, sizeof(rs.addr));
+    }
+    strlcpy(rs.type, sensors[i].type, sizeof(rs.type));
+    rs.measurand = sensors[i].measurand[0];
+    rs.enabled = sensors[i].enabled;
+    rs.correction = (int16_t) lroundf(sensors[i].correction * 100);
+    strlcpy(rs.location, sensors[i].location, RTC_LOCATION_LENGTH);
+  }
+}
+
+const char* measurandName(char m) {
+  switch (m) {
+    case 't': return "temperature";
+    case 'h': return "humidity";
+    case 'p': return "pressure";
+    default:  return "brightness";
+  }
+}
+
+// restore config and sensors from RTC memory and init only the known sensors
+bool restoreRtcConfig() {
+  if (!rtcState.hasConfig) return false;
+
+  nodeName = rtcState.nodeName;
+  rootTopic = rtcState.rootTopic;
+  nodeAltitude = rtcState.altitude;
+  updateSensorsTimeout = rtcState.sensorsTimeout;
+  wifiStaticIp = rtcState.wifi.staticIp;
+
+  Wire.begin(I2C_SDA_PIN,I2C_SCL_PIN);
+  oneWireDeviceCount = 0;
+  for (uint8_t i = 0; i < rtcState.sensorCount; ++i) {
+    RtcSensor &rs = rtcState.sensors[i];
+    char id[17];
+    if (strcmp(rs.type, "DS18B20") == 0) {
+      addr2hex(rs.addr, id);
+      memcpy(sensors[i].addr, rs.addr, sizeof(rs.addr));
+      ++oneWireDeviceCount;
+    } else {
+      strlcpy(id, (const char *) rs.addr, sizeof(rs.addr));
+      if (strcmp(rs.type, "BME280") == 0 && bmeAddr.length() == 0) {
+        bmeAddr = String(id).substring(0, 2);
+        bme.begin(strtol(bmeAddr.c_str(), nullptr, 16));
+      } else if (strcmp(rs.type, "HTU21") == 0 && htu21Addr.length() == 0) {
+        htu21Addr = "40";
+        htu21.begin();
+      } else if (strncmp(rs.type, "Si70", 4) == 0 && si70xxAddr.length() == 0) {
+        si70xxAddr = "40";
+        si70xx.begin();
+      }
+    }
+    addSensor(id, rs.type, measurandName(rs.measurand));
+    sensors[i].enabled = rs.enabled;
+    sensors[i].correction = rs.correction / 100.0f;
+    strlcpy(sensors[i].location, rs.location, SENSOR_LOCATION_LENGTH);
+  }
+  updateSensorTopics();
+  return true;
+}
+
+// queue the values of all enabled sensors, the oldest samples are dropped first
+void queueSensorValues() {
+  for (uint8_t i = 0; i < rtcState.sensorCount; ++i) {
+    if (!sensors[i].enabled) continue;
+    if (rtcState.queueCount == RTC_QUEUE_SIZE) {
+      memmove(&rtcState.queue[0], &rtcState.queue[1], (RTC_QUEUE_SIZE - 1) * sizeof(RtcSample));
+      --rtcState.queueCount;
+    }
+    rtcState.queue[rtcState.queueCount].sensor = i;
+    rtcState.queue[rtcState.queueCount].value = atof(sensors[i].value);
+    ++rtcState.queueCount;
+  }
+}
+
+void publishQueuedValues() {
+  char dataLine[DATALINE_LENGTH];
+  for (uint8_t i = 0; i < rtcState.queueCount; ++i) {
+    RtcSample &sample = rtcState.queue[i];
+    if (sample.sensor < MAX_SENSORS) {
+      char value[SENSOR_VALUE_LENGTH];
+      snprintf(value, SENSOR_VALUE_LENGTH, "%.2f", sample.value);
+      publishSensorValue(sample.sensor, value, dataLine);
+    }
+  }
+  rtcState.queueCount = 0;
+}
+
+void goToSleep() {
+  storeRtcConfig();
+  writeRtcState();
+  // the cycle starts with the wake up, so the time awake is subtracted
+  uint32_t awakeMs = millis();
+  uint64_t sleepMs = max((uint32_t) 1000, (uint32_t) updateSensorsTimeout * 1000 - min(awakeMs, (uint32_t) updateSensorsTimeout * 1000));
+  log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "Deep sleep for %lu ms after %lu ms awake.", (unsigned long) sleepMs, (unsigned long) awakeMs);
+  ESP.deepSleep(sleepMs * 1000);
+}
+
+// a wake up from deep sleep: one acquisition, publish, and back to sleep
+void deepSleepCycle() {
+  // the OneWire conversion runs while WiFi connects
+  dsSensors.setWaitForConversion(false);
+  dsSensors.requestTemperatures();
+  unsigned long conversionStart = millis();
+
+  if (!connectWifiFast()) {
+    WiFi.mode(WIFI_STA);
+    WiFi.begin();
+    while (WiFi.status() != WL_CONNECTED && millis() < DEEPSLEEP_WIFI_TIMEOUT_MS) {
+      delay(10);
+    }
+  }
+
+  while (oneWireDeviceCount > 0 && !dsSensors.isConversionComplete() && millis() - conversionStart < DEEPSLEEP_CONVERSION_TIMEOUT_MS) {
+    delay(1);
+  }
+  readSensorValues();
+
+  bool published = false;
+  if (WiFi.status() == WL_CONNECTED) {
+    storeWifiConnection();
+    mqttClient.setServer(MQTT_SERVER, 1883);
+    if (mqttClient.connect(nodeName.c_str())) {
+      publishQueuedValues();
+      sendMQTTData();
+      mqttClient.disconnect();
+      published = true;
+    }
+  }
+  if (!published) {
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_WARN, "Publish failed, values are queued.");
+    queueSensorValues();
+  }
+  goToSleep();
+}
+#endif
+
 void setupDisplay() {
   if (hasDisplay) {
     tft.init();
@@ -955,72 +2600,328 @@ void setupDisplay() {
     tft.fillScreen(TFT_WHITE);
     tft.setTextSize(1);
     tft.setTextColor(TFT_BLACK);
+
+    largeGlyphs.begin(tft, FONT_LARGE, FONT_CHARSET, TFT_BLACK, TFT_WHITE);
+    middleGlyphs.begin(tft, FONT_MIDDLE, FONT_CHARSET, TFT_BLACK, TFT_WHITE);
+    // kept for good, creating it per widget fragments the heap
+    if (widgetSprite.createSprite(DISP_SPRITE_WIDTH, DISP_SPRITE_HEIGHT) == nullptr) {
+      log_printf(LOGMODULE_DISPLAY, LOGLEVEL_WARN, "No memory for the widget sprite, drawing directly.");
+    }
+  } else {
+    widgetSprite.deleteSprite();
   }
+  shown.valid = false;
+}
+
+bool isSharedWeatherFresh() {
+  return sharedWeatherTime > 0 && timeStatus() == timeSet
+    && UTC.now() - sharedWeatherTime < (time_t) WEATHER_SHARE_STALE_CYCLES * updateWeatherForecastTimeout;
 }
 
 void fetchWeatherData() {
-  if (hasDisplay) {
-    wc.readWeatherData();
+  // followers only call the API themselves if the leader's data went stale
+  if (weatherLeader || (hasDisplay && !isSharedWeatherFresh())) {
+    wc.requestWeatherData();
+  }
+}
+
+void publishSharedWeather() {
+  // without synced time the followers can't tell the age of the data
+  if (!weatherLeader || wc.getWeatherData().fetched == 0) return;
+
+  char payload[MQTT_MESSAGE_SIZE];
+  wc.toLineProtocol(payload, sizeof(payload), nodeName.c_str());
+  mqttClient.publish(WEATHER_SHARE_TOPIC, payload, true);
+  log_printf(LOGMODULE_MQTT, LOGLEVEL_INFO, "MQTT shared weather: %s", payload);
+}
+
+// payload: weather,node=<node> icon="04n",temperature=7.54,...,fetched=1602956848i
+void receiveSharedWeather(const char *payload) {
+  if (weatherLeader) return;
+
+  WeatherData data;
+  if (!WeatherClient::fromLineProtocol(payload, data)) {
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_WARN, "MQTT shared weather data invalid.");
+    return;
+  }
+  if ((time_t) data.fetched <= sharedWeatherTime) return;
+
+  sharedWeatherTime = data.fetched;
+  wc.setWeatherData(data);
+  updateDisplay();
+}
+
+// payload: <measurand>,location=..,node=..,sensor=.. value=<value>
+void receiveRemoteValue(const char *topic, const char *payload) {
+  for (uint8_t i = 0; i < MAX_REMOTE_VALUES; ++i) {
+    RemoteValue &rv = remotes[i];
+    if (rv.topic[0] == '\0' || strcmp(topic, rv.topic) != 0) continue;
+
+    const char *value = findField(payload, "value");
+    if (value == nullptr) {
+      log_printf(LOGMODULE_MQTT, LOGLEVEL_WARN, "MQTT invalid remote value on %s", topic);
+      return;
+    }
+    copyToken(rv.measurand, sizeof(rv.measurand), payload);
+    copyToken(rv.value, sizeof(rv.value), value);
+    rv.updated = millis();
+    remotesVersion = nextStateVersion();
+
+    if (showSensor.equals(rv.source) || showOutdoor.equals(rv.source)) {
+      updateDisplay();
+    }
+  }
+}
+
+void onMqttMessage(char *topic, byte *payload, unsigned int length) {
+  char msg[MQTT_MESSAGE_SIZE];
+  unsigned int len = min(length, (unsigned int) sizeof(msg) - 1);
+  memcpy(msg, payload, len);
+  msg[len] = '\0';
+  if (strcmp(topic, WEATHER_SHARE_TOPIC) == 0) {
+    receiveSharedWeather(msg);
+  } else {
+    receiveRemoteValue(topic, msg);
+  }
+}
+
+void formatDisplayValue(char *buf, size_t size, const char *measurand, const char *value) {
+  float val = ::atof(value);
+  if (strcmp(measurand, "temperature") == 0) {
+    snprintf(buf, size, "%-.1f°C", val);
+  } else if (strcmp(measurand, "humidity") == 0) {
+    snprintf(buf, size, "%-.1f%%", val);
+  } else {
+    snprintf(buf, size, "???");
   }
 }
 
+// format a local sensor or a remote value, returns false if the source is unknown
+bool formatDisplaySource(char *buf, size_t size, const String& source) {
+  RemoteValue *rv = findRemoteValue(source);
+  if (rv != nullptr) {
+    if (rv->updated > 0) formatDisplayValue(buf, size, rv->measurand, rv->value);
+    return true;
+  }
+  SensorData &sd = getSensorData(source);
+  if (&sd == &tmpSensor) return false;
+  formatDisplayValue(buf, size, sd.measurand, sd.value);
+  return true;
+}
+
 void updateDisplay() {
+  LatencyProbe probe(sectionLatency[SECTION_DISPLAY]);
   if (hasDisplay) {
     char inVal[9] = "---.-°C"; // -xx.x°C
-    if (showSensor.length() > 0) {
-      SensorData sd = getSensorData(showSensor);
-      float val = ::atof(sd.value.c_str());
-      if (sd.measurand == "temperature") {
-        sprintf(inVal, "%-.1f°C", val);
-      } else if (sd.measurand == "humidity") {
-        sprintf(inVal, "%-.1f%%", val);
-      } else {
-        sprintf(inVal, "???");
-      }
+    if (showSensor.length() > 0 && !formatDisplaySource(inVal, sizeof(inVal), showSensor)) {
+      sprintf(inVal, "???");
     }
     
-    String outIcon = "wait.bmp";
+    const char *outIcon = "wait.bmp";
     char outTemp[9] = "---.-°C"; // -xx.x°C
     if (wc.isValid()) {
       sprintf(outTemp, "%-.1f°C", wc.getTemperature());
       outIcon = wc.getIcon();
     }
+    if (!showOutdoor.equals(OUTDOOR_OPENWEATHERMAP)) {
+      strcpy(outTemp, "---.-°C");
+      formatDisplaySource(outTemp, sizeof(outTemp), showOutdoor);
+    }
 
-    char timebuf[6];
-    sprintf(timebuf, "%02d:%02d", myTZ.hour(), myTZ.minute());
-    char datebuf[7];
-    sprintf(datebuf, "%02d.%02d.", myTZ.day(), myTZ.month());
-    display(tft, inVal, outTemp, outIcon.c_str(), timebuf, datebuf);
+    // room for 3 digit fields, as far as the compiler knows
+    char timebuf[8] = "--:--";
+    char datebuf[9] = "--.--.";
+    if (timeSynced) {
+      snprintf(timebuf, sizeof(timebuf), "%02d:%02d", myTZ.hour(), myTZ.minute());
+      snprintf(datebuf, sizeof(datebuf), "%02d.%02d.", myTZ.day(), myTZ.month());
+    }
+    display(tft, inVal, outTemp, outIcon, timebuf, datebuf);
   }
 }
 
 void update() {
   fetchSensorValues();
+  flushCapture();
   sendMQTTData();
   updateDisplay();
 }
 
+// --- Tasks ---
+void mqttTask() {
+  if (!mqttClient.connected()) {
+    mqttReconnect();
+  }
+  mqttClient.loop();
+}
+
+void weatherResponseTask() {
+  if (wc.loop()) {
+    publishSharedWeather();
+    updateDisplay();
+  }
+}
+
+void clockTask() {
+  ntp.loop();
+  events();
+  if (!timeSynced && timeStatus() != timeNotSet) {
+    timeSynced = true;
+    backfillLogTimes();
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "NTP sync done.");
+    updateDisplay();
+  }
+
+  // the clock widget is refreshed once per minute, all other widgets only change on update()
+  if (hasDisplay && minuteChanged()) {
+    updateDisplay();
+  }
+}
+
+void webTask() {
+  espServer.handleClient();
+}
+
+void otaTask() {
+  ArduinoOTA.handle();
+}
+
+void heapTask() {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxBlock = ESP.getMaxFreeBlockSize();
+  uint8_t fragmentation = ESP.getHeapFragmentation();
+  minFreeHeap = min(minFreeHeap, freeHeap);
+  minMaxBlock = min(minMaxBlock, maxBlock);
+  maxFragmentation = max(maxFragmentation, fragmentation);
+
+  // the RTC memory is only written if a mark changes
+  RtcHeap &rh = rtcState.heap;
+  uint32_t freeStack = ESP.getFreeContStack();
+  if (rh.minFreeHeap == 0 || freeHeap < rh.minFreeHeap || maxBlock < rh.minMaxBlock
+    || fragmentation > rh.maxFragmentation || freeStack < rh.minFreeStack) {
+    rh.minFreeHeap = rh.minFreeHeap == 0 ? freeHeap : min(rh.minFreeHeap, freeHeap);
+    rh.minMaxBlock = rh.minMaxBlock == 0 ? maxBlock : min(rh.minMaxBlock, maxBlock);
+    rh.minFreeStack = rh.minFreeStack == 0 ? freeStack : min(rh.minFreeStack, freeStack);
+    rh.maxFragmentation = max(rh.maxFragmentation, fragmentation);
+    writeRtcState();
+  }
+
+  if (heapLimit > 0 && heapLimit <= maxHeapLimit() && freeHeap < heapLimit) {
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_ERROR, "Free heap %lu < %lu bytes (max block %lu, fragmentation %u%%), restart.",
+      (unsigned long) freeHeap, (unsigned long) heapLimit, (unsigned long) maxBlock, fragmentation);
+    rh.restartCause = RESTART_LOW_HEAP;
+    writeRtcState();
+    flushLogFile();
+    ESP.restart();
+  }
+}
+
+// node + section + 6 values + fix + null
+// 30 + 20 + 6 * 10 + "latency,node=,section= count=i,min=i,max=i,avg=i,p50=i,p99=i" + 1 => 110 + 60 + 1 = 171
+#define STATSLINE_LENGTH 171
+
+void publishLatency(const char *topic, const LatencyHistogram &latency, const char *name) {
+  char line[STATSLINE_LENGTH];
+  int len = snprintf(line, STATSLINE_LENGTH, "latency,node=%s,section=%s count=%lui,min=%lui,max=%lui,avg=%lui,p50=%lui,p99=%lui",
+    nodeName.c_str(), name,
+    (unsigned long) latency.getCount(), (unsigned long) latency.getMin(), (unsigned long) latency.getMax(),
+    (unsigned long) latency.getAverage(), (unsigned long) latency.getPercentile(50), (unsigned long) latency.getPercentile(99));
+  // a cut line would publish a wrong p99, the node name is not limited
+  if (len < 0 || len >= STATSLINE_LENGTH) {
+    log_printf(LOGMODULE_MQTT, LOGLEVEL_WARN, "Stats line for %s too long", name);
+    return;
+  }
+  mqttClient.publish(topic, line);
+}
+
+// publish the latency of all tasks and sections to <root topic>/<node>/stats
+void statsTask() {
+  if (!publishStats || !mqttClient.connected()) return;
+
+  String topic = rootTopic + "." + nodeName + ".stats";
+  topic.replace(".", "/");
+  for (uint8_t i = 0; i < scheduler.getTaskCount(); ++i) {
+    publishLatency(topic.c_str(), scheduler.getTask(i).latency, scheduler.getTask(i).name);
+  }
+  for (uint8_t i = 0; i < SECTION_COUNT; ++i) {
+    publishLatency(topic.c_str(), sectionLatency[i], sectionNames[i]);
+  }
+}
+
+void onTaskOverrun(const Task &task, uint32_t duration) {
+  // log only new maximums, the web server or MQTT may overrun on every pass
+  if (duration < task.latency.getMax()) return;
+  log_printf(LOGMODULE_SYSTEM, LOGLEVEL_WARN, "Task %s overrun: %lu us (budget %lu us, %lu overruns)",
+    task.name, (unsigned long) duration, (unsigned long) task.budget, (unsigned long) task.overruns);
+}
+
+void logFileTask() {
+  logRepeatedSites();
+  flushLogFile();
+}
+
+void setupTasks() {
+  scheduler.setOverrunHandler(onTaskOverrun);
+  scheduler.add("heap", heapTask, HEAP_SAMPLE_CYCLE_MS, TASK_PRIORITY_HIGH, 0);
+  // the DS18B20 conversion alone takes 750ms
+  sensorTask = scheduler.add("sensors", update, updateSensorsTimeout * 1000, TASK_PRIORITY_HIGH, 1500000);
+  scheduler.add("mqtt", mqttTask, 0, TASK_PRIORITY_NORMAL, 100000);
+  weatherTask = scheduler.add("weather", fetchWeatherData, updateWeatherForecastTimeout * 1000, TASK_PRIORITY_NORMAL, 2500000);
+  scheduler.add("weather-rx", weatherResponseTask, 0, TASK_PRIORITY_NORMAL, 100000);
+  scheduler.add("clock", clockTask, 0, TASK_PRIORITY_LOW, 200000);
+  scheduler.add("web", webTask, 0, TASK_PRIORITY_LOW, 200000);
+  scheduler.add("ota", otaTask, 0, TASK_PRIORITY_LOW, 0);
+  scheduler.add("stats", statsTask, STATS_PUBLISH_CYCLE_SEC * 1000, TASK_PRIORITY_LOW, 0);
+  scheduler.add("logfile", logFileTask, LOGFILE_FLUSH_SEC * 1000, TASK_PRIORITY_LOW, 0);
+  scheduler.add("syslog", syslogTask, SYSLOG_FLUSH_SEC * 1000, TASK_PRIORITY_LOW, 0);
+}
+
 void setup(void) {
   for(uint8_t i=0; i<MAX_SENSORS; ++i) {
     sensors[i].enabled = false;
-    sensors[i].id = "";
-    sensors[i].type = "";
-    sensors[i].location = "";
-    sensors[i].topic=""; 
-    sensors[i].measurand = "";
-    sensors[i].value = "";
+    sensors[i].id[0] = '\0';
+    sensors[i].type[0] = '\0';
+    sensors[i].location[0] = '\0';
+    sensors[i].topic[0] = '\0'; 
+    sensors[i].measurand[0] = '\0';
+    sensors[i].value[0] = '\0';
     sensors[i].correction = 0.0f;
+    sensors[i].version = 0;
   }
 
   // start serial port
   Serial.begin(115200);
   Serial.println();
 
+  bool warmStart = readRtcState();
+  logIdsRestored = restoreRtcLog();
+  logFlushedId = logRing.getFirstId();
+  if (ESP.getResetInfoPtr()->reason != REASON_DEEP_SLEEP_AWAKE) {
+    recordBoot();
+  }
+#if SENSORNODE_DEEPSLEEP
+  if (warmStart && ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE && restoreRtcConfig()) {
+    deepSleepCycle(); // doesn't return
+  }
+#endif
+  if (!warmStart) {
+    writeRtcState();
+  }
+
   setupOneWireSensors();
   setupI2CSensors();
   setupAnalogSensor();
 
+  myTZ.setPosix(timezoneRules);
   loadConfig();
+  // the log ids are final now (initLogFile()), send from the first record in memory
+  syslogSentId = logRing.getFirstId();
+#if SENSORNODE_DEEPSLEEP
+  // the config didn't fit into the RTC memory, it is loaded as above, but a
+  // wake up doesn't open the config window
+  if (ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE) {
+    deepSleepCycle(); // doesn't return
+  }
+#endif
 
   setupDisplay();
 
@@ -1028,51 +2929,62 @@ void setup(void) {
   wifiManager.setConfigPortalTimeout(180);
   wifiManager.setDebugOutput(false);
 
-  log(LOGLEVEL_INFO, F("WIFI Try to connect ... "));
+  log_printf(LOGMODULE_WIFI, LOGLEVEL_INFO, "WIFI Try to connect ... ");
   if (hasDisplay) {
     tft.drawString("WIFI Try to connect ... ", 10, 5, FIXED_FONT);
   }
-  if(!wifiManager.autoConnect(DEFAULT_NODE_NAME)) {
-    log(LOGLEVEL_WARN, F("WIFI Failed to connect and hit timeout."));
+  if (!connectWifiFast() && !wifiManager.autoConnect(DEFAULT_NODE_NAME)) {
+    log_printf(LOGMODULE_WIFI, LOGLEVEL_WARN, "WIFI Failed to connect and hit timeout.");
+    flushLogFile();
     //reset and try again, or maybe put it to deep sleep
     ESP.reset();
     delay(5000);
   } 
+  storeWifiConnection();
 
   IPAddress myAddress = WiFi.localIP();
-  snprintf(logbuf, LOGLINE_LENGTH, "WIFI '%s' connected. IP: %s", WiFi.SSID().c_str(), myAddress.toString().c_str());
-  log(LOGLEVEL_INFO, logbuf);
+  char line[LOGLINE_LENGTH];
+  snprintf(line, sizeof(line), "WIFI '%s' connected. IP: %s", WiFi.SSID().c_str(), myAddress.toString().c_str());
+  log_printf(LOGMODULE_WIFI, LOGLEVEL_INFO, "%s", line);
   if (hasDisplay) {
-    tft.drawString(logbuf, 10, 5+12, FIXED_FONT);
+    tft.drawString(line, 10, 5+12, FIXED_FONT);
   }
 
-  debug_print(F("NTP Sync time ..."));
-  if (hasDisplay) {
-    tft.drawString("NTP Sync time ...", 10, 5+12+12, FIXED_FONT);
-  }
-  setServer(MY_NTP_SERVER);
-  waitForSync();
-	myTZ.setLocation(F("de"));
-  log(LOGLEVEL_INFO, F("NTP sync done."));
+  // NTP syncs in the background (clockTask), the time is set on the first sync
+  setInterval(0); // not ezTime, its update waits for the answer
+  ntp.setServer(MY_NTP_SERVER);
+  ntp.setInterval(NTP_SYNC_SEC);
 
-  espServer.on("/", HTTP_GET, handleGetRoot);
-  espServer.on("/config", HTTP_GET, handleGetConfig);
-  espServer.on("/sensors", HTTP_GET, handleGetSensors);
-  espServer.on("/logs", HTTP_GET, handleGetLogs);
+  onWeb("/", HTTP_GET, "GET /", handleGetRoot);
+  onWeb("/config", HTTP_GET, "GET /config", handleGetConfig);
+  onWeb("/sensors", HTTP_GET, "GET /sensors", handleGetSensors);
+  onWeb("/logs", HTTP_GET, "GET /logs", handleGetLogs);
+  onWeb("/state", HTTP_GET, "GET /state", handleGetState);
+  onWeb("/weather", HTTP_GET, "GET /weather", handleGetWeather);
+  onWeb("/stats", HTTP_GET, "GET /stats", handleGetStats);
+  onWeb("/capture", HTTP_GET, "GET /capture", handleGetCapture);
+  onWeb("/capture", HTTP_POST, "POST /capture", handlePostCapture);
 
-  espServer.on("/", HTTP_POST, handlePostRoot);
+  onWeb("/", HTTP_POST, "POST /", handlePostRoot);
 
-  espServer.onNotFound(handleError);
+  uint8_t notFoundIdx = addWebStats("not found");
+  espServer.onNotFound([notFoundIdx]() { runWebHandler(notFoundIdx, handleError); });
 
-  log(LOGLEVEL_INFO, F("WEB Server is configured."));
+  log_printf(LOGMODULE_WEB, LOGLEVEL_INFO, "WEB Server is configured.");
   espServer.begin();
 
   mqttClient.setServer(MQTT_SERVER, 1883);
-  snprintf(logbuf, LOGLINE_LENGTH, "MQTT Server is %s", MQTT_SERVER);
-  log(LOGLEVEL_INFO, logbuf);
+  espClient.setTimeout(MQTT_CONNECT_TIMEOUT_MS);
+  mqttClient.setCallback(onMqttMessage);
+  mqttClient.setBufferSize(MQTT_MESSAGE_SIZE + 64); // + header and topic
+  log_printf(LOGMODULE_MQTT, LOGLEVEL_INFO, "MQTT Server is %s", MQTT_SERVER);
   
-  timer1.start();
-  timer2.start();
+  bootFreeHeap = ESP.getFreeHeap();
+  if (heapLimit > maxHeapLimit()) {
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_WARN, "Heap limit %lu ignored, above %lu bytes.", (unsigned long) heapLimit, (unsigned long) maxHeapLimit());
+  }
+  setupTasks();
+  wc.setTtl(updateWeatherForecastTimeout);
 
   fetchWeatherData();
 
@@ -1086,17 +2998,17 @@ void setup(void) {
     String type;
     if (ArduinoOTA.getCommand() == U_FLASH) {
       type = "sketch";
-      log(LOGLEVEL_INFO, F("OTA Start updating program code"));
+      log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "OTA Start updating program code");
     } else {
       // U_FS
       type = "filesystem";
       LittleFS.end();
-      log(LOGLEVEL_INFO, F("OTA Start updating filesystem"));
+      log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "OTA Start updating filesystem");
     }
   });
 
   ArduinoOTA.onEnd([]() {
-    log(LOGLEVEL_INFO, F("OTA Finished."));
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "OTA Finished.");
   });
 
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
@@ -1120,18 +3032,16 @@ void setup(void) {
 
   ArduinoOTA.begin(false);
 
-  log(LOGLEVEL_INFO, "Setup finished.");
+  log_printf(LOGMODULE_SYSTEM, LOGLEVEL_INFO, "Setup finished.");
 }
 
 void loop(void) { 
-  ArduinoOTA.handle();
-  espServer.handleClient();
+  LatencyProbe probe(sectionLatency[SECTION_LOOP]);
+  scheduler.loop();
 
-  if (!mqttClient.connected()) {
-    mqttReconnect();
+#if SENSORNODE_DEEPSLEEP
+  if (millis() > DEEPSLEEP_CONFIG_WINDOW_SEC * 1000UL) {
+    goToSleep();
   }
-  mqttClient.loop();
-
-  timer1.update(); 
-  timer2.update(); 
+#endif
  }
@@ -0,0 +1,112 @@
+#include "ntpclient.h"
+#include <ezTime.h>
+
+// seconds from 1900 (NTP) to 1970 (Unix)
+#define NTP_UNIX_OFFSET 2208988800UL
+
+static void writeBE32(uint8_t *p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+static uint32_t readBE32(const uint8_t *p) {
+  return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+NtpClient::NtpClient() : _udpStarted(false), _resolved(false), _waiting(false), _sentMs(0), _nextMs(0),
+  _interval(NTP_DEFAULT_INTERVAL_SEC * 1000UL), _retry(NTP_RETRY_MIN_SEC * 1000UL), _timeouts(0), _requests(0), _failures(0), _roundTrip(0) {
+  _server[0] = '\0';
+}
+
+void NtpClient::setServer(const char *server) {
+  strlcpy(_server, server, sizeof(_server));
+  _resolved = false;
+}
+
+void NtpClient::setInterval(uint32_t seconds) {
+  _interval = seconds * 1000;
+}
+
+void NtpClient::update() {
+  _nextMs = millis();
+}
+
+bool NtpClient::loop() {
+  if (_waiting) {
+    if (receive()) {
+      _waiting = false;
+      _timeouts = 0;
+      _retry = NTP_RETRY_MIN_SEC * 1000UL;
+      _nextMs = millis() + _interval;
+      return true;
+    }
+    if (millis() - _sentMs >= NTP_TIMEOUT_MS) {
+      _waiting = false;
+      // the server may have moved, but a lookup blocks
+      if (++_timeouts >= NTP_RESOLVE_AFTER_TIMEOUTS) {
+        _timeouts = 0;
+        _resolved = false;
+      }
+      fail();
+    }
+    return false;
+  }
+
+  if ((int32_t) (millis() - _nextMs) < 0 || _server[0] == '\0') return false;
+  if (WiFi.status() != WL_CONNECTED || !send()) {
+    fail();
+  }
+  return false;
+}
+
+void NtpClient::fail() {
+  ++_failures;
+  _nextMs = millis() + _retry;
+  _retry = min(_retry * 2, (uint32_t) NTP_RETRY_MAX_SEC * 1000);
+}
+
+bool NtpClient::send() {
+  if (!_resolved) {
+    _resolved = WiFi.hostByName(_server, _ip);
+    if (!_resolved) return false;
+  }
+  if (!_udpStarted) {
+    _udpStarted = _udp.begin(NTP_LOCAL_PORT);
+    if (!_udpStarted) return false;
+  }
+  while (_udp.parsePacket() > 0) {} // a late answer to an earlier request
+
+  uint8_t packet[NTP_PACKET_SIZE];
+  memset(packet, 0, sizeof(packet));
+  packet[0] = 0x23; // version 4, client
+  // the transmit time is only a cookie, the server copies it into the answer
+  _sentMs = millis();
+  writeBE32(packet + 40, ++_requests);
+  writeBE32(packet + 44, _sentMs);
+  if (!_udp.beginPacket(_ip, NTP_PORT)) return false;
+  _udp.write(packet, sizeof(packet));
+  if (!_udp.endPacket()) return false;
+  _waiting = true;
+  return true;
+}
+
+bool NtpClient::receive() {
+  uint8_t packet[NTP_PACKET_SIZE];
+  while (_udp.parsePacket() > 0) {
+    if (_udp.read(packet, sizeof(packet)) != NTP_PACKET_SIZE) continue;
+    // a server answer to this request, stratum 0 is a kiss-o'-death
+    if ((packet[0] & 0x07) != 4 || packet[1] == 0
+      || readBE32(packet + 24) != _requests || readBE32(packet + 28) != _sentMs) continue;
+
+    _roundTrip = millis() - _sentMs;
+    uint32_t seconds = readBE32(packet + 40);
+    uint32_t fraction = readBE32(packet + 44);
+    uint32_t ms = (uint32_t) (((uint64_t) fraction * 1000) >> 32) + _roundTrip / 2;
+    time_t t = seconds - NTP_UNIX_OFFSET + ms / 1000;
+    UTC.setTime(t, ms % 1000);
+    return true;
+  }
+  return false;
+}
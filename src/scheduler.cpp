@@ -0,0 +1,99 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler() : _count(0), _overrunHandler(nullptr) {
+}
+
+int8_t Scheduler::add(const char *name, TaskFunction function, uint32_t interval, uint8_t priority, uint32_t budget) {
+  if (_count >= SCHEDULER_MAX_TASKS) return -1;
+
+  int8_t id = _count;
+  Task &task = _tasks[id];
+  task = Task();
+  task.name = name;
+  task.function = function;
+  task.interval = interval;
+  task.nextRun = millis() + interval;
+  task.budget = budget;
+  task.priority = priority;
+  task.enabled = true;
+
+  // insert behind all tasks with the same or a higher priority
+  uint8_t pos = _count;
+  while (pos > 0 && _tasks[_order[pos - 1]].priority > priority) {
+    _order[pos] = _order[pos - 1];
+    --pos;
+  }
+  _order[pos] = id;
+  ++_count;
+  return id;
+}
+
+void Scheduler::setEnabled(int8_t id, bool enabled) {
+  if (id < 0 || id >= _count) return;
+  if (enabled && !_tasks[id].enabled) {
+    _tasks[id].nextRun = millis() + _tasks[id].interval;
+  }
+  _tasks[id].enabled = enabled;
+}
+
+void Scheduler::setInterval(int8_t id, uint32_t interval) {
+  if (id < 0 || id >= _count) return;
+  _tasks[id].interval = interval;
+  _tasks[id].nextRun = millis() + interval;
+}
+
+void Scheduler::setOverrunHandler(OverrunHandler handler) {
+  _overrunHandler = handler;
+}
+
+void Scheduler::resetLatency() {
+  for (uint8_t i = 0; i < _count; ++i) {
+    _tasks[i].latency.reset();
+  }
+}
+
+void Scheduler::loop() {
+  for (uint8_t i = 0; i < _count; ++i) {
+    Task &task = _tasks[_order[i]];
+    if (!task.enabled || task.running) continue;
+
+    uint32_t now = millis();
+    if ((int32_t) (now - task.nextRun) < 0) continue;
+
+    if (task.interval > 0) {
+      task.nextRun += task.interval;
+      if ((int32_t) (now - task.nextRun) >= 0) {
+        // skip the missed deadlines, but stay in phase
+        uint32_t missed = (now - task.nextRun) / task.interval + 1;
+        task.nextRun += missed * task.interval;
+      }
+    }
+    run(task);
+  }
+}
+
+void Scheduler::run(Task &task) {
+  uint32_t start = micros();
+  task.running = true;
+  task.function();
+  task.running = false;
+  uint32_t duration = micros() - start;
+
+  ++task.runs;
+  task.lastDuration = duration;
+  task.latency.record(duration);
+  if (task.budget > 0 && duration > task.budget) {
+    ++task.overruns;
+    if (_overrunHandler) {
+      _overrunHandler(task, duration);
+    }
+  }
+}
+
+uint8_t Scheduler::getTaskCount() {
+  return _count;
+}
+
+const Task& Scheduler::getTask(uint8_t idx) {
+  return _tasks[idx < _count ? idx : 0];
+}
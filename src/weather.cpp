@@ -1,81 +1,212 @@
 #include "weather.h"
 #include "secret.h"
+#include "lineprotocol.h"
+#include <ezTime.h>
 
 String cityId = OPENWEATHERMAP_CITYID;
 String apiKey = OPENWEATHERMAP_APIKEY;
 String apiSrv = OPENWEATHERMAP_SRV;
 
-WeatherClient::WeatherClient(WiFiClient* client) : _client(client) {
+#define HTTP_HEADER_END "\r\n\r\n"
+// connecting blocks for at most this time, waiting for the header/body not at all
+// The server address is looked up once and again only after a failed connect.
+#define WEATHER_CONNECT_TIMEOUT_MS 2000
+#define WEATHER_STATE_TIMEOUT_MS 10000
+
+WeatherClient::WeatherClient() : _state(IDLE), _stateStart(0), _headerEndMatch(0), _parser(onJsonValue, this), _resolved(false), _updated(0), _ttl(0) {
+  memset(&_data, 0, sizeof(_data));
+  _client.setTimeout(WEATHER_CONNECT_TIMEOUT_MS);
 }
 
 WeatherClient::~WeatherClient() {
 }
 
 bool WeatherClient::isValid() {
-  return icon.length() > 0;
+  return _data.icon[0] != '\0';
+}
+
+void WeatherClient::setTtl(uint32_t seconds) {
+  _ttl = seconds;
+}
+
+bool WeatherClient::isExpired() {
+  return !isValid() || getAge() >= _ttl;
+}
+
+uint32_t WeatherClient::getAge() {
+  // shared data may have been fetched long before it arrived here
+  if (_data.fetched != 0 && timeStatus() != timeNotSet) {
+    time_t now = UTC.now();
+    return (time_t) _data.fetched < now ? now - _data.fetched : 0;
+  }
+  return (millis() - _updated) / 1000;
+}
+
+// example: {
+//   "coord":{"lon":x.xx,"lat":xx.xx},
+//   "weather":[{"id":804,"main":"Clouds","description":"overcast clouds","icon":"04n"}],
+//   "base":"stations",
+//   "main":{"temp":280.69,"feels_like":279.16,"temp_min":279.82,"temp_max":282.59,"pressure":1020,"humidity":86},
+//   "visibility":10000,
+//   "wind":{"speed":0.68,"deg":32},
+//   "clouds":{"all":92},
+//   "dt":1602956848,
+//   "sys":{"type":3,"id":2035315,"country":"DE","sunrise":1602914215,"sunset":1602952394},
+//   "timezone":7200,
+//   "id":city_id,
+//   "name":"xxxxxxxx",
+//   "cod":200
+// }
+void WeatherClient::onJsonValue(void *context, const char *path, const char *value) {
+  WeatherData &d = ((WeatherClient *) context)->_pending;
+  if (strcmp(path, "weather[0].icon") == 0) {
+    snprintf(d.icon, WEATHER_ICON_LENGTH, "%.3s.bmp", value);
+  } else if (strcmp(path, "main.temp") == 0) {
+    d.temperature = atof(value) - 273.15;
+    ((WeatherClient *) context)->_hasTemperatur = true;
+  } else if (strcmp(path, "main.feels_like") == 0) {
+    d.feelsLike = atof(value) - 273.15;
+  } else if (strcmp(path, "main.pressure") == 0) {
+    d.pressure = atof(value);
+  } else if (strcmp(path, "main.humidity") == 0) {
+    d.humidity = atoi(value);
+  } else if (strcmp(path, "wind.speed") == 0) {
+    d.windSpeed = atof(value);
+  } else if (strcmp(path, "wind.deg") == 0) {
+    d.windDeg = atoi(value);
+  } else if (strcmp(path, "clouds.all") == 0) {
+    d.clouds = atoi(value);
+  } else if (strcmp(path, "sys.sunrise") == 0) {
+    d.sunrise = strtoul(value, nullptr, 10);
+  } else if (strcmp(path, "sys.sunset") == 0) {
+    d.sunset = strtoul(value, nullptr, 10);
+  } else if (strcmp(path, "dt") == 0) {
+    d.dt = strtoul(value, nullptr, 10);
+  }
+}
+
+bool WeatherClient::isBusy() {
+  return _state != IDLE;
+}
+
+void WeatherClient::setState(State state) {
+  _state = state;
+  _stateStart = millis();
 }
 
-void WeatherClient::readWeatherData() {
-  
-  if (_client->connect(apiSrv, 80)) {
-    _client->println("GET /data/2.5/weather?id="+cityId+"&appid="+apiKey);
-    _client->println("Host: "+apiSrv);
-    _client->println("User-Agent: ESP8266/1.0");
-    _client->println("Connection: close");
-    _client->println();
+void WeatherClient::requestWeatherData() {
+  if (_state != IDLE) return;
+
+  if (!_resolved) {
+    _resolved = WiFi.hostByName(apiSrv.c_str(), _ip);
+    if (!_resolved) {
+      Serial.println("OpenWeatherApi lookup failed!");
+      return;
+    }
+  }
+  if (_client.connect(_ip, 80)) {
+    _client.println("GET /data/2.5/weather?id="+cityId+"&appid="+apiKey+" HTTP/1.0");
+    _client.println("Host: "+apiSrv);
+    _client.println("User-Agent: ESP8266/1.0");
+    _client.println("Connection: close");
+    _client.println();
   } else {
     Serial.println("OpenWeatherApi connection failed!");
+    _resolved = false; // the server may have moved
     return;
   }
 
-  // reading sent data
-  while(_client->connected() && !_client->available()) delay(1); //waits for data
-  
-  String payload = String("");
-  // Serial.println("Waiting for data");
-
-  while (_client->connected() && _client->available()) { 
-    int c = _client->read();
-    if (c >= 32) {
-      payload += (char) c;
-    } else if (c == '\n') {
-      payload += (char) c;
+  _parser.reset();
+  memset(&_pending, 0, sizeof(_pending));
+  _hasTemperatur = false;
+  _headerEndMatch = 0;
+  setState(HEADERS);
+}
+
+bool WeatherClient::loop() {
+  if (_state == IDLE) return false;
+
+  // only consume what has already arrived
+  int cnt = _client.available();
+  while (cnt-- > 0 && _state != IDLE) {
+    char c = (char) _client.read();
+    if (_state == HEADERS) {
+      _headerEndMatch = (c == HTTP_HEADER_END[_headerEndMatch]) ? _headerEndMatch + 1 : (c == '\r' ? 1 : 0);
+      if (_headerEndMatch == sizeof(HTTP_HEADER_END) - 1) setState(BODY);
+    } else {
+      _parser.feed(c);
+      if (_parser.isDone() || _parser.hasError()) return finish();
     }
   }
 
-  //Serial.printf("Got data: %s\n", payload.c_str());
-
-  // example: {
-  //   "coord":{"lon":x.xx,"lat":xx.xx},
-  //   "weather":[{"id":804,"main":"Clouds","description":"overcast clouds","icon":"04n"}],
-  //   "base":"stations",
-  //   "main":{"temp":280.69,"feels_like":279.16,"temp_min":279.82,"temp_max":282.59,"pressure":1020,"humidity":86},
-  //   "visibility":10000,
-  //   "wind":{"speed":0.68,"deg":32},
-  //   "clouds":{"all":92},
-  //   "dt":1602956848,
-  //   "sys":{"type":3,"id":2035315,"country":"DE","sunrise":1602914215,"sunset":1602952394},
-  //   "timezone":7200,
-  //   "id":city_id,
-  //   "name":"xxxxxxxx",
-  //   "cod":200
-  // }
-  
-  int beginIdx = payload.indexOf("\"icon\":\"", payload.indexOf("\"weather\""));
-  if (beginIdx > 0) {
-    beginIdx += 8;
-    icon = payload.substring(beginIdx, beginIdx+3) + ".bmp";
-    beginIdx = payload.indexOf("\"temp\":", payload.indexOf("\"main\":"));
-    beginIdx += 7;
-    int endIdx = min(payload.indexOf(",",beginIdx), payload.indexOf("}",beginIdx));
-    temperatur = payload.substring(beginIdx, endIdx).toFloat() - 273.15;
-  } 
-}
-
-const String WeatherClient::getIcon() { 
-  return icon;
+  if (!_client.connected() && !_client.available()) {
+    return finish();
+  }
+  if (millis() - _stateStart > WEATHER_STATE_TIMEOUT_MS) {
+    Serial.println("OpenWeatherApi response timed out!");
+    return finish();
+  }
+  return false;
+}
+
+bool WeatherClient::finish() {
+  _client.stop();
+  setState(IDLE);
+
+  if (_pending.icon[0] != '\0' && _hasTemperatur) {
+    _pending.fetched = (timeStatus() == timeSet) ? UTC.now() : 0;
+    setWeatherData(_pending);
+    return true;
+  }
+  Serial.println("OpenWeatherApi response incomplete!");
+  return false;
+}
+
+void WeatherClient::setWeatherData(const WeatherData &data) {
+  _data = data;
+  _updated = millis();
+}
+
+const WeatherData& WeatherClient::getWeatherData() {
+  return _data;
+}
+
+const char* WeatherClient::getIcon() { 
+  return _data.icon;
 }
 
 const float WeatherClient::getTemperature() {
-  return temperatur;
-}
\ No newline at end of file
+  return _data.temperature;
+}
+
+size_t WeatherClient::toLineProtocol(char *buf, size_t size, const char *node) {
+  return snprintf(buf, size, "weather,node=%s icon=\"%.3s\",temperature=%.2f,feels_like=%.2f,pressure=%.1f,humidity=%ui,"
+    "wind_speed=%.2f,wind_deg=%ui,clouds=%ui,sunrise=%lui,sunset=%lui,dt=%lui,fetched=%lui",
+    node, _data.icon, _data.temperature, _data.feelsLike, _data.pressure, _data.humidity,
+    _data.windSpeed, _data.windDeg, _data.clouds, (unsigned long) _data.sunrise, (unsigned long) _data.sunset,
+    (unsigned long) _data.dt, (unsigned long) _data.fetched);
+}
+
+bool WeatherClient::fromLineProtocol(const char *line, WeatherData &data) {
+  const char *icon = findField(line, "icon");
+  const char *temperature = findField(line, "temperature");
+  const char *fetched = findField(line, "fetched");
+  if (icon == nullptr || temperature == nullptr || fetched == nullptr) return false;
+
+  memset(&data, 0, sizeof(data));
+  snprintf(data.icon, WEATHER_ICON_LENGTH, "%.3s.bmp", icon + 1); // skip quote
+  data.temperature = atof(temperature);
+  data.fetched = strtoul(fetched, nullptr, 10);
+
+  const char *v;
+  if ((v = findField(line, "feels_like")) != nullptr) data.feelsLike = atof(v);
+  if ((v = findField(line, "pressure")) != nullptr) data.pressure = atof(v);
+  if ((v = findField(line, "humidity")) != nullptr) data.humidity = atoi(v);
+  if ((v = findField(line, "wind_speed")) != nullptr) data.windSpeed = atof(v);
+  if ((v = findField(line, "wind_deg")) != nullptr) data.windDeg = atoi(v);
+  if ((v = findField(line, "clouds")) != nullptr) data.clouds = atoi(v);
+  if ((v = findField(line, "sunrise")) != nullptr) data.sunrise = strtoul(v, nullptr, 10);
+  if ((v = findField(line, "sunset")) != nullptr) data.sunset = strtoul(v, nullptr, 10);
+  if ((v = findField(line, "dt")) != nullptr) data.dt = strtoul(v, nullptr, 10);
+  return true;
+}
@@ -0,0 +1,19 @@
+#ifndef _fake_adafruit_bme280_h_
+#define _fake_adafruit_bme280_h_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <math.h>
+#include "fakesensors.h"
+
+class Adafruit_BME280 {
+
+    public:
+        bool begin(uint8_t addr = 0x77) { return fake::bme280.present && fake::bme280.address == addr; }
+        float readTemperature() { ++fake::bme280.reads; return fake::bme280.temperature; }
+        float readHumidity() { ++fake::bme280.reads; return fake::bme280.humidity; }
+        float readPressure() { ++fake::bme280.reads; return fake::bme280.pressure; }
+        float seaLevelForAltitude(float altitude, float atmospheric) { return atmospheric / pow(1.0 - (altitude / 44330.0), 5.255); }
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _fake_adafruit_htu21df_h_
+#define _fake_adafruit_htu21df_h_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "fakesensors.h"
+
+class Adafruit_HTU21DF {
+
+    public:
+        bool begin() { return fake::htu21.present; }
+        float readTemperature() { ++fake::htu21.reads; return fake::htu21.temperature; }
+        float readHumidity() { ++fake::htu21.reads; return fake::htu21.humidity; }
+};
+
+#endif
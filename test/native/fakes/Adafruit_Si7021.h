@@ -0,0 +1,19 @@
+#ifndef _fake_adafruit_si7021_h_
+#define _fake_adafruit_si7021_h_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "fakesensors.h"
+
+enum si_sensorType { SI_Engineering_Samples, SI_7013, SI_7020, SI_7021, SI_UNKNOWN };
+
+class Adafruit_Si7021 {
+
+    public:
+        bool begin() { return fake::si70xx.present; }
+        float readTemperature() { ++fake::si70xx.reads; return fake::si70xx.temperature; }
+        float readHumidity() { ++fake::si70xx.reads; return fake::si70xx.humidity; }
+        si_sensorType getModel() { return (si_sensorType) fake::si70xx.model; }
+};
+
+#endif
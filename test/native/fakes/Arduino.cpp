@@ -0,0 +1,209 @@
+#include "Arduino.h"
+
+#include <arpa/inet.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace fake {
+  uint64_t clockMicros = 0;
+  uint64_t randomState = 0x9E3779B97F4A7C15ull;
+  int analogValue = 512;
+  bool serialQuiet = false;
+
+  void setMillis(uint32_t ms) {
+    clockMicros = (uint64_t) ms * 1000;
+  }
+
+  void advance(uint32_t ms) {
+    clockMicros += (uint64_t) ms * 1000;
+  }
+
+  void advanceMicros(uint32_t us) {
+    clockMicros += us;
+  }
+
+  void powerOn() {
+    ESP = EspClass();
+    clockMicros = 0;
+  }
+}
+
+unsigned long millis() {
+  return (uint32_t) (fake::clockMicros / 1000);
+}
+
+unsigned long micros() {
+  return (uint32_t) fake::clockMicros;
+}
+
+void delay(unsigned long ms) {
+  fake::advance(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+  fake::advanceMicros(us);
+}
+
+void yield() {
+}
+
+// xorshift64*, reproducible for a seed
+static uint32_t nextRandom() {
+  uint64_t &x = fake::randomState;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  return (uint32_t) ((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+long random(long howbig) {
+  return howbig <= 0 ? 0 : nextRandom() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  fake::randomState = seed == 0 ? 0x9E3779B97F4A7C15ull : seed;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void) pin;
+  (void) mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void) pin;
+  (void) value;
+}
+
+int digitalRead(uint8_t pin) {
+  (void) pin;
+  return HIGH;
+}
+
+int analogRead(uint8_t pin) {
+  (void) pin;
+  return fake::analogValue;
+}
+
+// --- Print / Stream ---
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size-- > 0 && write(*buffer++) == 1) ++n;
+  return n;
+}
+
+static size_t vprint(Print &out, const char *format, va_list args) {
+  char buf[128];
+  va_list copy;
+  va_copy(copy, args);
+  int len = vsnprintf(buf, sizeof(buf), format, copy);
+  va_end(copy);
+  if (len < 0) return 0;
+  if ((size_t) len < sizeof(buf)) return out.write((const uint8_t *) buf, len);
+
+  char *big = (char *) malloc(len + 1);
+  if (big == nullptr) return 0;
+  vsnprintf(big, len + 1, format, args);
+  size_t n = out.write((const uint8_t *) big, len);
+  free(big);
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprint(*this, format, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printf_P(PGM_P format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprint(*this, format, args);
+  va_end(args);
+  return n;
+}
+
+// the host streams never wait for more data
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = read();
+    if (c < 0) break;
+    buffer[n++] = (char) c;
+  }
+  return n;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = read();
+    if (c < 0 || c == terminator) break;
+    buffer[n++] = (char) c;
+  }
+  return n;
+}
+
+String Stream::readString() {
+  String s;
+  int c;
+  while ((c = read()) >= 0) s.concat((char) c);
+  return s;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String s;
+  int c;
+  while ((c = read()) >= 0 && c != terminator) s.concat((char) c);
+  return s;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (!fake::serialQuiet) fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+// --- IPAddress ---
+bool IPAddress::fromString(const char *address) {
+  struct in_addr addr;
+  if (inet_pton(AF_INET, address, &addr) != 1) return false;
+  _address = addr.s_addr;
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  return String(buf);
+}
+
+// --- ESP ---
+EspClass::EspClass() : freeHeap(40000), maxFreeBlock(30000), heapFragmentation(10), freeContStack(3000),
+  chipId(0x00C0FFEE), sketchSize(400000), restarts(0), deepSleeps(0), deepSleepUs(0) {
+  memset(&resetInfo, 0, sizeof(resetInfo));
+  resetInfo.reason = REASON_DEFAULT_RST;
+  memset(rtcMemory, 0, sizeof(rtcMemory));
+}
+
+// offset in 4 byte blocks, as on the device
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size) {
+  if (offset * 4 + size > sizeof(rtcMemory)) return false;
+  memcpy(data, rtcMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size) {
+  if (offset * 4 + size > sizeof(rtcMemory)) return false;
+  memcpy(rtcMemory + offset * 4, data, size);
+  return true;
+}
@@ -0,0 +1,215 @@
+#ifndef _fake_arduino_h_
+#define _fake_arduino_h_
+
+// Host stand-in for the parts of the ESP8266 Arduino core the firmware uses.
+// The clock is virtual: millis() only moves with delay() or fake::advance(),
+// so a test controls every timeout and schedule.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+#include "pgmspace.h"
+#include "WString.h"
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F(s) ((const __FlashStringHelper *) (s))
+#define FPSTR(p) ((const __FlashStringHelper *) (p))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LOW 0
+#define HIGH 1
+#define A0 17
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+class Print {
+
+    public:
+        virtual ~Print() {}
+
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        size_t write(const char *str) { return str == nullptr ? 0 : write((const uint8_t *) str, strlen(str)); }
+        size_t write(const char *buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+
+        size_t print(const __FlashStringHelper *str) { return write((const char *) str); }
+        size_t print(const String &str) { return write(str.c_str(), str.length()); }
+        size_t print(const char *str) { return write(str); }
+        size_t print(char c) { return write((uint8_t) c); }
+        size_t print(int value, int base = 10) { return print((long) value, base); }
+        size_t print(unsigned int value, int base = 10) { return print((unsigned long) value, base); }
+        size_t print(long value, int base = 10) { return print(String(value, (unsigned char) base)); }
+        size_t print(unsigned long value, int base = 10) { return print(String(value, (unsigned char) base)); }
+        size_t print(double value, int digits = 2) { return print(String(value, (unsigned char) digits)); }
+
+        size_t println() { return write("\r\n"); }
+        template <typename T> size_t println(const T &value) { return print(value) + println(); }
+        template <typename T> size_t println(const T &value, int format) { return print(value, format) + println(); }
+
+        size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+        size_t printf_P(PGM_P format, ...);
+
+        virtual void flush() {}
+};
+
+class Stream : public Print {
+
+    public:
+        Stream() : _timeout(1000) {}
+
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        void setTimeout(unsigned long timeout) { _timeout = timeout; }
+        unsigned long getTimeout() const { return _timeout; }
+
+        virtual size_t readBytes(char *buffer, size_t length);
+        size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *) buffer, length); }
+        size_t readBytesUntil(char terminator, char *buffer, size_t length);
+        String readString();
+        String readStringUntil(char terminator);
+
+    protected:
+        unsigned long _timeout;
+};
+
+// writes to stdout, fake::serialQuiet drops the output
+class HardwareSerial : public Stream {
+
+    public:
+        void begin(unsigned long baud) { (void) baud; }
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int available() override { return 0; }
+        int read() override { return -1; }
+        int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+class IPAddress {
+
+    public:
+        IPAddress() : _address(0) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | b << 8 | c << 16 | (uint32_t) d << 24) {}
+        IPAddress(uint32_t address) : _address(address) {}
+
+        operator uint32_t() const { return _address; }
+        uint8_t operator[](int idx) const { return (_address >> (idx * 8)) & 0xFF; }
+        bool operator==(const IPAddress &rhs) const { return _address == rhs._address; }
+        bool isSet() const { return _address != 0; }
+
+        bool fromString(const char *address);
+        String toString() const;
+
+    protected:
+        uint32_t _address; // network byte order, as lwIP keeps it
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1;
+  uint32_t epc2;
+  uint32_t epc3;
+  uint32_t excvaddr;
+  uint32_t depc;
+};
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+enum RFMode { RF_DEFAULT = 0, RF_CAL = 1, RF_NO_CAL = 2, RF_DISABLED = 4 };
+
+#define FAKE_RTC_USER_MEMORY 512
+
+// ESP with the RTC user memory, heap figures set by the test and counters
+// for restart() and deepSleep(), which return on the host
+class EspClass {
+
+    public:
+        EspClass();
+
+        void restart() { ++restarts; }
+        void reset() { ++restarts; }
+        void deepSleep(uint64_t us, RFMode mode = RF_DEFAULT) { (void) mode; ++deepSleeps; deepSleepUs = us; }
+
+        uint32_t getFreeHeap() { return freeHeap; }
+        uint32_t getMaxFreeBlockSize() { return maxFreeBlock; }
+        uint8_t getHeapFragmentation() { return heapFragmentation; }
+        uint32_t getFreeContStack() { return freeContStack; }
+        uint32_t getChipId() { return chipId; }
+        uint32_t getSketchSize() { return sketchSize; }
+        rst_info* getResetInfoPtr() { return &resetInfo; }
+
+        bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+        bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+
+        // test control
+        uint32_t freeHeap;
+        uint32_t maxFreeBlock;
+        uint8_t heapFragmentation;
+        uint32_t freeContStack;
+        uint32_t chipId;
+        uint32_t sketchSize;
+        rst_info resetInfo;
+        uint32_t restarts;
+        uint32_t deepSleeps;
+        uint64_t deepSleepUs;
+        uint8_t rtcMemory[FAKE_RTC_USER_MEMORY];
+};
+
+extern EspClass ESP;
+
+namespace fake {
+  // the virtual clock
+  extern uint64_t clockMicros;
+  void setMillis(uint32_t ms);
+  void advance(uint32_t ms);
+  void advanceMicros(uint32_t us);
+  // value of analogRead(A0)
+  extern int analogValue;
+  // suppress Serial output
+  extern bool serialQuiet;
+  // a power on: RTC memory cleared, counters reset, clock at 0
+  void powerOn();
+}
+
+#endif
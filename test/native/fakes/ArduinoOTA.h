@@ -0,0 +1,48 @@
+#ifndef _fake_arduinoota_h_
+#define _fake_arduinoota_h_
+
+#include <Arduino.h>
+
+#include <functional>
+
+#define U_FLASH 0
+#define U_FS 100
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR
+} ota_error_t;
+
+// No updates are offered, the callbacks are kept for tests that call them.
+class ArduinoOTAClass {
+
+    public:
+        typedef std::function<void(void)> THandlerFunction;
+        typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+        typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+        void setPort(uint16_t port) { (void) port; }
+        void setHostname(const char *hostname) { (void) hostname; }
+        void setPassword(const char *password) { (void) password; }
+        void setPasswordHash(const char *hash) { (void) hash; }
+        void onStart(THandlerFunction fn) { startCallback = fn; }
+        void onEnd(THandlerFunction fn) { endCallback = fn; }
+        void onError(THandlerFunction_Error fn) { errorCallback = fn; }
+        void onProgress(THandlerFunction_Progress fn) { progressCallback = fn; }
+        void begin(bool useMDNS = true) { (void) useMDNS; }
+        void handle() {}
+        int getCommand() { return command; }
+
+        int command = U_FLASH;
+        THandlerFunction startCallback;
+        THandlerFunction endCallback;
+        THandlerFunction_Error errorCallback;
+        THandlerFunction_Progress progressCallback;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef _fake_dnsserver_h_
+#define _fake_dnsserver_h_
+
+#include <Arduino.h>
+
+class DNSServer {
+
+    public:
+        void processNextRequest() {}
+        void stop() {}
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _fake_dallastemperature_h_
+#define _fake_dallastemperature_h_
+
+#include <Arduino.h>
+#include <OneWire.h>
+#include "fakesensors.h"
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+class DallasTemperature {
+
+    public:
+        DallasTemperature(OneWire *wire) : _wire(wire), _devices(0), _wait(true), _conversionStart(0) {}
+
+        // the devices on the bus are counted here, as the library does
+        void begin() { _devices = fake::oneWireDeviceCount; }
+        uint8_t getDeviceCount() { return _devices; }
+        bool getAddress(uint8_t *addr, uint8_t index);
+        void setWaitForConversion(bool wait) { _wait = wait; }
+        bool getWaitForConversion() { return _wait; }
+        void requestTemperatures();
+        bool isConversionComplete() { return millis() - _conversionStart >= fake::conversionMs; }
+        float getTempC(const uint8_t *addr);
+
+    protected:
+        OneWire *_wire;
+        uint8_t _devices;
+        bool _wait;
+        uint32_t _conversionStart;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "ESP8266WebServer.h"
+
+#define FAKE_WEB_RESPONSE_RESERVE (64 * 1024)
+
+ESP8266WebServer::ESP8266WebServer(int port) : responseCode(0), chunked(false), requests(0), _pending(false),
+  _method(HTTP_GET), _argCount(0) {
+  (void) port;
+  contentType[0] = '\0';
+  location[0] = '\0';
+  body.reserve(FAKE_WEB_RESPONSE_RESERVE);
+  for (String &s : _argNames) s.reserve(64);
+  for (String &s : _argValues) s.reserve(1024);
+  _uri.reserve(64);
+}
+
+void ESP8266WebServer::on(const char *uri, HTTPMethod method, THandlerFunction handler) {
+  _routes.push_back(Route{ uri, method, handler });
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// url decoded into a reserved String, so it doesn't allocate
+static void decodeInto(String &out, const char *src, size_t length) {
+  out = "";
+  for (size_t i = 0; i < length; ++i) {
+    char c = src[i];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && i + 2 < length && hexValue(src[i + 1]) >= 0 && hexValue(src[i + 2]) >= 0) {
+      c = (char) (hexValue(src[i + 1]) << 4 | hexValue(src[i + 2]));
+      i += 2;
+    }
+    out.concat(c);
+  }
+}
+
+void ESP8266WebServer::addArg(const char *name, size_t nameLength, const char *value, size_t valueLength) {
+  if (_argCount == FAKE_WEB_MAX_ARGS) return;
+  decodeInto(_argNames[_argCount], name, nameLength);
+  decodeInto(_argValues[_argCount], value, valueLength);
+  ++_argCount;
+}
+
+void ESP8266WebServer::parseArgs(const char *query) {
+  while (query != nullptr && *query != '\0') {
+    const char *end = strchr(query, '&');
+    size_t len = end != nullptr ? (size_t) (end - query) : strlen(query);
+    const char *eq = (const char *) memchr(query, '=', len);
+    if (eq != nullptr) {
+      addArg(query, eq - query, eq + 1, len - (eq - query) - 1);
+    } else if (len > 0) {
+      addArg(query, len, "", 0);
+    }
+    query = end != nullptr ? end + 1 : nullptr;
+  }
+}
+
+void ESP8266WebServer::queueRequest(HTTPMethod method, const char *uri, const char *query, const char *body) {
+  _method = method;
+  _uri = uri;
+  _argCount = 0;
+  parseArgs(query);
+  if (body != nullptr) {
+    parseArgs(body);
+    addArg("plain", 5, body, strlen(body));
+  }
+  _pending = true;
+}
+
+int ESP8266WebServer::request(HTTPMethod method, const char *uri, const char *query, const char *body) {
+  queueRequest(method, uri, query, body);
+  handleClient();
+  return responseCode;
+}
+
+void ESP8266WebServer::handleClient() {
+  if (!_pending) return;
+  // a handler may call handleClient() again, e.g. while it waits
+  _pending = false;
+  ++requests;
+  responseCode = 0;
+  contentType[0] = '\0';
+  location[0] = '\0';
+  body.clear();
+  chunked = false;
+
+  for (Route &route : _routes) {
+    if (_uri.equals(route.uri.c_str()) && (route.method == HTTP_ANY || route.method == _method)) {
+      route.handler();
+      return;
+    }
+  }
+  if (_notFound) {
+    _notFound();
+  } else {
+    send(404, "text/plain", "Not found");
+  }
+}
+
+const String& ESP8266WebServer::arg(int i) const {
+  return i >= 0 && i < _argCount ? _argValues[i] : emptyString;
+}
+
+const String& ESP8266WebServer::argName(int i) const {
+  return i >= 0 && i < _argCount ? _argNames[i] : emptyString;
+}
+
+const String& ESP8266WebServer::arg(const String &name) const {
+  for (int i = 0; i < _argCount; ++i) {
+    if (_argNames[i].equals(name)) return _argValues[i];
+  }
+  return emptyString;
+}
+
+bool ESP8266WebServer::hasArg(const String &name) const {
+  for (int i = 0; i < _argCount; ++i) {
+    if (_argNames[i].equals(name)) return true;
+  }
+  return false;
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const String &content) {
+  send(code, contentType, content.c_str(), content.length());
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const char *content) {
+  send(code, contentType, content, strlen(content));
+}
+
+void ESP8266WebServer::send(int code, const char *type, const char *content, size_t length) {
+  responseCode = code;
+  strlcpy(contentType, type != nullptr ? type : "", sizeof(contentType));
+  body.append(content, length);
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first) {
+  (void) first;
+  if (name.equalsIgnoreCase(String("Location"))) strlcpy(location, value.c_str(), sizeof(location));
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t length) {
+  body.append(content, length);
+}
+
+bool ESP8266WebServer::chunkedResponseModeStart(int code, const char *type) {
+  chunked = true;
+  send(code, type, "", 0);
+  return true;
+}
+
+void ESP8266WebServer::chunkedResponseFinalize() {
+}
@@ -0,0 +1,101 @@
+#ifndef _fake_esp8266webserver_h_
+#define _fake_esp8266webserver_h_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define FAKE_WEB_MAX_ARGS 32
+
+// The web server without sockets: request() runs the handler of a request
+// like handleClient() would, the response is kept for the test. The argument
+// table and the response buffer are allocated up front, so serving a request
+// only allocates what the handler does.
+class ESP8266WebServer {
+
+    public:
+        typedef std::function<void(void)> THandlerFunction;
+
+        ESP8266WebServer(int port = 80);
+
+        void begin() {}
+        void handleClient();
+        void on(const char *uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+        void on(const char *uri, HTTPMethod method, THandlerFunction handler);
+        void onNotFound(THandlerFunction handler) { _notFound = handler; }
+
+        HTTPMethod method() const { return _method; }
+        const String& uri() const { return _uri; }
+        int args() const { return _argCount; }
+        const String& arg(int i) const;
+        const String& argName(int i) const;
+        const String& arg(const String &name) const;
+        bool hasArg(const String &name) const;
+
+        void send(int code, const char *contentType = nullptr, const String &content = emptyString);
+        void send(int code, const char *contentType, const char *content);
+        void send(int code, const char *contentType, const char *content, size_t length);
+        void send_P(int code, PGM_P contentType, PGM_P content) { send(code, contentType, content); }
+        void sendHeader(const String &name, const String &value, bool first = false);
+        void setContentLength(size_t length) { (void) length; }
+        void sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+        void sendContent(const char *content) { sendContent(content, strlen(content)); }
+        void sendContent(const char *content, size_t length);
+        bool chunkedResponseModeStart(int code, const char *contentType);
+        void chunkedResponseFinalize();
+
+        template <typename T> size_t streamFile(T &file, const String &contentType, int code = 200) {
+            send(code, contentType.c_str(), "");
+            uint8_t buf[256];
+            size_t total = 0;
+            size_t n;
+            while ((n = file.read(buf, sizeof(buf))) > 0) {
+                sendContent((const char *) buf, n);
+                total += n;
+            }
+            return total;
+        }
+
+        // test control: queue a request for the next handleClient(), query is
+        // "a=1&b=2", a POST body is passed as the "plain" argument and parsed
+        // as url encoded form
+        void queueRequest(HTTPMethod method, const char *uri, const char *query = nullptr, const char *body = nullptr);
+        // queue and serve, returns the response code
+        int request(HTTPMethod method, const char *uri, const char *query = nullptr, const char *body = nullptr);
+
+        // the last response
+        int responseCode;
+        char contentType[64];
+        char location[128];
+        std::string body;
+        bool chunked;
+        uint32_t requests;
+
+    protected:
+        struct Route {
+            std::string uri;
+            HTTPMethod method;
+            THandlerFunction handler;
+        };
+
+        void addArg(const char *name, size_t nameLength, const char *value, size_t valueLength);
+        void parseArgs(const char *query);
+
+        std::vector<Route> _routes;
+        THandlerFunction _notFound;
+        bool _pending;
+        HTTPMethod _method;
+        String _uri;
+        String _argNames[FAKE_WEB_MAX_ARGS];
+        String _argValues[FAKE_WEB_MAX_ARGS];
+        int _argCount;
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "ESP8266WiFi.h"
+#include "ezTime.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ESP8266WiFiClass WiFi;
+
+namespace fake {
+  std::function<bool(WiFiClient &client, const char *host, uint16_t port)> onConnect;
+}
+
+// --- WiFiClient ---
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  _rx.clear();
+  _pos = 0;
+  _tx.clear();
+  _closeWhenDrained = true;
+  _connected = WiFi.status() == WL_CONNECTED && fake::onConnect && fake::onConnect(*this, host, port);
+  return _connected;
+}
+
+uint8_t WiFiClient::connected() {
+  if (_connected && _closeWhenDrained && _pos >= _rx.size() && !_rx.empty()) _connected = false;
+  return _connected || available() > 0;
+}
+
+void WiFiClient::stop() {
+  _connected = false;
+  _rx.clear();
+  _pos = 0;
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+  if (!_connected) return 0;
+  _tx.append((const char *) buffer, size);
+  return size;
+}
+
+int WiFiClient::available() {
+  return _rx.size() - _pos;
+}
+
+int WiFiClient::read() {
+  return _pos < _rx.size() ? (uint8_t) _rx[_pos++] : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+  size_t n = min(size, (size_t) available());
+  memcpy(buffer, _rx.data() + _pos, n);
+  _pos += n;
+  return n;
+}
+
+int WiFiClient::peek() {
+  return _pos < _rx.size() ? (uint8_t) _rx[_pos] : -1;
+}
+
+void WiFiClient::respond(const std::string &data, bool close) {
+  _rx.append(data);
+  _closeWhenDrained = close;
+}
+
+// --- WiFiUDP ---
+WiFiUDP::WiFiUDP() : packetsSent(0), _socket(-1), _port(0), _txLen(0), _rxLen(0), _ntpAnswerLen(0), _rxPos(0), _remotePort(0) {
+}
+
+WiFiUDP::~WiFiUDP() {
+  stop();
+}
+
+bool WiFiUDP::open() {
+  if (_socket < 0) _socket = socket(AF_INET, SOCK_DGRAM, 0);
+  return _socket >= 0;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  if (!open()) return 0;
+  // test binaries running side by side bind the same ports
+  int reuse = 1;
+  setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  return bind(_socket, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+}
+
+void WiFiUDP::stop() {
+  if (_socket >= 0) close(_socket);
+  _socket = -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+  _ip = ip;
+  _port = port;
+  _txLen = 0;
+  return open();
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) return 0;
+  return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  size_t n = min(size, sizeof(_tx) - _txLen);
+  memcpy(_tx + _txLen, buffer, n);
+  _txLen += n;
+  return n;
+}
+
+static void writeBE32(uint8_t *p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+int WiFiUDP::endPacket() {
+  if (_socket < 0 || WiFi.status() != WL_CONNECTED) return 0;
+  if (_port == 123) {
+    ++fake::ntpQueries;
+    if (fake::ntpReply != 0 && _txLen >= 48) {
+      // server, version 4, stratum 2, the client's transmit time as originate time
+      memset(_rx, 0, 48);
+      _rx[0] = 0x24;
+      _rx[1] = 2;
+      memcpy(_rx + 24, _tx + 40, 8);
+      uint64_t micros = fake::clockMicros;
+      uint32_t seconds = fake::ntpReply + micros / 1000000 + 2208988800UL;
+      uint32_t fraction = ((micros % 1000000) << 32) / 1000000;
+      writeBE32(_rx + 32, seconds);
+      writeBE32(_rx + 36, fraction);
+      writeBE32(_rx + 40, seconds);
+      writeBE32(_rx + 44, fraction);
+      _ntpAnswerLen = 48;
+    }
+    _txLen = 0;
+    ++packetsSent;
+    return 1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = (uint32_t) _ip;
+  addr.sin_port = htons(_port);
+  ssize_t n = sendto(_socket, _tx, _txLen, 0, (struct sockaddr *) &addr, sizeof(addr));
+  _txLen = 0;
+  if (n < 0) return 0;
+  ++packetsSent;
+  return 1;
+}
+
+int WiFiUDP::parsePacket() {
+  _rxLen = 0;
+  _rxPos = 0;
+  if (_ntpAnswerLen > 0) {
+    _rxLen = _ntpAnswerLen;
+    _ntpAnswerLen = 0;
+    _remoteIp = _ip;
+    _remotePort = 123;
+    return _rxLen;
+  }
+  if (_socket < 0) return 0;
+  struct sockaddr_in addr;
+  socklen_t addrLen = sizeof(addr);
+  ssize_t n = recvfrom(_socket, _rx, sizeof(_rx), MSG_DONTWAIT, (struct sockaddr *) &addr, &addrLen);
+  if (n <= 0) return 0;
+  _rxLen = n;
+  _remoteIp = IPAddress((uint32_t) addr.sin_addr.s_addr);
+  _remotePort = ntohs(addr.sin_port);
+  return n;
+}
+
+int WiFiUDP::available() {
+  return _rxLen - _rxPos;
+}
+
+int WiFiUDP::read() {
+  return _rxPos < _rxLen ? _rx[_rxPos++] : -1;
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+  size_t n = min(size, (size_t) available());
+  memcpy(buffer, _rx + _rxPos, n);
+  _rxPos += n;
+  return n;
+}
+
+int WiFiUDP::peek() {
+  return _rxPos < _rxLen ? _rx[_rxPos] : -1;
+}
+
+// --- WiFi ---
+ESP8266WiFiClass::ESP8266WiFiClass() : connectedStatus(WL_CONNECTED), failBegin(false), lookups(0), begins(0),
+  wifiChannel(6), localIp(192, 168, 1, 42), gatewayIp(192, 168, 1, 1), subnetMaskIp(255, 255, 255, 0),
+  dnsIp(192, 168, 1, 1), _mode(WIFI_STA) {
+  strlcpy(ssid, "fake-ssid", sizeof(ssid));
+  const uint8_t mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+  memcpy(bssid, mac, sizeof(bssid));
+}
+
+wl_status_t ESP8266WiFiClass::begin() {
+  ++begins;
+  connectedStatus = failBegin ? WL_DISCONNECTED : WL_CONNECTED;
+  return connectedStatus;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *passphrase, int32_t channel, const uint8_t *bssid, bool connect) {
+  (void) ssid;
+  (void) passphrase;
+  (void) channel;
+  (void) bssid;
+  (void) connect;
+  return begin();
+}
+
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+  (void) dns2;
+  if ((uint32_t) local != 0) {
+    localIp = local;
+    gatewayIp = gateway;
+    subnetMaskIp = subnet;
+    dnsIp = dns1;
+  }
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff) {
+  (void) wifiOff;
+  connectedStatus = WL_DISCONNECTED;
+  return true;
+}
+
+int ESP8266WiFiClass::hostByName(const char *host, IPAddress &result) {
+  ++lookups;
+  if (connectedStatus != WL_CONNECTED) return 0;
+  if (result.fromString(host)) return 1;
+  // TEST-NET-1, the tests don't depend on the host's resolver
+  result = IPAddress(192, 0, 2, 1);
+  return host[0] != '\0';
+}
@@ -0,0 +1,163 @@
+#ifndef _fake_esp8266wifi_h_
+#define _fake_esp8266wifi_h_
+
+#include <Arduino.h>
+
+#include <functional>
+#include <string>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+
+class Client : public Stream {
+
+    public:
+        virtual int connect(IPAddress ip, uint16_t port) = 0;
+        virtual int connect(const char *host, uint16_t port) = 0;
+        virtual uint8_t connected() = 0;
+        virtual void stop() = 0;
+        virtual operator bool() = 0;
+        using Print::write;
+};
+
+// A TCP client talking to a peer inside the test: fake::onConnect decides if
+// a connect succeeds and may queue the response with respond().
+class WiFiClient : public Client {
+
+    public:
+        WiFiClient() : _connected(false), _closeWhenDrained(true), _pos(0) {}
+
+        int connect(IPAddress ip, uint16_t port) override;
+        int connect(const char *host, uint16_t port) override;
+        int connect(const String &host, uint16_t port) { return connect(host.c_str(), port); }
+        uint8_t connected() override;
+        void stop() override;
+        operator bool() override { return connected(); }
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size);
+        int peek() override;
+        void setNoDelay(bool noDelay) { (void) noDelay; }
+
+        // test control: the data the peer sends, the peer closes the connection after it
+        void respond(const std::string &data, bool close = true);
+        const std::string& sent() const { return _tx; }
+
+    protected:
+        bool _connected;
+        bool _closeWhenDrained;
+        std::string _rx;
+        size_t _pos;
+        std::string _tx;
+};
+
+// UDP over real host sockets, so a test can receive the datagrams
+class WiFiUDP : public Stream {
+
+    public:
+        WiFiUDP();
+        ~WiFiUDP();
+
+        uint8_t begin(uint16_t port);
+        void stop();
+        int beginPacket(IPAddress ip, uint16_t port);
+        int beginPacket(const char *host, uint16_t port);
+        int endPacket();
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+
+        // the next received datagram, 0 if there is none
+        // Datagrams to port 123 don't leave the process, the NTP server stand-in
+        // answers them at once with the time fake::ntpReply (no answer if 0).
+        int parsePacket();
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size);
+        int peek() override;
+        IPAddress remoteIP() const { return _remoteIp; }
+        uint16_t remotePort() const { return _remotePort; }
+
+        // test control
+        uint32_t packetsSent;
+
+    protected:
+        bool open();
+
+        int _socket;
+        IPAddress _ip;
+        uint16_t _port;
+        uint8_t _tx[1472];
+        size_t _txLen;
+        uint8_t _rx[1472];
+        size_t _rxLen;
+        size_t _ntpAnswerLen; // in _rx, not parsed yet
+        size_t _rxPos;
+        IPAddress _remoteIp;
+        uint16_t _remotePort;
+};
+
+class ESP8266WiFiClass {
+
+    public:
+        ESP8266WiFiClass();
+
+        wl_status_t status() { return connectedStatus; }
+        bool mode(WiFiMode_t mode) { _mode = mode; return true; }
+        wl_status_t begin();
+        wl_status_t begin(const char *ssid, const char *passphrase = nullptr, int32_t channel = 0, const uint8_t *bssid = nullptr, bool connect = true);
+        bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress((uint32_t) 0), IPAddress dns2 = IPAddress((uint32_t) 0));
+        bool disconnect(bool wifiOff = false);
+        bool persistent(bool persistent) { (void) persistent; return true; }
+        bool setAutoConnect(bool autoConnect) { (void) autoConnect; return true; }
+
+        String SSID() { return String(ssid); }
+        String psk() { return String("secret"); }
+        uint8_t* BSSID() { return bssid; }
+        int32_t channel() { return wifiChannel; }
+        IPAddress localIP() { return localIp; }
+        IPAddress gatewayIP() { return gatewayIp; }
+        IPAddress subnetMask() { return subnetMaskIp; }
+        IPAddress dnsIP(uint8_t num = 0) { (void) num; return dnsIp; }
+
+        // an IP address or any name (to 192.0.2.1, nothing is sent to it), counted in lookups
+        int hostByName(const char *host, IPAddress &result);
+
+        // test control
+        wl_status_t connectedStatus;
+        bool failBegin;     // begin() doesn't connect
+        uint32_t lookups;   // hostByName() calls
+        uint32_t begins;
+        char ssid[33];
+        uint8_t bssid[6];
+        int32_t wifiChannel;
+        IPAddress localIp;
+        IPAddress gatewayIp;
+        IPAddress subnetMaskIp;
+        IPAddress dnsIp;
+
+    protected:
+        WiFiMode_t _mode;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+namespace fake {
+  // called by WiFiClient::connect(), returns if the connect succeeds
+  extern std::function<bool(WiFiClient &client, const char *host, uint16_t port)> onConnect;
+}
+
+#endif
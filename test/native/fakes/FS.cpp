@@ -0,0 +1,228 @@
+#include "FS.h"
+#include "LittleFS.h"
+
+#include <dirent.h>
+
+fs::FS LittleFS;
+
+namespace fs {
+
+struct FakeFile {
+  uint8_t refs;  // 0 = free slot
+  bool writable;
+  bool append;
+  std::vector<uint8_t> *data; // nullptr after close() or remove()
+  size_t pos;
+  char name[64];
+};
+
+static FakeFile openFiles[FAKE_FS_MAX_OPEN];
+
+File::File(const File &other) : _handle(other._handle) {
+  if (_handle != nullptr) ++_handle->refs;
+}
+
+File& File::operator=(const File &other) {
+  if (other._handle != nullptr) ++other._handle->refs;
+  if (_handle != nullptr && --_handle->refs == 0) _handle->data = nullptr;
+  _handle = other._handle;
+  return *this;
+}
+
+File::~File() {
+  if (_handle != nullptr && --_handle->refs == 0) _handle->data = nullptr;
+}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  if (_handle == nullptr || _handle->data == nullptr || !_handle->writable) return 0;
+  std::vector<uint8_t> &d = *_handle->data;
+  if (_handle->append) _handle->pos = d.size();
+  if (_handle->pos + size > d.size()) d.resize(_handle->pos + size);
+  memcpy(d.data() + _handle->pos, buffer, size);
+  _handle->pos += size;
+  return size;
+}
+
+int File::available() {
+  if (_handle == nullptr || _handle->data == nullptr) return 0;
+  return _handle->data->size() - min(_handle->pos, _handle->data->size());
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (available() == 0) return -1;
+  return (*_handle->data)[_handle->pos];
+}
+
+size_t File::read(uint8_t *buffer, size_t size) {
+  size_t n = min(size, (size_t) available());
+  if (n == 0) return 0;
+  memcpy(buffer, _handle->data->data() + _handle->pos, n);
+  _handle->pos += n;
+  return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (_handle == nullptr || _handle->data == nullptr) return false;
+  size_t base = mode == SeekSet ? 0 : (mode == SeekCur ? _handle->pos : _handle->data->size());
+  if (base + pos > _handle->data->size()) return false;
+  _handle->pos = base + pos;
+  return true;
+}
+
+size_t File::position() const {
+  return _handle != nullptr ? _handle->pos : 0;
+}
+
+size_t File::size() const {
+  return _handle != nullptr && _handle->data != nullptr ? _handle->data->size() : 0;
+}
+
+void File::close() {
+  if (_handle == nullptr) return;
+  if (--_handle->refs == 0) _handle->data = nullptr;
+  _handle = nullptr;
+}
+
+const char* File::name() const {
+  return _handle != nullptr ? _handle->name : "";
+}
+
+FS::FS() : mounted(false), failMount(false), mounts(0) {
+}
+
+bool FS::begin() {
+  ++mounts;
+  if (failMount) return false;
+  mounted = true;
+  return true;
+}
+
+void FS::end() {
+  mounted = false;
+}
+
+bool FS::format() {
+  _files.clear();
+  return true;
+}
+
+std::string_view FS::normalize(const char *path) {
+  while (*path == '/') ++path;
+  return std::string_view(path);
+}
+
+File FS::open(const char *path, const char *mode) {
+  if (!mounted) return File();
+  std::string_view name = normalize(path);
+  auto it = _files.find(name);
+  bool create = mode[0] == 'w' || mode[0] == 'a';
+  if (it == _files.end()) {
+    if (!create) return File();
+    it = _files.emplace(std::string(name), std::vector<uint8_t>()).first;
+  }
+  if (mode[0] == 'w') it->second.clear();
+
+  for (FakeFile &f : openFiles) {
+    if (f.refs > 0) continue;
+    f.refs = 1;
+    f.writable = mode[0] != 'r' || mode[1] == '+';
+    f.append = mode[0] == 'a';
+    f.data = &it->second;
+    f.pos = 0;
+    strlcpy(f.name, it->first.c_str(), sizeof(f.name));
+    return File(&f);
+  }
+  return File(); // too many open files
+}
+
+bool FS::exists(const char *path) {
+  return mounted && _files.find(normalize(path)) != _files.end();
+}
+
+static void detach(const std::vector<uint8_t> *data) {
+  for (FakeFile &f : openFiles) {
+    if (f.refs > 0 && f.data == data) f.data = nullptr;
+  }
+}
+
+bool FS::remove(const char *path) {
+  if (!mounted) return false;
+  auto it = _files.find(normalize(path));
+  if (it == _files.end()) return false;
+  detach(&it->second);
+  _files.erase(it);
+  return true;
+}
+
+bool FS::rename(const char *from, const char *to) {
+  if (!mounted) return false;
+  auto it = _files.find(normalize(from));
+  if (it == _files.end() || _files.find(normalize(to)) != _files.end()) return false;
+  std::vector<uint8_t> data = std::move(it->second);
+  detach(&it->second);
+  _files.erase(it);
+  _files.emplace(std::string(normalize(to)), std::move(data));
+  return true;
+}
+
+void FS::clear() {
+  for (FakeFile &f : openFiles) {
+    f.refs = 0;
+    f.data = nullptr;
+  }
+  _files.clear();
+  mounted = false;
+  failMount = false;
+  mounts = 0;
+}
+
+bool FS::loadFile(const char *hostPath, const char *path) {
+  FILE *in = fopen(hostPath, "rb");
+  if (in == nullptr) return false;
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(in);
+  _files[std::string(normalize(path))] = std::move(data);
+  return true;
+}
+
+size_t FS::loadDir(const char *hostDir) {
+  DIR *dir = opendir(hostDir);
+  if (dir == nullptr) return 0;
+  size_t count = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    if (entry->d_name[0] == '.') continue;
+    std::string hostPath = std::string(hostDir) + "/" + entry->d_name;
+    if (loadFile(hostPath.c_str(), entry->d_name)) ++count;
+  }
+  closedir(dir);
+  return count;
+}
+
+std::vector<uint8_t>* FS::data(const char *path) {
+  auto it = _files.find(normalize(path));
+  return it == _files.end() ? nullptr : &it->second;
+}
+
+void FS::setContent(const char *path, const std::string &content) {
+  _files[std::string(normalize(path))] = std::vector<uint8_t>(content.begin(), content.end());
+}
+
+std::string FS::getContent(const char *path) {
+  std::vector<uint8_t> *d = data(path);
+  return d == nullptr ? std::string() : std::string(d->begin(), d->end());
+}
+
+} // namespace fs
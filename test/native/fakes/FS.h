@@ -0,0 +1,95 @@
+#ifndef _fake_fs_h_
+#define _fake_fs_h_
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+#define FAKE_FS_MAX_OPEN 8
+
+struct FakeFile;
+
+// a handle into a fixed table of open files, opening and reading a file
+// doesn't allocate
+class File : public Stream {
+
+    public:
+        File() : _handle(nullptr) {}
+        File(FakeFile *handle) : _handle(handle) {}
+        File(const File &other);
+        File& operator=(const File &other);
+        ~File();
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t read(uint8_t *buffer, size_t size);
+        size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *) buffer, length); }
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        void close();
+        operator bool() const { return _handle != nullptr; }
+        const char* name() const;
+
+    protected:
+        FakeFile *_handle;
+};
+
+// an in-memory file system, paths with or without leading '/'
+class FS {
+
+    public:
+        FS();
+
+        bool begin();
+        void end();
+        bool format();
+
+        File open(const char *path, const char *mode);
+        File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool rename(const char *from, const char *to);
+        bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+        // test control
+        void clear();
+        // copy a host file or all files of a host directory into the file system
+        bool loadFile(const char *hostPath, const char *path);
+        size_t loadDir(const char *hostDir);
+        std::vector<uint8_t>* data(const char *path);
+        void setContent(const char *path, const std::string &content);
+        std::string getContent(const char *path);
+
+        bool mounted;
+        bool failMount;  // begin() returns false
+        uint32_t mounts; // begin() calls
+
+    protected:
+        std::map<std::string, std::vector<uint8_t>, std::less<>> _files;
+
+        static std::string_view normalize(const char *path);
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
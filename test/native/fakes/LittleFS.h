@@ -0,0 +1,8 @@
+#ifndef _fake_littlefs_h_
+#define _fake_littlefs_h_
+
+#include <FS.h>
+
+extern fs::FS LittleFS;
+
+#endif
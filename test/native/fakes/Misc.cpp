@@ -0,0 +1,5 @@
+#include <Wire.h>
+#include <ArduinoOTA.h>
+
+TwoWire Wire;
+ArduinoOTAClass ArduinoOTA;
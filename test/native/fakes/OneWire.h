@@ -0,0 +1,15 @@
+#ifndef _fake_onewire_h_
+#define _fake_onewire_h_
+
+#include <Arduino.h>
+
+class OneWire {
+
+    public:
+        OneWire(uint8_t pin) : _pin(pin) {}
+
+    protected:
+        uint8_t _pin;
+};
+
+#endif
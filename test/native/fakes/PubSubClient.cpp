@@ -0,0 +1,292 @@
+#include "PubSubClient.h"
+
+#define MQTT_MAX_HEADER_SIZE 5
+
+namespace fake {
+
+static MqttBroker defaultBroker;
+MqttBroker *broker = &defaultBroker;
+
+static struct BrokerInit {
+  BrokerInit() { defaultBroker.reset(); }
+} brokerInit;
+
+// MQTT topic filter with + and #
+bool topicMatches(const char *filter, const char *topic) {
+  while (*filter != '\0') {
+    if (*filter == '#') return true;
+    if (*filter == '+') {
+      while (*topic != '\0' && *topic != '/') ++topic;
+      ++filter;
+      continue;
+    }
+    if (*filter != *topic) return false;
+    ++filter;
+    ++topic;
+  }
+  return *topic == '\0';
+}
+
+void MqttBroker::reset() {
+  memset(this, 0, sizeof(*this));
+  up = true;
+}
+
+void MqttBroker::setUp(bool isUp) {
+  up = isUp;
+  if (!up) {
+    for (uint16_t i = 0; i < sessionCount; ++i) sessions[i].connected = false;
+  }
+}
+
+static void copyMessage(MqttMessage &m, int16_t session, const char *topic, const uint8_t *payload, uint16_t length, bool retain) {
+  m.time = millis();
+  m.session = session;
+  m.retained = retain;
+  m.length = min(length, (uint16_t) (FAKE_MQTT_PAYLOAD - 1));
+  strlcpy(m.topic, topic, FAKE_MQTT_TOPIC);
+  memcpy(m.payload, payload, m.length);
+  m.payload[m.length] = '\0';
+}
+
+static void deliver(MqttBroker &b, MqttSession &s, const MqttMessage &m) {
+  if (s.inboxCount == FAKE_MQTT_INBOX) {
+    ++b.inboxDrops;
+    return;
+  }
+  s.inbox[s.inboxCount++] = m;
+  ++b.deliveries;
+}
+
+int16_t MqttBroker::connect(const char *clientId) {
+  if (!up) {
+    ++connectFailures;
+    return -1;
+  }
+  int16_t idx = -1;
+  for (uint16_t i = 0; i < sessionCount; ++i) {
+    if (strcmp(sessions[i].clientId, clientId) == 0) idx = i;
+  }
+  if (idx < 0) {
+    if (sessionCount == FAKE_MQTT_SESSIONS) {
+      ++connectFailures;
+      return -1;
+    }
+    idx = sessionCount++;
+    strlcpy(sessions[idx].clientId, clientId, FAKE_MQTT_CLIENT_ID);
+  }
+  // a clean session, a client with the same id is taken over
+  MqttSession &s = sessions[idx];
+  s.connected = true;
+  s.subscriptionCount = 0;
+  s.inboxCount = 0;
+  ++s.connects;
+  ++connects;
+  return idx;
+}
+
+void MqttBroker::publish(int16_t session, const char *topic, const uint8_t *payload, uint16_t length, bool retain) {
+  MqttMessage &m = log[logCount++ % FAKE_MQTT_LOG];
+  copyMessage(m, session, topic, payload, length, retain);
+  ++publishes;
+  payloadBytes += length;
+  if (session >= 0) ++sessions[session].publishes;
+
+  if (retain) {
+    uint8_t i = 0;
+    while (i < retainedCount && strcmp(retained[i].topic, topic) != 0) ++i;
+    if (i < FAKE_MQTT_RETAINED) {
+      retained[i] = m;
+      if (i == retainedCount) ++retainedCount;
+    }
+  }
+  for (uint16_t i = 0; i < sessionCount; ++i) {
+    MqttSession &s = sessions[i];
+    if (!s.connected) continue;
+    for (uint8_t j = 0; j < s.subscriptionCount; ++j) {
+      if (topicMatches(s.subscriptions[j], topic)) {
+        deliver(*this, s, m);
+        break;
+      }
+    }
+  }
+}
+
+bool MqttBroker::subscribe(int16_t session, const char *filter) {
+  MqttSession &s = sessions[session];
+  if (s.subscriptionCount == FAKE_MQTT_SUBSCRIPTIONS) return false;
+  strlcpy(s.subscriptions[s.subscriptionCount++], filter, FAKE_MQTT_TOPIC);
+  for (uint8_t i = 0; i < retainedCount; ++i) {
+    if (topicMatches(filter, retained[i].topic)) deliver(*this, s, retained[i]);
+  }
+  return true;
+}
+
+bool MqttBroker::unsubscribe(int16_t session, const char *filter) {
+  MqttSession &s = sessions[session];
+  for (uint8_t i = 0; i < s.subscriptionCount; ++i) {
+    if (strcmp(s.subscriptions[i], filter) == 0) {
+      memmove(s.subscriptions[i], s.subscriptions[i + 1], (s.subscriptionCount - i - 1) * FAKE_MQTT_TOPIC);
+      --s.subscriptionCount;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t MqttBroker::connectedCount() {
+  uint16_t cnt = 0;
+  for (uint16_t i = 0; i < sessionCount; ++i) {
+    if (sessions[i].connected) ++cnt;
+  }
+  return cnt;
+}
+
+const MqttMessage* MqttBroker::last(uint32_t n) {
+  if (n >= logCount || n >= FAKE_MQTT_LOG) return nullptr;
+  return &log[(logCount - 1 - n) % FAKE_MQTT_LOG];
+}
+
+const MqttMessage* MqttBroker::find(const char *topic) {
+  for (uint32_t n = 0; last(n) != nullptr; ++n) {
+    if (strcmp(last(n)->topic, topic) == 0) return last(n);
+  }
+  return nullptr;
+}
+
+void MqttBroker::inject(const char *topic, const char *payload, bool retain) {
+  publish(-1, topic, (const uint8_t *) payload, strlen(payload), retain);
+}
+
+}
+
+PubSubClient::PubSubClient() : _session(-1), _state(MQTT_DISCONNECTED), _bufferSize(MQTT_MAX_PACKET_SIZE),
+  _streamTopic(""), _streamRetained(false), _streamLength(0) {
+}
+
+PubSubClient::PubSubClient(Client &client) : PubSubClient() {
+  (void) client;
+}
+
+PubSubClient& PubSubClient::setServer(const char *domain, uint16_t port) {
+  (void) domain;
+  (void) port;
+  return *this;
+}
+
+PubSubClient& PubSubClient::setServer(IPAddress ip, uint16_t port) {
+  (void) ip;
+  (void) port;
+  return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+  _callback = callback;
+  return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+  if (size == 0) return false;
+  _bufferSize = size;
+  return true;
+}
+
+bool PubSubClient::connect(const char *id) {
+  fake::MqttBroker &b = *fake::broker;
+  _session = WiFi.status() == WL_CONNECTED ? b.connect(id) : -1;
+  if (_session < 0) {
+    // the TCP connect runs into its timeout
+    if (!b.up) fake::advance(b.connectDelayMs);
+    _state = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  _state = MQTT_CONNECTED;
+  return true;
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass) {
+  (void) user;
+  (void) pass;
+  return connect(id);
+}
+
+void PubSubClient::disconnect() {
+  if (connected()) fake::broker->sessions[_session].connected = false;
+  _session = -1;
+  _state = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::connected() {
+  if (_session < 0) return false;
+  if (!fake::broker->sessions[_session].connected || WiFi.status() != WL_CONNECTED) {
+    _session = -1;
+    _state = MQTT_CONNECTION_LOST;
+    return false;
+  }
+  return true;
+}
+
+int PubSubClient::state() {
+  return _state;
+}
+
+bool PubSubClient::loop() {
+  if (!connected()) return false;
+  fake::MqttSession &s = fake::broker->sessions[_session];
+  // the callback may publish, deliver a copy
+  while (s.inboxCount > 0) {
+    static fake::MqttMessage m;
+    m = s.inbox[0];
+    --s.inboxCount;
+    memmove(&s.inbox[0], &s.inbox[1], s.inboxCount * sizeof(fake::MqttMessage));
+    if (_callback) _callback(m.topic, (uint8_t *) m.payload, m.length);
+  }
+  return true;
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained) {
+  return publish(topic, (const uint8_t *) payload, payload != nullptr ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained) {
+  if (!connected()) return false;
+  if (_bufferSize < MQTT_MAX_HEADER_SIZE + 2 + strnlen(topic, _bufferSize) + length) return false;
+  fake::broker->publish(_session, topic, payload, length, retained);
+  return true;
+}
+
+bool PubSubClient::beginPublish(const char *topic, unsigned int plength, bool retained) {
+  (void) plength;
+  if (!connected()) return false;
+  strlcpy(_streamTopic, topic, FAKE_MQTT_TOPIC);
+  _streamRetained = retained;
+  _streamLength = 0;
+  return true;
+}
+
+int PubSubClient::endPublish() {
+  if (!connected()) return 0;
+  fake::broker->publish(_session, _streamTopic, _stream, _streamLength, _streamRetained);
+  return 1;
+}
+
+size_t PubSubClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
+  size_t n = min(size, (size_t) (FAKE_MQTT_PAYLOAD - _streamLength));
+  memcpy(_stream + _streamLength, buffer, n);
+  _streamLength += n;
+  return size;
+}
+
+bool PubSubClient::subscribe(const char *topic) {
+  if (!connected()) return false;
+  return fake::broker->subscribe(_session, topic);
+}
+
+bool PubSubClient::unsubscribe(const char *topic) {
+  if (!connected()) return false;
+  return fake::broker->unsubscribe(_session, topic);
+}
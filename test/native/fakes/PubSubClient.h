@@ -0,0 +1,141 @@
+#ifndef _fake_pubsubclient_h_
+#define _fake_pubsubclient_h_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include <functional>
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+
+#define MQTT_MAX_PACKET_SIZE 256
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char *, uint8_t *, unsigned int)> callback
+
+#define FAKE_MQTT_SESSIONS 256
+#define FAKE_MQTT_CLIENT_ID 32
+#define FAKE_MQTT_TOPIC 96
+#define FAKE_MQTT_PAYLOAD 512
+#define FAKE_MQTT_SUBSCRIPTIONS 8
+#define FAKE_MQTT_INBOX 8
+#define FAKE_MQTT_LOG 256
+#define FAKE_MQTT_RETAINED 16
+
+namespace fake {
+
+struct MqttMessage {
+  uint32_t time;    // millis() of the publisher
+  int16_t session;  // of the publisher
+  bool retained;
+  uint16_t length;
+  char topic[FAKE_MQTT_TOPIC];
+  char payload[FAKE_MQTT_PAYLOAD];
+};
+
+struct MqttSession {
+  bool connected;
+  char clientId[FAKE_MQTT_CLIENT_ID];
+  uint32_t connects;
+  uint32_t publishes;
+  uint8_t subscriptionCount;
+  char subscriptions[FAKE_MQTT_SUBSCRIPTIONS][FAKE_MQTT_TOPIC];
+  uint8_t inboxCount;
+  MqttMessage inbox[FAKE_MQTT_INBOX]; // delivered by loop()
+};
+
+// The broker stand-in. Plain data without pointers, so the fleet simulator
+// can put it into memory shared by its node processes.
+struct MqttBroker {
+  bool up;
+  // a connect attempt while the broker is down blocks this long (TCP timeout)
+  uint32_t connectDelayMs;
+  uint32_t connects;
+  uint32_t connectFailures;
+  uint32_t publishes;
+  uint64_t payloadBytes;
+  uint32_t deliveries;
+  uint32_t inboxDrops;
+  uint16_t sessionCount;
+  MqttSession sessions[FAKE_MQTT_SESSIONS];
+  uint32_t logCount;  // all publishes, the last FAKE_MQTT_LOG are kept
+  MqttMessage log[FAKE_MQTT_LOG];
+  uint8_t retainedCount;
+  MqttMessage retained[FAKE_MQTT_RETAINED];
+
+  void reset();
+  // an outage: all sessions are dropped and connects fail until the broker is up again
+  void setUp(bool isUp);
+  int16_t connect(const char *clientId);
+  void publish(int16_t session, const char *topic, const uint8_t *payload, uint16_t length, bool retain);
+  bool subscribe(int16_t session, const char *filter);
+  bool unsubscribe(int16_t session, const char *filter);
+  uint16_t connectedCount();
+
+  // the n-th last publish, nullptr if there is none
+  const MqttMessage* last(uint32_t n = 0);
+  // the last publish to topic
+  const MqttMessage* find(const char *topic);
+  // publish from outside, e.g. another node
+  void inject(const char *topic, const char *payload, bool retain = false);
+};
+
+// the broker all clients connect to
+extern MqttBroker *broker;
+
+bool topicMatches(const char *filter, const char *topic);
+
+}
+
+class PubSubClient : public Print {
+
+    public:
+        PubSubClient();
+        PubSubClient(Client &client);
+
+        PubSubClient& setServer(const char *domain, uint16_t port);
+        PubSubClient& setServer(IPAddress ip, uint16_t port);
+        PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+        PubSubClient& setClient(Client &client) { (void) client; return *this; }
+        PubSubClient& setKeepAlive(uint16_t keepAlive) { (void) keepAlive; return *this; }
+        PubSubClient& setSocketTimeout(uint16_t timeout) { (void) timeout; return *this; }
+        bool setBufferSize(uint16_t size);
+        uint16_t getBufferSize() { return _bufferSize; }
+
+        bool connect(const char *id);
+        bool connect(const char *id, const char *user, const char *pass);
+        void disconnect();
+        bool connected();
+        int state();
+        bool loop();
+
+        bool publish(const char *topic, const char *payload) { return publish(topic, payload, false); }
+        bool publish(const char *topic, const char *payload, bool retained);
+        bool publish(const char *topic, const uint8_t *payload, unsigned int length) { return publish(topic, payload, length, false); }
+        bool publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained);
+        // a message larger than the buffer, written in parts
+        bool beginPublish(const char *topic, unsigned int plength, bool retained);
+        int endPublish();
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+
+        bool subscribe(const char *topic);
+        bool unsubscribe(const char *topic);
+
+    protected:
+        std::function<void(char *, uint8_t *, unsigned int)> _callback;
+        int16_t _session;
+        int _state;
+        uint16_t _bufferSize;
+        // the message started by beginPublish()
+        char _streamTopic[FAKE_MQTT_TOPIC];
+        bool _streamRetained;
+        uint16_t _streamLength;
+        uint8_t _stream[FAKE_MQTT_PAYLOAD];
+};
+
+#endif
@@ -0,0 +1,297 @@
+#include "TFT_eSPI.h"
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _initWidth(w), _initHeight(h), _width(w), _height(h),
+  _rotation(0), _swapBytes(false), _textColor(TFT_WHITE), _textSize(1), _isPanel(true), _pixels(nullptr), _spi() {
+}
+
+TFT_eSPI::~TFT_eSPI() {
+  free(_pixels);
+}
+
+void TFT_eSPI::init() {
+  if (_pixels == nullptr) _pixels = (uint16_t *) calloc((size_t) _initWidth * _initHeight, sizeof(uint16_t));
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+  _rotation = r % 4;
+  _width = (_rotation & 1) ? _initHeight : _initWidth;
+  _height = (_rotation & 1) ? _initWidth : _initHeight;
+}
+
+bool TFT_eSPI::clip(int32_t &x, int32_t &y, int32_t &w, int32_t &h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > _width) w = _width - x;
+  if (y + h > _height) h = _height - y;
+  return w > 0 && h > 0 && _pixels != nullptr;
+}
+
+void TFT_eSPI::countWindow(int32_t pixels) {
+  if (!_isPanel) return;
+  ++_spi.transactions;
+  _spi.bytes += FAKE_TFT_WINDOW_BYTES + pixels * 2;
+  _spi.pixels += pixels;
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  int32_t w = 1;
+  int32_t h = 1;
+  if (!clip(x, y, w, h)) return;
+  _pixels[y * _width + x] = (uint16_t) color;
+  countWindow(1);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  if (!clip(x, y, w, h)) return;
+  for (int32_t row = y; row < y + h; ++row) {
+    uint16_t *p = _pixels + row * _width + x;
+    for (int32_t col = 0; col < w; ++col) *p++ = (uint16_t) color;
+  }
+  countWindow(w * h);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+  int32_t cx = x;
+  int32_t cy = y;
+  int32_t cw = w;
+  int32_t ch = h;
+  if (!clip(cx, cy, cw, ch)) return;
+  for (int32_t row = 0; row < ch; ++row) {
+    const uint16_t *src = data + (cy - y + row) * w + (cx - x);
+    uint16_t *dst = _pixels + (cy + row) * _width + cx;
+    for (int32_t col = 0; col < cw; ++col) {
+      uint16_t c = *src++;
+      *dst++ = _swapBytes ? c : (uint16_t) (c << 8 | c >> 8);
+    }
+  }
+  countWindow(cw * ch);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y + 1, h - 2, color);
+  drawFastVLine(x + w - 1, y + 1, h - 2, color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+  // Bresenham
+  int32_t dx = abs(x1 - x0);
+  int32_t dy = -abs(y1 - y0);
+  int32_t sx = x0 < x1 ? 1 : -1;
+  int32_t sy = y0 < y1 ? 1 : -1;
+  int32_t err = dx + dy;
+  while (true) {
+    drawPixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y, uint8_t font) {
+  (void) x;
+  (void) y;
+  (void) font;
+  // the fixed font 2 is 6 pixels wide
+  return (int16_t) (strlen(string) * 6 * _textSize);
+}
+
+uint16_t TFT_eSPI::alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc) {
+  // same arithmetic as TFT_eSPI
+  uint16_t fgR = ((fgc >> 10) & 0x3E) + 1;
+  uint16_t fgG = ((fgc >> 4) & 0x7E) + 1;
+  uint16_t fgB = ((fgc << 1) & 0x3E) + 1;
+  uint16_t bgR = ((bgc >> 10) & 0x3E) + 1;
+  uint16_t bgG = ((bgc >> 4) & 0x7E) + 1;
+  uint16_t bgB = ((bgc << 1) & 0x3E) + 1;
+  uint16_t r = (((fgR * alpha) + (bgR * (255 - alpha))) >> 9);
+  uint16_t g = (((fgG * alpha) + (bgG * (255 - alpha))) >> 9);
+  uint16_t b = (((fgB * alpha) + (bgB * (255 - alpha))) >> 9);
+  return (r << 11) | (g << 5) | (b << 0);
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+  if (_pixels == nullptr || x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+  return _pixels[y * _width + x];
+}
+
+// --- PNG ---
+// 8 bit RGB, deflated with the fixed Huffman codes and only matches of the
+// previous pixel (distance 3): small for a display image, and the output only
+// depends on the pixels, so golden files compare byte by byte.
+
+static uint32_t pngCrc(const uint8_t *data, size_t length, uint32_t crc = 0xffffffff) {
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; ++i) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return crc;
+}
+
+static void appendBE32(std::string &out, uint32_t v) {
+  out += (char) (v >> 24);
+  out += (char) (v >> 16);
+  out += (char) (v >> 8);
+  out += (char) v;
+}
+
+static void appendChunk(std::string &out, const char *type, const std::string &data) {
+  appendBE32(out, data.size());
+  std::string chunk = std::string(type, 4) + data;
+  out += chunk;
+  appendBE32(out, pngCrc((const uint8_t *) chunk.data(), chunk.size()) ^ 0xffffffff);
+}
+
+struct BitWriter {
+  std::string &out;
+  uint32_t bits = 0;
+  uint8_t count = 0;
+
+  BitWriter(std::string &o) : out(o) {}
+  void put(uint32_t value, uint8_t n) {
+    bits |= value << count;
+    count += n;
+    while (count >= 8) {
+      out += (char) (bits & 0xff);
+      bits >>= 8;
+      count -= 8;
+    }
+  }
+  // Huffman codes are sent from the most significant bit
+  void putCode(uint32_t code, uint8_t n) {
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < n; ++i) reversed |= ((code >> i) & 1) << (n - 1 - i);
+    put(reversed, n);
+  }
+  void putSymbol(uint16_t sym) {
+    if (sym < 144) putCode(0x30 + sym, 8);
+    else if (sym < 256) putCode(0x190 + sym - 144, 9);
+    else if (sym < 280) putCode(sym - 256, 7);
+    else putCode(0xC0 + sym - 280, 8);
+  }
+  void flush() {
+    if (count > 0) out += (char) (bits & 0xff);
+    bits = 0;
+    count = 0;
+  }
+};
+
+static void deflateFixed(std::string &out, const std::string &raw) {
+  static const uint16_t lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+  static const uint8_t lengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+  BitWriter w(out);
+  w.put(1, 1); // the last block
+  w.put(1, 2); // fixed Huffman codes
+  size_t i = 0;
+  while (i < raw.size()) {
+    size_t len = 0;
+    while (i >= 3 && i + len < raw.size() && len < 258 && raw[i + len] == raw[i + len - 3]) ++len;
+    if (len < 3) {
+      w.putSymbol((uint8_t) raw[i++]);
+      continue;
+    }
+    uint8_t code = 0;
+    while (code + 1u < sizeof(lengthBase) / sizeof(lengthBase[0]) && lengthBase[code + 1] <= len) ++code;
+    w.putSymbol(257 + code);
+    w.put(len - lengthBase[code], lengthExtra[code]);
+    w.putCode(2, 5); // distance 3
+    i += len;
+  }
+  w.putSymbol(256);
+  w.flush();
+}
+
+std::string TFT_eSPI::toPng() {
+  std::string raw; // filter byte 0 and RGB per row
+  for (int32_t y = 0; y < _height; ++y) {
+    raw += '\0';
+    for (int32_t x = 0; x < _width; ++x) {
+      uint16_t c = readPixel(x, y);
+      raw += (char) ((c >> 8 & 0xF8) | c >> 13);
+      raw += (char) ((c >> 3 & 0xFC) | (c >> 9 & 0x03));
+      raw += (char) ((c << 3 & 0xF8) | (c >> 2 & 0x07));
+    }
+  }
+
+  std::string zlib = "\x78\x01";
+  deflateFixed(zlib, raw);
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (unsigned char c : raw) {
+    a = (a + c) % 65521;
+    b = (b + a) % 65521;
+  }
+  appendBE32(zlib, b << 16 | a);
+
+  std::string header;
+  appendBE32(header, _width);
+  appendBE32(header, _height);
+  header += std::string("\x08\x02\x00\x00\x00", 5); // 8 bit, RGB
+
+  std::string png = "\x89PNG\r\n\x1a\n";
+  appendChunk(png, "IHDR", header);
+  appendChunk(png, "IDAT", zlib);
+  appendChunk(png, "IEND", "");
+  return png;
+}
+
+bool TFT_eSPI::writePng(const char *path) {
+  std::string png = toPng();
+  FILE *out = fopen(path, "wb");
+  if (out == nullptr) return false;
+  bool ok = fwrite(png.data(), 1, png.size(), out) == png.size();
+  return fclose(out) == 0 && ok;
+}
+
+// --- Sprite ---
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), _tft(tft), _created(false) {
+  _isPanel = false;
+}
+
+TFT_eSprite::~TFT_eSprite() {
+  deleteSprite();
+}
+
+void* TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames) {
+  (void) frames;
+  if (_created) return _pixels;
+  _pixels = (uint16_t *) calloc((size_t) w * h, sizeof(uint16_t));
+  if (_pixels == nullptr) return nullptr;
+  _width = _initWidth = w;
+  _height = _initHeight = h;
+  _created = true;
+  return _pixels;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(_pixels);
+  _pixels = nullptr;
+  _created = false;
+  _width = 0;
+  _height = 0;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  pushSprite(x, y, 0, 0, _width, _height);
+}
+
+// one transaction on the panel, the sprite pixels are RGB565 values
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh) {
+  if (!_created || sx < 0 || sy < 0 || sw <= 0 || sh <= 0 || sx + sw > _width || sy + sh > _height) return false;
+  int32_t cx = tx;
+  int32_t cy = ty;
+  int32_t cw = sw;
+  int32_t ch = sh;
+  if (!_tft->clip(cx, cy, cw, ch)) return true;
+  for (int32_t row = 0; row < ch; ++row) {
+    const uint16_t *src = _pixels + (sy + cy - ty + row) * _width + sx + (cx - tx);
+    memcpy(_tft->_pixels + (cy + row) * _tft->_width + cx, src, cw * sizeof(uint16_t));
+  }
+  _tft->countWindow(cw * ch);
+  return true;
+}
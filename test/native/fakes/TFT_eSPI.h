@@ -0,0 +1,124 @@
+#ifndef _fake_tft_espi_h_
+#define _fake_tft_espi_h_
+
+#include <Arduino.h>
+
+#include <string>
+
+#define TFT_BLACK 0x0000
+#define TFT_BLUE 0x001F
+#define TFT_RED 0xF800
+#define TFT_GREEN 0x07E0
+#define TFT_WHITE 0xFFFF
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH 128
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 160
+#endif
+
+// command and address bytes of an address window setup: CASET, RASET, RAMWR
+#define FAKE_TFT_WINDOW_BYTES 11
+
+namespace fake {
+
+// what went over SPI to the panel
+struct SpiStats {
+  uint32_t transactions; // one per drawing call, each sets an address window
+  uint64_t bytes;        // window setup and 2 bytes per pixel
+  uint64_t pixels;
+};
+
+}
+
+// The panel driver on an RGB565 framebuffer in memory (in the rotated
+// orientation, as the panel is seen). Every drawing call on the panel is
+// counted as one SPI transaction, so the cost of a frame can be measured.
+// Sprites draw into their own buffer, pushing one counts on its panel.
+// drawString() with the built-in fonts only returns the width, it draws nothing.
+class TFT_eSPI {
+
+    public:
+        TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+        virtual ~TFT_eSPI();
+
+        // allocates the framebuffer, cleared to black
+        void init();
+        void setRotation(uint8_t r);
+        uint8_t getRotation() { return _rotation; }
+        int16_t width() { return _width; }
+        int16_t height() { return _height; }
+        void setSwapBytes(bool swap) { _swapBytes = swap; }
+        bool getSwapBytes() { return _swapBytes; }
+        void setTextColor(uint16_t color) { _textColor = color; }
+        void setTextColor(uint16_t color, uint16_t bgColor) { (void) bgColor; _textColor = color; }
+        void setTextSize(uint8_t size) { _textSize = size; }
+
+        void drawPixel(int32_t x, int32_t y, uint32_t color);
+        void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+        // with swapBytes the data are RGB565 values, else in SPI byte order
+        void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+        void fillScreen(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+        void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { fillRect(x, y, w, 1, color); }
+        void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { fillRect(x, y, 1, h, color); }
+        void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+        void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+        int16_t drawString(const char *string, int32_t x, int32_t y, uint8_t font);
+        int16_t drawString(const String &string, int32_t x, int32_t y, uint8_t font) { return drawString(string.c_str(), x, y, font); }
+
+        uint16_t alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc);
+
+        // test access
+        uint16_t readPixel(int32_t x, int32_t y);
+        const uint16_t* pixels() { return _pixels; }
+        const fake::SpiStats& spiStats() { return _spi; }
+        void resetSpiStats() { _spi = fake::SpiStats(); }
+        // the framebuffer as RGB PNG
+        bool writePng(const char *path);
+        std::string toPng();
+
+    protected:
+        friend class TFT_eSprite;
+
+        // clips the rectangle, false if nothing is left
+        bool clip(int32_t &x, int32_t &y, int32_t &w, int32_t &h);
+        void countWindow(int32_t pixels);
+
+        int16_t _initWidth;
+        int16_t _initHeight;
+        int16_t _width;
+        int16_t _height;
+        uint8_t _rotation;
+        bool _swapBytes;
+        uint16_t _textColor;
+        uint8_t _textSize;
+        bool _isPanel; // false for a sprite, its drawing doesn't go over SPI
+        uint16_t *_pixels;
+        fake::SpiStats _spi;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+
+    public:
+        TFT_eSprite(TFT_eSPI *tft);
+        ~TFT_eSprite();
+
+        // allocates the pixel buffer on the heap, as TFT_eSPI does
+        void* createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+        void deleteSprite();
+        bool created() { return _created; }
+        void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+        void pushSprite(int32_t x, int32_t y);
+        bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+
+    protected:
+        TFT_eSPI *_tft;
+        bool _created;
+};
+
+#endif
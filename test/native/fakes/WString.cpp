@@ -0,0 +1,344 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const String emptyString;
+
+String::String(const char *cstr) : _heap(nullptr), _cap(0), _len(0) {
+  _sso[0] = '\0';
+  if (cstr != nullptr) assign(cstr, strlen(cstr));
+}
+
+String::String(const char *cstr, size_t length) : _heap(nullptr), _cap(0), _len(0) {
+  _sso[0] = '\0';
+  assign(cstr, length);
+}
+
+String::String(const String &str) : _heap(nullptr), _cap(0), _len(0) {
+  _sso[0] = '\0';
+  assign(str.buffer(), str._len);
+}
+
+String::String(String &&str) : _heap(str._heap), _cap(str._cap), _len(str._len) {
+  memcpy(_sso, str._sso, sizeof(_sso));
+  str._heap = nullptr;
+  str._cap = 0;
+  str._len = 0;
+  str._sso[0] = '\0';
+}
+
+String::String(const __FlashStringHelper *str) : String((const char *) str) {
+}
+
+String::String(char c) : _heap(nullptr), _cap(0), _len(0) {
+  _sso[0] = '\0';
+  assign(&c, 1);
+}
+
+static void formatInteger(char *buf, size_t size, unsigned long value, bool negative, unsigned char base) {
+  char digits[66];
+  uint8_t n = 0;
+  if (base < 2) base = 10;
+  do {
+    uint8_t d = value % base;
+    digits[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+    value /= base;
+  } while (value > 0);
+  size_t len = 0;
+  if (negative && len + 1 < size) buf[len++] = '-';
+  while (n > 0 && len + 1 < size) buf[len++] = digits[--n];
+  buf[len] = '\0';
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long) value, base) {
+}
+
+String::String(int value, unsigned char base) : String((long) value, base) {
+}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long) value, base) {
+}
+
+String::String(long value, unsigned char base) : _heap(nullptr), _cap(0), _len(0) {
+  char buf[68];
+  if (base == 10 && value < 0) {
+    formatInteger(buf, sizeof(buf), 0UL - (unsigned long) value, true, base);
+  } else {
+    formatInteger(buf, sizeof(buf), (unsigned long) value, false, base);
+  }
+  _sso[0] = '\0';
+  assign(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) : _heap(nullptr), _cap(0), _len(0) {
+  char buf[68];
+  formatInteger(buf, sizeof(buf), value, false, base);
+  _sso[0] = '\0';
+  assign(buf, strlen(buf));
+}
+
+String::String(float value, unsigned char decimals) : String((double) value, decimals) {
+}
+
+String::String(double value, unsigned char decimals) : _heap(nullptr), _cap(0), _len(0) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+  _sso[0] = '\0';
+  assign(buf, strlen(buf));
+}
+
+String::~String() {
+  free(_heap);
+}
+
+String& String::operator=(const String &rhs) {
+  if (this != &rhs) assign(rhs.buffer(), rhs._len);
+  return *this;
+}
+
+String& String::operator=(String &&rhs) {
+  if (this == &rhs) return *this;
+  free(_heap);
+  _heap = rhs._heap;
+  _cap = rhs._cap;
+  _len = rhs._len;
+  memcpy(_sso, rhs._sso, sizeof(_sso));
+  rhs._heap = nullptr;
+  rhs._cap = 0;
+  rhs._len = 0;
+  rhs._sso[0] = '\0';
+  return *this;
+}
+
+String& String::operator=(const char *cstr) {
+  if (cstr == nullptr) cstr = "";
+  // the source may point into this string
+  if (cstr >= buffer() && cstr <= buffer() + _len) {
+    String copy(cstr);
+    return *this = static_cast<String &&>(copy);
+  }
+  assign(cstr, strlen(cstr));
+  return *this;
+}
+
+bool String::reserve(size_t size) {
+  if (size <= STRING_SSO_LENGTH && _heap == nullptr) return true;
+  if (_heap != nullptr && size <= _cap) return true;
+  char *buf = (char *) malloc(size + 1);
+  if (buf == nullptr) return false;
+  memcpy(buf, buffer(), _len + 1);
+  free(_heap);
+  _heap = buf;
+  _cap = size;
+  return true;
+}
+
+void String::assign(const char *cstr, size_t length) {
+  if (!reserve(length)) return;
+  memmove(wbuffer(), cstr, length);
+  _len = length;
+  wbuffer()[_len] = '\0';
+}
+
+bool String::concat(const char *cstr, size_t length) {
+  if (length == 0) return true;
+  // the source may point into this string
+  size_t offset = (cstr >= buffer() && cstr < buffer() + _len) ? cstr - buffer() : SIZE_MAX;
+  if (!reserve(_len + length)) return false;
+  if (offset != SIZE_MAX) cstr = buffer() + offset;
+  memmove(wbuffer() + _len, cstr, length);
+  _len += length;
+  wbuffer()[_len] = '\0';
+  return true;
+}
+
+bool String::concat(const char *cstr) {
+  return cstr == nullptr ? false : concat(cstr, strlen(cstr));
+}
+
+int String::compareTo(const String &s) const {
+  return strcmp(buffer(), s.buffer());
+}
+
+bool String::equals(const String &s) const {
+  return _len == s._len && strcmp(buffer(), s.buffer()) == 0;
+}
+
+bool String::equals(const char *cstr) const {
+  if (cstr == nullptr) return _len == 0;
+  return strcmp(buffer(), cstr) == 0;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  return _len == s._len && strcasecmp(buffer(), s.buffer()) == 0;
+}
+
+bool String::startsWith(const String &prefix) const {
+  return startsWith(prefix.c_str());
+}
+
+bool String::startsWith(const char *prefix) const {
+  return strncmp(buffer(), prefix, strlen(prefix)) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return suffix._len <= _len && strcmp(buffer() + _len - suffix._len, suffix.buffer()) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return index < _len ? buffer()[index] : '\0';
+}
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < _len) wbuffer()[index] = c;
+}
+
+char& String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= _len) {
+    dummy = '\0';
+    return dummy;
+  }
+  return wbuffer()[index];
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  if (fromIndex >= _len) return -1;
+  const char *p = strchr(buffer() + fromIndex, c);
+  return p == nullptr ? -1 : (int) (p - buffer());
+}
+
+int String::indexOf(const char *str, unsigned int fromIndex) const {
+  if (fromIndex > _len) return -1;
+  const char *p = strstr(buffer() + fromIndex, str);
+  return p == nullptr ? -1 : (int) (p - buffer());
+}
+
+int String::lastIndexOf(char c) const {
+  const char *p = strrchr(buffer(), c);
+  return p == nullptr ? -1 : (int) (p - buffer());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    unsigned int tmp = beginIndex;
+    beginIndex = endIndex;
+    endIndex = tmp;
+  }
+  if (beginIndex >= _len) return String();
+  if (endIndex > _len) endIndex = _len;
+  return String(buffer() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace) {
+  for (char *p = wbuffer(); *p; ++p) {
+    if (*p == find) *p = replace;
+  }
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (find._len == 0) return;
+  String result;
+  const char *p = buffer();
+  const char *match;
+  while ((match = strstr(p, find.buffer())) != nullptr) {
+    result.concat(p, match - p);
+    result.concat(replace);
+    p = match + find._len;
+  }
+  result.concat(p);
+  *this = static_cast<String &&>(result);
+}
+
+void String::remove(unsigned int index) {
+  remove(index, (unsigned int) -1);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index >= _len) return;
+  if (count > _len - index) count = _len - index;
+  memmove(wbuffer() + index, buffer() + index + count, _len - index - count + 1);
+  _len -= count;
+}
+
+void String::toLowerCase() {
+  for (char *p = wbuffer(); *p; ++p) *p = tolower((unsigned char) *p);
+}
+
+void String::toUpperCase() {
+  for (char *p = wbuffer(); *p; ++p) *p = toupper((unsigned char) *p);
+}
+
+void String::trim() {
+  const char *b = buffer();
+  size_t start = 0;
+  while (start < _len && isspace((unsigned char) b[start])) ++start;
+  size_t end = _len;
+  while (end > start && isspace((unsigned char) b[end - 1])) --end;
+  memmove(wbuffer(), b + start, end - start);
+  _len = end - start;
+  wbuffer()[_len] = '\0';
+}
+
+long String::toInt() const {
+  return atol(buffer());
+}
+
+float String::toFloat() const {
+  return (float) atof(buffer());
+}
+
+double String::toDouble() const {
+  return atof(buffer());
+}
+
+String operator+(const String &lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, const char *rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const char *lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, char rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, int rhs) {
+  return lhs + String(rhs);
+}
+
+String operator+(const String &lhs, unsigned int rhs) {
+  return lhs + String(rhs);
+}
+
+String operator+(const String &lhs, long rhs) {
+  return lhs + String(rhs);
+}
+
+String operator+(const String &lhs, unsigned long rhs) {
+  return lhs + String(rhs);
+}
+
+String operator+(const String &lhs, float rhs) {
+  return lhs + String(rhs);
+}
+
+String operator+(const String &lhs, double rhs) {
+  return lhs + String(rhs);
+}
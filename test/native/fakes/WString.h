@@ -0,0 +1,117 @@
+#ifndef _fake_wstring_h_
+#define _fake_wstring_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class __FlashStringHelper;
+
+// Arduino String with the small string optimisation of the ESP8266 core:
+// up to STRING_SSO_LENGTH characters are kept inline, longer ones on the heap.
+// So an allocation counted on the host is one on the device, too.
+#define STRING_SSO_LENGTH 10
+
+class String {
+
+    public:
+        String(const char *cstr = "");
+        String(const char *cstr, size_t length);
+        String(const String &str);
+        String(String &&str);
+        String(const __FlashStringHelper *str);
+        explicit String(char c);
+        explicit String(unsigned char value, unsigned char base = 10);
+        explicit String(int value, unsigned char base = 10);
+        explicit String(unsigned int value, unsigned char base = 10);
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimals = 2);
+        explicit String(double value, unsigned char decimals = 2);
+        ~String();
+
+        String& operator=(const String &rhs);
+        String& operator=(String &&rhs);
+        String& operator=(const char *cstr);
+
+        bool reserve(size_t size);
+        size_t length() const { return _len; }
+        const char* c_str() const { return buffer(); }
+        bool isEmpty() const { return _len == 0; }
+
+        bool concat(const char *cstr, size_t length);
+        bool concat(const String &str) { return concat(str.c_str(), str._len); }
+        bool concat(const char *cstr);
+        bool concat(char c) { return concat(&c, 1); }
+        bool concat(unsigned char value) { return concat(String(value)); }
+        bool concat(int value) { return concat(String(value)); }
+        bool concat(unsigned int value) { return concat(String(value)); }
+        bool concat(long value) { return concat(String(value)); }
+        bool concat(unsigned long value) { return concat(String(value)); }
+        bool concat(float value) { return concat(String(value)); }
+        bool concat(double value) { return concat(String(value)); }
+
+        template <typename T> String& operator+=(const T &rhs) { concat(rhs); return *this; }
+        String& operator+=(const char *cstr) { concat(cstr); return *this; }
+
+        int compareTo(const String &s) const;
+        bool equals(const String &s) const;
+        bool equals(const char *cstr) const;
+        bool equalsIgnoreCase(const String &s) const;
+        bool operator==(const String &rhs) const { return equals(rhs); }
+        bool operator==(const char *cstr) const { return equals(cstr); }
+        bool operator!=(const String &rhs) const { return !equals(rhs); }
+        bool operator!=(const char *cstr) const { return !equals(cstr); }
+        bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+        bool startsWith(const String &prefix) const;
+        bool startsWith(const char *prefix) const;
+        bool endsWith(const String &suffix) const;
+
+        char charAt(unsigned int index) const;
+        void setCharAt(unsigned int index, char c);
+        char operator[](unsigned int index) const { return charAt(index); }
+        char& operator[](unsigned int index);
+
+        int indexOf(char c, unsigned int fromIndex = 0) const;
+        int indexOf(const char *str, unsigned int fromIndex = 0) const;
+        int indexOf(const String &str, unsigned int fromIndex = 0) const { return indexOf(str.c_str(), fromIndex); }
+        int lastIndexOf(char c) const;
+        String substring(unsigned int beginIndex) const { return substring(beginIndex, _len); }
+        String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+        void replace(char find, char replace);
+        void replace(const String &find, const String &replace);
+        void remove(unsigned int index);
+        void remove(unsigned int index, unsigned int count);
+        void toLowerCase();
+        void toUpperCase();
+        void trim();
+
+        long toInt() const;
+        float toFloat() const;
+        double toDouble() const;
+
+    protected:
+        const char* buffer() const { return _heap ? _heap : _sso; }
+        char* wbuffer() { return _heap ? _heap : _sso; }
+        void assign(const char *cstr, size_t length);
+
+        char *_heap;  // nullptr while the string fits into _sso
+        size_t _cap;  // of _heap
+        size_t _len;
+        char _sso[STRING_SSO_LENGTH + 1];
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+String operator+(const String &lhs, int rhs);
+String operator+(const String &lhs, unsigned int rhs);
+String operator+(const String &lhs, long rhs);
+String operator+(const String &lhs, unsigned long rhs);
+String operator+(const String &lhs, float rhs);
+String operator+(const String &lhs, double rhs);
+
+extern const String emptyString;
+
+#endif
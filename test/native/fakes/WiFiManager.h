@@ -0,0 +1,17 @@
+#ifndef _fake_wifimanager_h_
+#define _fake_wifimanager_h_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+// The portal is never shown: autoConnect() connects if the fake WiFi is up.
+class WiFiManager {
+
+    public:
+        void setConfigPortalTimeout(unsigned long seconds) { (void) seconds; }
+        void setDebugOutput(bool debug) { (void) debug; }
+        bool autoConnect(const char *apName) { (void) apName; return WiFi.begin() == WL_CONNECTED; }
+        void resetSettings() {}
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _fake_wire_h_
+#define _fake_wire_h_
+
+#include <Arduino.h>
+
+class TwoWire {
+
+    public:
+        void begin() {}
+        void begin(int sda, int scl) { (void) sda; (void) scl; }
+        void setClock(uint32_t frequency) { (void) frequency; }
+};
+
+extern TwoWire Wire;
+
+#endif
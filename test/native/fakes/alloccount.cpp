@@ -0,0 +1,95 @@
+#include "alloccount.h"
+
+#include <new>
+#include <stdlib.h>
+
+static fake::AllocStats stats = { 0, 0, 0 };
+
+fake::AllocStats fake::allocStats() {
+  return stats;
+}
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void* malloc(size_t size) {
+  ++stats.allocs;
+  stats.bytes += size;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  ++stats.allocs;
+  stats.bytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void *ptr, size_t size) {
+  // a realloc may move the block, count it as a new allocation
+  ++stats.allocs;
+  stats.bytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+  if (ptr != nullptr) ++stats.frees;
+  __libc_free(ptr);
+}
+
+}
+
+bool fake::allocCountSupported() {
+  return true;
+}
+
+#else
+
+bool fake::allocCountSupported() {
+  return false;
+}
+
+#endif
+
+// new/delete go through malloc/free, libstdc++ does so as well, but a
+// replacement makes sure the counting doesn't depend on it
+void* operator new(size_t size) {
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t &) noexcept {
+  return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept {
+  (void) size;
+  free(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept {
+  (void) size;
+  free(ptr);
+}
@@ -0,0 +1,37 @@
+#ifndef _fake_alloccount_h_
+#define _fake_alloccount_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap allocations of the whole program: operator new/delete and
+// malloc/calloc/realloc/free are counted (glibc only, elsewhere the
+// counters stay 0 and supported() is false).
+namespace fake {
+
+struct AllocStats {
+  uint64_t allocs;
+  uint64_t frees;
+  uint64_t bytes; // requested by allocs
+};
+
+AllocStats allocStats();
+bool allocCountSupported();
+
+// allocations since construction or the last reset()
+class AllocCounter {
+
+    public:
+        AllocCounter() { reset(); }
+
+        void reset() { _start = allocStats(); }
+        uint64_t allocs() const { return allocStats().allocs - _start.allocs; }
+        uint64_t bytes() const { return allocStats().bytes - _start.bytes; }
+
+    protected:
+        AllocStats _start;
+};
+
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _fake_coredecls_h_
+#define _fake_coredecls_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 as in the ESP8266 core (polynomial 0x04c11db7, MSB first)
+uint32_t crc32(const void *data, size_t length, uint32_t crc = 0xffffffff);
+
+#endif
@@ -0,0 +1,261 @@
+#include "ezTime.h"
+
+#include <ESP8266WiFi.h>
+
+#define NTP_RETRY_SEC 20
+
+namespace fake {
+  time_t ntpReply = 0;
+  uint32_t ntpQueries = 0;
+  uint32_t ntpTimeoutMs = 1500;
+}
+
+static timeStatus_t status = timeNotSet;
+static time_t utcAtSet = 0;
+static uint64_t microsAtSet = 0;
+static uint16_t ntpInterval = 1801;
+static uint32_t nextNtpMs = 0;
+static time_t lastMinute = -1;
+static time_t lastSecond = -1;
+
+Timezone UTC;
+Timezone *defaultTZ = &UTC;
+
+static time_t utcNow() {
+  if (status == timeNotSet) return (time_t) (fake::clockMicros / 1000000);
+  return utcAtSet + (time_t) ((fake::clockMicros - microsAtSet) / 1000000);
+}
+
+void fake::setUtc(time_t utc) {
+  utcAtSet = utc;
+  microsAtSet = fake::clockMicros;
+  status = timeSet;
+}
+
+void fake::clearTime() {
+  status = timeNotSet;
+  nextNtpMs = 0;
+}
+
+// the time of an NTP answer, 0 = no answer
+static time_t ntpAnswer() {
+  ++fake::ntpQueries;
+  if (fake::ntpReply == 0 || WiFi.status() != WL_CONNECTED) {
+    fake::advance(fake::ntpTimeoutMs);
+    return 0;
+  }
+  return fake::ntpReply + (time_t) (fake::clockMicros / 1000000);
+}
+
+timeStatus_t timeStatus() {
+  return status;
+}
+
+void setServer(const String &server) {
+  (void) server;
+}
+
+void setInterval(uint16_t seconds) {
+  ntpInterval = seconds;
+}
+
+bool updateNTP() {
+  time_t t = ntpAnswer();
+  if (t == 0) {
+    nextNtpMs = millis() + NTP_RETRY_SEC * 1000;
+    if (status == timeSet) status = timeNeedsSync;
+    return false;
+  }
+  fake::setUtc(t);
+  nextNtpMs = millis() + ntpInterval * 1000UL;
+  return true;
+}
+
+void events() {
+  if (ntpInterval > 0 && (int32_t) (millis() - nextNtpMs) >= 0) updateNTP();
+}
+
+bool minuteChanged() {
+  time_t m = utcNow() / 60;
+  if (m == lastMinute) return false;
+  lastMinute = m;
+  return true;
+}
+
+bool secondChanged() {
+  time_t s = utcNow();
+  if (s == lastSecond) return false;
+  lastSecond = s;
+  return true;
+}
+
+time_t now() {
+  return defaultTZ->now();
+}
+
+bool waitForSync(uint16_t timeout) {
+  (void) timeout;
+  if (status == timeNotSet) updateNTP();
+  return status != timeNotSet;
+}
+
+Timezone::Timezone() : _stdOffset(0), _dstOffset(0), _hasDst(false), _dstStart{}, _dstEnd{} {
+  strlcpy(_posix, "UTC", sizeof(_posix));
+}
+
+static const char* parseName(const char *p) {
+  if (*p == '<') {
+    while (*p != '\0' && *p != '>') ++p;
+    return *p == '>' ? p + 1 : p;
+  }
+  while (isalpha((unsigned char) *p)) ++p;
+  return p;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static const char* parseTime(const char *p, int32_t &seconds) {
+  int32_t sign = 1;
+  if (*p == '+' || *p == '-') sign = *p++ == '-' ? -1 : 1;
+  int32_t parts[3] = { 0, 0, 0 };
+  for (uint8_t i = 0; i < 3; ++i) {
+    while (isdigit((unsigned char) *p)) parts[i] = parts[i] * 10 + *p++ - '0';
+    if (*p != ':') break;
+    ++p;
+  }
+  seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+  return p;
+}
+
+// Mm.w.d[/time]
+static const char* parseRule(const char *p, uint8_t &month, uint8_t &week, uint8_t &weekday, int32_t &time) {
+  if (*p++ != 'M') return nullptr;
+  month = (uint8_t) strtoul(p, (char **) &p, 10);
+  if (*p++ != '.') return nullptr;
+  week = (uint8_t) strtoul(p, (char **) &p, 10);
+  if (*p++ != '.') return nullptr;
+  weekday = (uint8_t) strtoul(p, (char **) &p, 10);
+  time = 7200;
+  if (*p == '/') p = parseTime(p + 1, time);
+  return month >= 1 && month <= 12 && week >= 1 && week <= 5 && weekday <= 6 ? p : nullptr;
+}
+
+bool Timezone::setPosix(const String &posix) {
+  const char *p = posix.c_str();
+  const char *name = parseName(p);
+  if (name == p) return false;
+  int32_t stdOffset;
+  p = parseTime(name, stdOffset);
+  bool hasDst = false;
+  int32_t dstOffset = stdOffset - 3600;
+  Rule start = {};
+  Rule end = {};
+  if (*p != '\0') {
+    const char *dstName = parseName(p);
+    if (dstName == p) return false;
+    p = dstName;
+    if (*p != ',' && *p != '\0') p = parseTime(p, dstOffset);
+    if (*p != ',') return false;
+    p = parseRule(p + 1, start.month, start.week, start.weekday, start.time);
+    if (p == nullptr || *p != ',') return false;
+    p = parseRule(p + 1, end.month, end.week, end.weekday, end.time);
+    if (p == nullptr || *p != '\0') return false;
+    hasDst = true;
+  }
+  strlcpy(_posix, posix.c_str(), sizeof(_posix));
+  _stdOffset = stdOffset;
+  _dstOffset = dstOffset;
+  _hasDst = hasDst;
+  _dstStart = start;
+  _dstEnd = end;
+  return true;
+}
+
+// the UTC time of a rule in year, offset is the one in effect before the switch
+time_t Timezone::ruleTime(const Rule &rule, int year, int32_t offset) {
+  struct tm tm = {};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = rule.month - 1;
+  tm.tm_mday = 1;
+  time_t first = timegm(&tm);
+  int firstWeekday = (int) ((first / 86400 + 4) % 7);
+  int mday = 1 + (rule.weekday - firstWeekday + 7) % 7 + (rule.week - 1) * 7;
+  static const uint8_t monthDays[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  while (mday > monthDays[rule.month - 1]) mday -= 7;
+  if (rule.month == 2 && mday == 29 && !(year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) mday -= 7;
+  return first + (mday - 1) * 86400 + rule.time + offset;
+}
+
+bool Timezone::isDST(time_t utc) {
+  if (!_hasDst) return false;
+  struct tm tm;
+  gmtime_r(&utc, &tm);
+  int year = tm.tm_year + 1900;
+  time_t start = ruleTime(_dstStart, year, _stdOffset);
+  time_t end = ruleTime(_dstEnd, year, _dstOffset);
+  return start < end ? utc >= start && utc < end : utc >= start || utc < end;
+}
+
+int16_t Timezone::getOffset(time_t utc) {
+  return (int16_t) ((isDST(utc) ? _dstOffset : _stdOffset) / 60);
+}
+
+time_t Timezone::now() {
+  return tzTime(utcNow());
+}
+
+void Timezone::setTime(time_t t, uint16_t ms) {
+  // set in this zone's local time, like ezTime
+  fake::setUtc(t + getOffset(t) * 60);
+  microsAtSet -= ms * 1000ULL;
+}
+
+bool Timezone::toBrokenDown(time_t t, ezLocalOrUTC_t localOrUtc, struct tm &tm) {
+  if (t == TIME_NOW || t == LAST_READ) {
+    t = now();
+  } else if (localOrUtc == UTC_TIME) {
+    t = tzTime(t);
+  }
+  return gmtime_r(&t, &tm) != nullptr;
+}
+
+uint8_t Timezone::hour(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_hour;
+}
+
+uint8_t Timezone::minute(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_min;
+}
+
+uint8_t Timezone::second(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_sec;
+}
+
+uint8_t Timezone::day(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_mday;
+}
+
+uint8_t Timezone::month(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_mon + 1;
+}
+
+uint16_t Timezone::year(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_year + 1900;
+}
+
+uint8_t Timezone::weekday(time_t t, ezLocalOrUTC_t localOrUtc) {
+  struct tm tm;
+  toBrokenDown(t, localOrUtc, tm);
+  return tm.tm_wday + 1;
+}
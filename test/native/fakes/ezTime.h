@@ -0,0 +1,85 @@
+#ifndef _fake_eztime_h_
+#define _fake_eztime_h_
+
+#include <Arduino.h>
+#include <time.h>
+
+typedef enum { timeNotSet, timeNeedsSync, timeSet } timeStatus_t;
+typedef enum { LOCAL_TIME, UTC_TIME } ezLocalOrUTC_t;
+
+#define TIME_NOW ((time_t) 0x7FFFFFFF)
+#define LAST_READ ((time_t) 0x7FFFFFFE)
+
+// The ezTime API on the virtual clock. The time is set by fake::setUtc() or
+// by an NTP exchange (updateNTP()/events()) when fake::ntpReply is set. The
+// WiFiUDP fake answers NTP requests with fake::ntpReply as well.
+class Timezone {
+
+    public:
+        Timezone();
+
+        bool setPosix(const String &posix);
+        String getPosix() { return String(_posix); }
+        bool setLocation(const String &location) { (void) location; return false; }
+
+        time_t now();
+        void setTime(time_t t, uint16_t ms = 0);
+        uint8_t hour(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint8_t minute(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint8_t second(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint8_t day(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint8_t month(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint16_t year(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+        uint8_t weekday(time_t t = TIME_NOW, ezLocalOrUTC_t localOrUtc = LOCAL_TIME);
+
+        // offset of local time to UTC in minutes, as in ezTime: positive west of Greenwich
+        int16_t getOffset(time_t utc);
+        bool isDST(time_t utc);
+        time_t tzTime(time_t utc) { return utc - getOffset(utc) * 60; }
+
+    protected:
+        struct Rule {
+            uint8_t month;
+            uint8_t week;    // 1-5, 5 = last
+            uint8_t weekday; // 0 = Sunday
+            int32_t time;    // seconds after local midnight
+        };
+
+        bool toBrokenDown(time_t t, ezLocalOrUTC_t localOrUtc, struct tm &tm);
+        time_t ruleTime(const Rule &rule, int year, int32_t offset);
+
+        char _posix[64];
+        int32_t _stdOffset; // seconds, POSIX sign: positive west
+        int32_t _dstOffset;
+        bool _hasDst;
+        Rule _dstStart;
+        Rule _dstEnd;
+};
+
+extern Timezone UTC;
+extern Timezone *defaultTZ;
+
+timeStatus_t timeStatus();
+void setServer(const String &server);
+void setInterval(uint16_t seconds);
+bool updateNTP();
+void events();
+bool minuteChanged();
+bool secondChanged();
+time_t now();
+bool waitForSync(uint16_t timeout = 0);
+
+namespace fake {
+  // set the UTC time now, the time status becomes timeSet
+  void setUtc(time_t utc);
+  // back to timeNotSet
+  void clearTime();
+  // the UTC time an NTP server answers with, 0 = no answer
+  extern time_t ntpReply;
+  // NTP exchanges started by updateNTP() or events()
+  extern uint32_t ntpQueries;
+  // an NTP exchange blocks this long without an answer, as ezTime waits for one
+  extern uint32_t ntpTimeoutMs;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "fakesensors.h"
+#include "DallasTemperature.h"
+#include "Adafruit_Si7021.h"
+
+namespace fake {
+
+OneWireDevice oneWireDevices[FAKE_ONEWIRE_DEVICES];
+uint8_t oneWireDeviceCount = 0;
+uint32_t conversionMs = 750;
+I2cSensor bme280;
+I2cSensor si70xx;
+I2cSensor htu21;
+
+void clearSensors() {
+  oneWireDeviceCount = 0;
+  conversionMs = 750;
+  bme280 = I2cSensor{ false, 0x76, 21.5f, 45.0f, 98000.0f, 0, 0 };
+  si70xx = I2cSensor{ false, 0x40, 21.0f, 50.0f, 0.0f, SI_7021, 0 };
+  htu21 = I2cSensor{ false, 0x40, 20.5f, 55.0f, 0.0f, 0, 0 };
+}
+
+void addOneWireDevice(uint8_t serial, float tempC) {
+  if (oneWireDeviceCount == FAKE_ONEWIRE_DEVICES) return;
+  OneWireDevice &d = oneWireDevices[oneWireDeviceCount++];
+  const uint8_t addr[8] = { 0x28, serial, 0x4c, 0x07, 0xd6, 0x01, 0x3c, (uint8_t) (0x80 ^ serial) };
+  memcpy(d.addr, addr, sizeof(addr));
+  d.tempC = tempC;
+}
+
+static struct SensorInit {
+  SensorInit() { clearSensors(); }
+} sensorInit;
+
+}
+
+bool DallasTemperature::getAddress(uint8_t *addr, uint8_t index) {
+  if (index >= fake::oneWireDeviceCount) return false;
+  memcpy(addr, fake::oneWireDevices[index].addr, 8);
+  return true;
+}
+
+void DallasTemperature::requestTemperatures() {
+  _conversionStart = millis();
+  if (_wait) fake::advance(fake::conversionMs);
+}
+
+float DallasTemperature::getTempC(const uint8_t *addr) {
+  for (uint8_t i = 0; i < fake::oneWireDeviceCount; ++i) {
+    if (memcmp(addr, fake::oneWireDevices[i].addr, 8) == 0) return fake::oneWireDevices[i].tempC;
+  }
+  return DEVICE_DISCONNECTED_C;
+}
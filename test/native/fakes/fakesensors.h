@@ -0,0 +1,41 @@
+#ifndef _fake_sensors_h_
+#define _fake_sensors_h_
+
+#include <Arduino.h>
+
+#define FAKE_ONEWIRE_DEVICES 12
+
+// The sensors on the simulated bus, set by the test before the sensor setup.
+namespace fake {
+
+struct OneWireDevice {
+  uint8_t addr[8];
+  float tempC;
+};
+
+struct I2cSensor {
+  bool present;
+  uint8_t address;
+  float temperature;
+  float humidity;
+  float pressure; // Pa
+  uint8_t model;  // Si70xx only
+  uint32_t reads;
+};
+
+extern OneWireDevice oneWireDevices[FAKE_ONEWIRE_DEVICES];
+extern uint8_t oneWireDeviceCount;
+// a DS18B20 conversion takes this long
+extern uint32_t conversionMs;
+extern I2cSensor bme280;
+extern I2cSensor si70xx;
+extern I2cSensor htu21;
+
+// no sensors, default readings
+void clearSensors();
+// add a DS18B20 with a address derived from serial
+void addOneWireDevice(uint8_t serial, float tempC);
+
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _secret_h_
+#define _secret_h_
+
+#include <Arduino.h>
+
+// stands in for the untracked include/secret.h
+#define OPENWEATHERMAP_APIKEY "0123456789abcdef"
+#define OPENWEATHERMAP_CITYID "2950159"
+
+#endif
@@ -0,0 +1,117 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+#include <alloccount.h>
+
+// A node with display, 9 sensors, a connected broker and a full log. The
+// steady state - a sensor cycle with new values and the common web requests -
+// must not touch the heap, every allocation there fragments it over time.
+
+void setUp() {}
+
+void tearDown() {}
+
+void setupNode() {
+  fake::serialQuiet = true;
+  fake::ntpReply = 1700000000;
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 4.25f);
+  fake::addOneWireDevice(3, 18.0f);
+  fake::bme280.present = true;
+  fake::si70xx.present = true;
+  LittleFS.setContent("/config.cfg",
+    "node=alloc\r\n"
+    "topic=home.ground\r\n"
+    "sto=30\r\n"
+    "hasDisplay\r\n"
+    "outdoor=home.garden.temperature\r\n"
+    "remote-0=home.garden.temperature\r\n"
+    "show=28014C07D6013C81\r\n"
+    "sensor-28014C07D6013C81=living.window\r\n"
+    "sensor.enabled-28014C07D6013C81=1\r\n"
+    "sensor-76t=living.bme\r\n"
+    "sensor.enabled-76t=1\r\n"
+    "sensor-40h=bath.humidity\r\n"
+    "sensor.enabled-40h=1\r\n"
+    "sensor-a=living.light\r\n"
+    "sensor.enabled-a=1\r\n");
+  setup();
+  mqttReconnect();
+  fake::broker->inject("home/garden/temperature", "temperature,location=garden,node=n2,sensor=DS18B20 value=4.50");
+  mqttClient.loop();
+
+  for (uint16_t i = 0; i < 200; ++i) {
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Sensor %u read %d in %lu ms", i % 9, 20 + i % 5, 12UL + i % 7);
+  }
+}
+
+// new readings, so every value and the display change
+void changeReadings(uint32_t i) {
+  for (uint8_t d = 0; d < fake::oneWireDeviceCount; ++d) {
+    fake::oneWireDevices[d].tempC = 18.0f + d + (i % 50) * 0.0625f;
+  }
+  fake::bme280.temperature = 21.0f + (i % 10) * 0.25f;
+  fake::si70xx.humidity = 50.0f + (i % 10);
+  fake::advance(30000);
+}
+
+void test_update_does_not_allocate() {
+  TEST_ASSERT_TRUE(hasDisplay);
+  TEST_ASSERT_TRUE(mqttClient.connected());
+  // the first cycles fill the caches and the display
+  for (uint32_t i = 0; i < 3; ++i) {
+    changeReadings(i);
+    update();
+  }
+
+  fake::AllocCounter allocs;
+  uint32_t frames = displayStats.frames;
+  uint64_t publishes = fake::broker->publishes;
+  for (uint32_t i = 3; i < 20; ++i) {
+    changeReadings(i);
+    update();
+  }
+  TEST_ASSERT_EQUAL(0, allocs.allocs());
+  // the cycles did their work
+  TEST_ASSERT_EQUAL(frames + 17, displayStats.frames);
+  TEST_ASSERT_TRUE(fake::broker->publishes > publishes);
+}
+
+void requestWithoutAlloc(const char *uri, const char *query) {
+  // the first request sizes the buffers of the fake server
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, uri, query));
+  fake::AllocCounter allocs;
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, uri, query));
+  TEST_ASSERT_EQUAL_MESSAGE(0, allocs.allocs(), uri);
+  TEST_ASSERT_TRUE(espServer.body.size() > 2);
+}
+
+void test_sensors_request_does_not_allocate() {
+  requestWithoutAlloc("/sensors", nullptr);
+}
+
+void test_config_request_does_not_allocate() {
+  requestWithoutAlloc("/config", nullptr);
+}
+
+void test_logs_request_does_not_allocate() {
+  requestWithoutAlloc("/logs", "id=0");
+  char query[16];
+  snprintf(query, sizeof(query), "id=%lu", (unsigned long) logRing.getNextId() - 5);
+  requestWithoutAlloc("/logs", query);
+}
+
+int main() {
+  fake::powerOn();
+  setupNode();
+
+  UNITY_BEGIN();
+  if (fake::allocCountSupported()) {
+    RUN_TEST(test_update_does_not_allocate);
+    RUN_TEST(test_sensors_request_does_not_allocate);
+    RUN_TEST(test_config_request_does_not_allocate);
+    RUN_TEST(test_logs_request_does_not_allocate);
+  }
+  return UNITY_END();
+}
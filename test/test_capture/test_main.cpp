@@ -0,0 +1,154 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::clearSensors();
+  fake::broker->reset();
+  LittleFS.clear();
+  memset(sensors, 0, sizeof(sensors));
+  oneWireDeviceCount = 0;
+  rootTopic = "home";
+  nodeName = "cellar";
+  captureEnabled = true;
+  captureMqtt = false;
+  captureTableDue = true;
+  captureCount = 0;
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 4.25f);
+  setupOneWireSensors();
+  setupAnalogSensor();
+  sensors[0].correction = -0.5f;
+}
+
+void tearDown() {
+  mqttClient.disconnect();
+}
+
+void captureCycles(uint8_t cycles) {
+  for (uint8_t i = 0; i < cycles; ++i) {
+    fake::advance(30000);
+    fetchSensorValues();
+    flushCapture();
+  }
+}
+
+const size_t TABLE_SIZE = 5 + 3 * sizeof(CaptureSensor);
+
+void test_readings_are_appended_to_the_file() {
+  captureCycles(2);
+
+  std::vector<uint8_t> *data = LittleFS.data(CAPTURE_FILE);
+  TEST_ASSERT_NOT_NULL(data);
+  TEST_ASSERT_EQUAL(TABLE_SIZE + 6 * sizeof(CaptureRecord), data->size());
+  TEST_ASSERT_EQUAL_MEMORY(CAPTURE_MAGIC, data->data(), 4);
+  TEST_ASSERT_EQUAL(3, (*data)[4]);
+  const CaptureSensor *cs = (const CaptureSensor *) &(*data)[5];
+  TEST_ASSERT_EQUAL_STRING("28014C07D6013C81", cs[0].id);
+  TEST_ASSERT_EQUAL_FLOAT(-0.5f, cs[0].correction);
+  // raw, without the correction, with the uptime before NTP is synced
+  const CaptureRecord *cr = (const CaptureRecord *) &(*data)[TABLE_SIZE];
+  TEST_ASSERT_EQUAL(0 | CAPTURE_UPTIME, cr[0].sensor);
+  TEST_ASSERT_EQUAL(30, cr[0].time);
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, cr[0].raw);
+  TEST_ASSERT_EQUAL(2 | CAPTURE_UPTIME, cr[5].sensor);
+  TEST_ASSERT_TRUE(cr[5].time >= 60);
+}
+
+void test_full_file_stops_the_capture_for_good() {
+  std::string full(CAPTURE_MAX_SIZE - 10, 'x');
+  LittleFS.setContent(CAPTURE_FILE, full);
+  LittleFS.setContent("/config.cfg", "node=cellar\r\ncapture\r\n");
+  uint32_t version = configVersion;
+
+  captureCycles(1);
+
+  TEST_ASSERT_FALSE(captureEnabled);
+  TEST_ASSERT_EQUAL(full.size(), LittleFS.data(CAPTURE_FILE)->size());
+  // saved, so it stays off after a reboot
+  TEST_ASSERT_TRUE(LittleFS.getContent("/config.cfg").find("capture") == std::string::npos);
+  TEST_ASSERT_TRUE(configVersion > version);
+}
+
+void test_mqtt_messages_make_up_a_capture_file() {
+  captureMqtt = true;
+  WiFi.begin();
+  TEST_ASSERT_TRUE(mqttClient.connect("cellar"));
+  captureCycles(2);
+
+  TEST_ASSERT_NULL(LittleFS.data(CAPTURE_FILE));
+  fake::MqttBroker &b = *fake::broker;
+  TEST_ASSERT_EQUAL(3, b.publishes);
+  TEST_ASSERT_EQUAL(1, b.retainedCount);
+  TEST_ASSERT_EQUAL_STRING("home/cellar/capture/sensors", b.retained[0].topic);
+  TEST_ASSERT_EQUAL(TABLE_SIZE, b.retained[0].length);
+
+  // the table and the data messages in order, as mosquitto_sub -N writes them
+  std::vector<uint8_t> stream;
+  for (int n = 2; n >= 0; --n) {
+    const fake::MqttMessage *m = b.last(n);
+    stream.insert(stream.end(), m->payload, m->payload + m->length);
+  }
+  TEST_ASSERT_EQUAL_STRING("home/cellar/capture/data", b.last()->topic);
+  TEST_ASSERT_EQUAL(3 * sizeof(CaptureRecord), b.last()->length);
+
+  LittleFS.clear();
+  captureMqtt = false;
+  captureTableDue = true;
+  sensors[1].version = 0;
+  fake::setMillis(0);
+  captureCycles(2);
+  std::vector<uint8_t> *file = LittleFS.data(CAPTURE_FILE);
+  TEST_ASSERT_EQUAL(file->size(), stream.size());
+  TEST_ASSERT_EQUAL_MEMORY(file->data(), stream.data(), stream.size());
+}
+
+void test_table_is_repeated_after_a_config_change() {
+  captureCycles(1);
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  espServer.request(HTTP_POST, "/", nullptr, "node=cellar&topic=home&capture=on&cor-28014C07D6013C81=0.75");
+  captureCycles(1);
+
+  std::vector<uint8_t> *data = LittleFS.data(CAPTURE_FILE);
+  size_t second = TABLE_SIZE + 3 * sizeof(CaptureRecord);
+  // the POST fetches the values with the new correction, they are flushed with the next cycle
+  TEST_ASSERT_EQUAL(2 * TABLE_SIZE + 9 * sizeof(CaptureRecord), data->size());
+  TEST_ASSERT_EQUAL_MEMORY(CAPTURE_MAGIC, &(*data)[second], 4);
+  const CaptureSensor *cs = (const CaptureSensor *) &(*data)[second + 5];
+  TEST_ASSERT_EQUAL_FLOAT(0.75f, cs[0].correction);
+}
+
+void test_only_post_clears_the_file() {
+  espServer.on("/capture", HTTP_GET, handleGetCapture);
+  espServer.on("/capture", HTTP_POST, handlePostCapture);
+  captureCycles(1);
+
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, "/capture", "clear=1"));
+  TEST_ASSERT_NOT_NULL(LittleFS.data(CAPTURE_FILE));
+  TEST_ASSERT_EQUAL(LittleFS.data(CAPTURE_FILE)->size(), espServer.body.size());
+
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_POST, "/capture"));
+  TEST_ASSERT_NULL(LittleFS.data(CAPTURE_FILE));
+  TEST_ASSERT_EQUAL(404, espServer.request(HTTP_GET, "/capture"));
+}
+
+void test_unknown_sensors_are_not_recorded() {
+  setSensorDataValue("28FFFFFFFFFFFFFF", 30.0f);
+  setSensorDataValue("a", 512.0f);
+  TEST_ASSERT_EQUAL(1, captureCount);
+  TEST_ASSERT_EQUAL(2 | CAPTURE_UPTIME, captureBuffer[0].sensor);
+  TEST_ASSERT_EQUAL_FLOAT(512.0f, captureBuffer[0].raw);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings_are_appended_to_the_file);
+  RUN_TEST(test_full_file_stops_the_capture_for_good);
+  RUN_TEST(test_mqtt_messages_make_up_a_capture_file);
+  RUN_TEST(test_table_is_repeated_after_a_config_change);
+  RUN_TEST(test_only_post_clears_the_file);
+  RUN_TEST(test_unknown_sensors_are_not_recorded);
+  return UNITY_END();
+}
@@ -0,0 +1,300 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::clearSensors();
+  LittleFS.clear();
+  memset(sensors, 0, sizeof(sensors));
+  memset(remotes, 0, sizeof(remotes));
+  oneWireDeviceCount = 0;
+  nodeName = DEFAULT_NODE_NAME;
+  rootTopic = DEFAULT_ROOT_TOPIC;
+  nodeAltitude = 282.0f;
+  updateSensorsTimeout = 30;
+  heapLimit = DEFAULT_HEAP_LIMIT;
+  showSensor = "";
+  showOutdoor = OUTDOOR_OPENWEATHERMAP;
+  weatherLeader = false;
+  captureEnabled = false;
+  syslogServer = "";
+  syslogPlain = false;
+  hasDisplay = false;
+  for (uint8_t i = 0; i < LOGMODULE_COUNT; ++i) logLevels[i] = LOGLEVEL_INFO;
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 19.0f);
+  setupOneWireSensors();
+  setupAnalogSensor();
+}
+
+void tearDown() {}
+
+void loadConfigText(const char *text) {
+  LittleFS.setContent("/config.cfg", text);
+  TEST_ASSERT_TRUE(LittleFS.begin());
+  loadConfigFile();
+  LittleFS.end();
+}
+
+void test_settings_are_loaded() {
+  loadConfigText(
+    "node=kitchen\r\n"
+    "topic=home.ground\r\n"
+    "altitude=410.50\r\n"
+    "sto=60\r\n"
+    "tz=UTC0\r\n"
+    "heaplimit=8000\r\n"
+    "loglevels=321012\r\n"
+    "syslog=10.0.0.2:5514\r\n"
+    "syslogplain\r\n"
+    "wfclead\r\n"
+    "show=28014C07D6013C81\r\n"
+    "outdoor=home.garden.temperature\r\n");
+
+  TEST_ASSERT_EQUAL_STRING("kitchen", nodeName.c_str());
+  TEST_ASSERT_EQUAL_STRING("home.ground", rootTopic.c_str());
+  TEST_ASSERT_EQUAL_FLOAT(410.5f, nodeAltitude);
+  TEST_ASSERT_EQUAL(60, updateSensorsTimeout);
+  TEST_ASSERT_EQUAL_STRING("UTC0", timezoneRules.c_str());
+  TEST_ASSERT_EQUAL(8000, heapLimit);
+  TEST_ASSERT_EQUAL(LOGLEVEL_DEBUG, logLevels[0]);
+  TEST_ASSERT_EQUAL(LOGLEVEL_ERROR, logLevels[3]);
+  TEST_ASSERT_EQUAL(LOGLEVEL_INFO, logLevels[5]);
+  TEST_ASSERT_EQUAL_STRING("10.0.0.2:5514", syslogServer.c_str());
+  TEST_ASSERT_TRUE(syslogPlain);
+  TEST_ASSERT_TRUE(weatherLeader);
+  TEST_ASSERT_EQUAL_STRING("28014C07D6013C81", showSensor.c_str());
+  TEST_ASSERT_EQUAL_STRING("home.garden.temperature", showOutdoor.c_str());
+}
+
+void test_sensor_settings_are_loaded() {
+  loadConfigText(
+    "topic=home\r\n"
+    "sensor-28024C07D6013C82=garden\r\n"
+    "sensor.enabled-28024C07D6013C82=1\r\n"
+    "sensor.correction-28024C07D6013C82=-0.75\r\n"
+    "sensor-a=hall\r\n"
+    "sensor.enabled-a=0\r\n");
+
+  SensorData &sd = getSensorData("28024C07D6013C82");
+  TEST_ASSERT_EQUAL_STRING("garden", sd.location);
+  TEST_ASSERT_EQUAL_STRING("home/garden", sd.topic);
+  TEST_ASSERT_TRUE(sd.enabled);
+  TEST_ASSERT_EQUAL_FLOAT(-0.75f, sd.correction);
+  TEST_ASSERT_EQUAL_STRING("hall", getSensorData("a").location);
+  TEST_ASSERT_FALSE(getSensorData("a").enabled);
+  // untouched
+  TEST_ASSERT_EQUAL_STRING("28014C07D6013C81", sensors[0].location);
+}
+
+void test_unknown_sensors_are_ignored() {
+  loadConfigText(
+    "sensor-DEADBEEF=attic\r\n"
+    "sensor.enabled-DEADBEEF=1\r\n");
+  TEST_ASSERT_EQUAL(3, numberOfSensors());
+  for (uint8_t i = 0; i < numberOfSensors(); ++i) {
+    TEST_ASSERT_FALSE(sensors[i].enabled);
+    TEST_ASSERT_EQUAL_STRING(sensors[i].id, sensors[i].location);
+  }
+}
+
+void test_missing_config_keeps_defaults() {
+  TEST_ASSERT_TRUE(LittleFS.begin());
+  loadConfigFile();
+  LittleFS.end();
+  TEST_ASSERT_EQUAL_STRING(DEFAULT_NODE_NAME, nodeName.c_str());
+  TEST_ASSERT_EQUAL(30, updateSensorsTimeout);
+}
+
+void test_saved_config_loads_back() {
+  nodeName = "hall";
+  rootTopic = "home.first";
+  nodeAltitude = 123.25f;
+  heapLimit = 6000;
+  logLevels[2] = LOGLEVEL_DEBUG;
+  syslogServer = "logs.local";
+  setRemoteSource(1, "home.garden.temperature");
+  strlcpy(sensors[1].location, "bath", SENSOR_LOCATION_LENGTH);
+  sensors[1].enabled = true;
+  sensors[1].correction = 1.5f;
+  saveConfig();
+  std::string saved = LittleFS.getContent("/config.cfg");
+  TEST_ASSERT_TRUE(saved.find("node=hall\r\n") == 0);
+
+  nodeName = "";
+  rootTopic = "";
+  nodeAltitude = 0;
+  heapLimit = 0;
+  logLevels[2] = LOGLEVEL_INFO;
+  syslogServer = "";
+  memset(remotes, 0, sizeof(remotes));
+  sensors[1].enabled = false;
+  sensors[1].correction = 0;
+  strlcpy(sensors[1].location, "x", SENSOR_LOCATION_LENGTH);
+
+  TEST_ASSERT_TRUE(LittleFS.begin());
+  loadConfigFile();
+  LittleFS.end();
+  TEST_ASSERT_EQUAL_STRING("hall", nodeName.c_str());
+  TEST_ASSERT_EQUAL_STRING("home.first", rootTopic.c_str());
+  TEST_ASSERT_EQUAL_FLOAT(123.25f, nodeAltitude);
+  TEST_ASSERT_EQUAL(6000, heapLimit);
+  TEST_ASSERT_EQUAL(LOGLEVEL_DEBUG, logLevels[2]);
+  TEST_ASSERT_EQUAL_STRING("logs.local", syslogServer.c_str());
+  TEST_ASSERT_EQUAL_STRING("home.garden.temperature", remotes[1].source);
+  TEST_ASSERT_EQUAL_STRING("bath", sensors[1].location);
+  TEST_ASSERT_EQUAL_STRING("home/first/bath", sensors[1].topic);
+  TEST_ASSERT_TRUE(sensors[1].enabled);
+  TEST_ASSERT_EQUAL_FLOAT(1.5f, sensors[1].correction);
+}
+
+void test_posted_form_is_applied_and_saved() {
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  const char *form = "node=Cellar&topic=home.basement&altitude=282.00&sensorcycle=45"
+    "&loc-28014C07D6013C81=shelf&en-28014C07D6013C81=on&cor-28014C07D6013C81=0.25"
+    "&tz=UTC0&heaplimit=5000&remote-0=home.garden.temperature&show=a";
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, form));
+  TEST_ASSERT_EQUAL_STRING("/", espServer.location);
+
+  // values are lower case, except the timezone
+  TEST_ASSERT_EQUAL_STRING("cellar", nodeName.c_str());
+  TEST_ASSERT_EQUAL_STRING("home.basement", rootTopic.c_str());
+  TEST_ASSERT_EQUAL(45, updateSensorsTimeout);
+  TEST_ASSERT_EQUAL_STRING("UTC0", timezoneRules.c_str());
+  TEST_ASSERT_EQUAL(5000, heapLimit);
+  TEST_ASSERT_EQUAL_STRING("home.garden.temperature", remotes[0].source);
+  TEST_ASSERT_EQUAL_STRING("a", showSensor.c_str());
+  TEST_ASSERT_EQUAL_STRING("shelf", sensors[0].location);
+  TEST_ASSERT_EQUAL_STRING("home/basement/shelf", sensors[0].topic);
+  TEST_ASSERT_TRUE(sensors[0].enabled);
+  TEST_ASSERT_EQUAL_FLOAT(0.25f, sensors[0].correction);
+  TEST_ASSERT_FALSE(sensors[1].enabled);
+
+  std::string saved = LittleFS.getContent("/config.cfg");
+  TEST_ASSERT_TRUE(saved.find("sensor-28014C07D6013C81=shelf\r\n") != std::string::npos);
+  TEST_ASSERT_TRUE(saved.find("remote-0=home.garden.temperature\r\n") != std::string::npos);
+}
+
+void test_too_long_location_is_rejected() {
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  strlcpy(sensors[0].location, "shelf", sizeof(sensors[0].location));
+  const char *form = "node=f42-node&topic=tmp&altitude=282.00&sensorcycle=30"
+    "&loc-28014C07D6013C81=ground.living.window.left.upper.sill"
+    "&loc-28024C07D6013C82=&loc-a=&heaplimit=4096";
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, form));
+  TEST_ASSERT_EQUAL_STRING("shelf", sensors[0].location);
+
+  // nothing changed, so the same form again is not saved
+  uint32_t version = configVersion;
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, form));
+  TEST_ASSERT_EQUAL(version, configVersion);
+}
+
+void test_too_long_topic_is_rejected() {
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  strlcpy(sensors[0].location, "shelf", sizeof(sensors[0].location));
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&topic=home.basement.north.wing"));
+  TEST_ASSERT_EQUAL_STRING(DEFAULT_ROOT_TOPIC, rootTopic.c_str());
+
+  loadConfigText("topic=home.basement.north.wing\r\n");
+  TEST_ASSERT_EQUAL_STRING(DEFAULT_ROOT_TOPIC, rootTopic.c_str());
+
+  // 20 chars are fine, with the longest location
+  loadConfigText("topic=home.basement.cellar\r\n");
+  strlcpy(sensors[0].location, "ground.living.window.left.high", sizeof(sensors[0].location));
+  updateSensorTopic(sensors[0]);
+  TEST_ASSERT_EQUAL_STRING("home/basement/cellar/ground/living/window/left/high", sensors[0].topic);
+}
+
+void test_too_high_heap_limit_is_rejected() {
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  ESP.freeHeap = 40000;
+  bootFreeHeap = 40000;
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&heaplimit=30000"));
+  TEST_ASSERT_EQUAL(DEFAULT_HEAP_LIMIT, heapLimit);
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&heaplimit=20000"));
+  TEST_ASSERT_EQUAL(20000, heapLimit);
+
+  // one from an old config is not applied, the node doesn't restart over and over
+  loadConfigText("heaplimit=30000\r\n");
+  ESP.freeHeap = 25000;
+  heapTask();
+  TEST_ASSERT_EQUAL(0, ESP.restarts);
+  heapLimit = 20000;
+  ESP.freeHeap = 19000;
+  heapTask();
+  TEST_ASSERT_EQUAL(1, ESP.restarts);
+  bootFreeHeap = 0;
+}
+
+void test_zero_cycles_are_not_applied() {
+  // 0 would run the sensor or weather task on every pass
+  loadConfigText("sto=0\r\nwfcto=soon\r\n");
+  TEST_ASSERT_EQUAL(MIN_CYCLE_SEC, updateSensorsTimeout);
+  TEST_ASSERT_EQUAL(MIN_CYCLE_SEC, updateWeatherForecastTimeout);
+
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&sensorcycle=30&forecastcycle=300"));
+  TEST_ASSERT_EQUAL(300, updateWeatherForecastTimeout);
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&sensorcycle=-5&forecastcycle=0"));
+  TEST_ASSERT_EQUAL(MIN_CYCLE_SEC, updateSensorsTimeout);
+  TEST_ASSERT_EQUAL(MIN_CYCLE_SEC, updateWeatherForecastTimeout);
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&sensorcycle=30&forecastcycle=70000"));
+  TEST_ASSERT_EQUAL(MAX_CYCLE_SEC, updateWeatherForecastTimeout);
+  updateWeatherForecastTimeout = 5 * 60;
+}
+
+void test_empty_syslog_server_turns_it_off() {
+  espServer.on("/", HTTP_POST, handlePostRoot);
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&syslog=192.168.1.5:514"));
+  TEST_ASSERT_EQUAL_STRING("192.168.1.5:514", syslogServer.c_str());
+  TEST_ASSERT_TRUE(LittleFS.getContent("/config.cfg").find("syslog=192.168.1.5:514\r\n") != std::string::npos);
+
+  TEST_ASSERT_EQUAL(303, espServer.request(HTTP_POST, "/", nullptr, "node=cellar&syslog="));
+  TEST_ASSERT_EQUAL(0, syslogServer.length());
+  TEST_ASSERT_TRUE(LittleFS.getContent("/config.cfg").find("syslog=") == std::string::npos);
+}
+
+void test_state_from_before_a_reboot_gets_everything() {
+  espServer.on("/state", HTTP_GET, handleGetState);
+  char query[48];
+  snprintf(query, sizeof(query), "since=%lu&id=%lu", (unsigned long) stateVersion + 100, (unsigned long) logRing.getNextId());
+  uint32_t start = millis();
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, "/state", query));
+  TEST_ASSERT_TRUE(espServer.body.find("\"config\":") != std::string::npos);
+  TEST_ASSERT_EQUAL(start, millis());
+}
+
+void test_state_answers_right_away() {
+  espServer.on("/state", HTTP_GET, handleGetState);
+  int8_t id = scheduler.add("other", logRepeatedSites, 0, TASK_PRIORITY_HIGH, 0);
+  char query[48];
+  snprintf(query, sizeof(query), "since=%lu&id=%lu", (unsigned long) stateVersion, (unsigned long) logRing.getNextId());
+  uint32_t start = millis();
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, "/state", query));
+  TEST_ASSERT_EQUAL(200, espServer.request(HTTP_GET, "/state", "since=0"));
+  TEST_ASSERT_EQUAL(start, millis());
+  // no other task runs while a request is half served
+  TEST_ASSERT_EQUAL(0, scheduler.getTask(id).runs);
+  scheduler.setEnabled(id, false);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_settings_are_loaded);
+  RUN_TEST(test_sensor_settings_are_loaded);
+  RUN_TEST(test_unknown_sensors_are_ignored);
+  RUN_TEST(test_missing_config_keeps_defaults);
+  RUN_TEST(test_saved_config_loads_back);
+  RUN_TEST(test_posted_form_is_applied_and_saved);
+  RUN_TEST(test_too_long_location_is_rejected);
+  RUN_TEST(test_too_long_topic_is_rejected);
+  RUN_TEST(test_too_high_heap_limit_is_rejected);
+  RUN_TEST(test_zero_cycles_are_not_applied);
+  RUN_TEST(test_empty_syslog_server_turns_it_off);
+  RUN_TEST(test_state_from_before_a_reboot_gets_everything);
+  RUN_TEST(test_state_answers_right_away);
+  return UNITY_END();
+}
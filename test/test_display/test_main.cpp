@@ -0,0 +1,108 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+#include <fstream>
+#include <sstream>
+
+// Golden image tests of display() on the framebuffer panel. The images are in
+// test/test_display/golden, a mismatch writes <name>.actual.png next to the
+// golden one. After an intended change of the layout rerun with
+// UPDATE_GOLDEN=1 to rewrite them, and check them by eye.
+#define GOLDEN_DIR "test/test_display/golden/"
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  LittleFS.clear();
+  LittleFS.loadDir("data");
+  hasDisplay = true;
+  setupDisplay();
+  tft.resetSpiStats();
+  displayStats = DisplayStats();
+}
+
+void tearDown() {}
+
+void assertGolden(const char *name) {
+  std::string path = std::string(GOLDEN_DIR) + name + ".png";
+  std::string png = tft.toPng();
+  if (getenv("UPDATE_GOLDEN") != nullptr) {
+    TEST_ASSERT_TRUE(tft.writePng(path.c_str()));
+    return;
+  }
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream golden;
+  golden << in.rdbuf();
+  if (golden.str() != png) {
+    tft.writePng((std::string(GOLDEN_DIR) + name + ".actual.png").c_str());
+    TEST_FAIL_MESSAGE(path.c_str());
+  }
+}
+
+void showDefault() {
+  display(tft, "21.5°C", "4.3°C", "04d.bmp", "12:34", "19.10.");
+}
+
+void test_full_frame() {
+  showDefault();
+  assertGolden("full");
+  // the whole screen once, then each widget
+  TEST_ASSERT_EQUAL(5, displayStats.lastWidgets);
+  TEST_ASSERT_EQUAL(160, tft.width());
+  TEST_ASSERT_EQUAL(TFT_WHITE, tft.readPixel(0, 0));
+  TEST_ASSERT_EQUAL(TFT_BLUE, tft.readPixel(20, 92));
+}
+
+void test_changed_value_is_one_block() {
+  showDefault();
+  tft.resetSpiStats();
+  display(tft, "-12.8°C", "4.3°C", "04d.bmp", "12:34", "19.10.");
+  assertGolden("inval");
+
+  // one window of the value area, as the firmware counts it
+  const fake::SpiStats &spi = tft.spiStats();
+  TEST_ASSERT_EQUAL(1, spi.transactions);
+  TEST_ASSERT_EQUAL(DISP_INVAL_AREA.w * DISP_INVAL_AREA.h, spi.pixels);
+  TEST_ASSERT_EQUAL(displayStats.lastBytes + FAKE_TFT_WINDOW_BYTES * displayStats.lastWindows, spi.bytes);
+}
+
+void test_unchanged_frame_sends_nothing() {
+  showDefault();
+  tft.resetSpiStats();
+  showDefault();
+  TEST_ASSERT_EQUAL(0, tft.spiStats().transactions);
+  TEST_ASSERT_EQUAL(0, displayStats.lastBytes);
+}
+
+void test_icon_and_clock() {
+  showDefault();
+  display(tft, "21.5°C", "17.0°C", "01d.bmp", "07:05", "01.01.");
+  assertGolden("icon_clock");
+}
+
+void test_direct_drawing_looks_the_same() {
+  showDefault();
+  std::string withSprite = tft.toPng();
+  uint64_t spriteBytes = tft.spiStats().bytes;
+
+  // as if the heap was too short for the sprite
+  widgetSprite.deleteSprite();
+  shown.valid = false;
+  tft.resetSpiStats();
+  showDefault();
+  TEST_ASSERT_TRUE(withSprite == tft.toPng());
+  // but the glyph runs are single transactions
+  TEST_ASSERT_TRUE(tft.spiStats().transactions > 100);
+  TEST_ASSERT_TRUE(tft.spiStats().bytes > spriteBytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_frame);
+  RUN_TEST(test_changed_value_is_one_block);
+  RUN_TEST(test_unchanged_frame_sends_nothing);
+  RUN_TEST(test_icon_and_clock);
+  RUN_TEST(test_direct_drawing_looks_the_same);
+  return UNITY_END();
+}
@@ -0,0 +1,52 @@
+#ifndef _owm_responses_h_
+#define _owm_responses_h_
+
+// Responses of api.openweathermap.org/data/2.5/weather as recorded, the
+// city id and the coordinates replaced.
+
+// overcast night
+const char OWM_CLOUDS[] =
+  "{\"coord\":{\"lon\":9.18,\"lat\":48.78},"
+  "\"weather\":[{\"id\":804,\"main\":\"Clouds\",\"description\":\"overcast clouds\",\"icon\":\"04n\"}],"
+  "\"base\":\"stations\","
+  "\"main\":{\"temp\":280.69,\"feels_like\":279.16,\"temp_min\":279.82,\"temp_max\":282.59,\"pressure\":1020,\"humidity\":86},"
+  "\"visibility\":10000,"
+  "\"wind\":{\"speed\":0.68,\"deg\":32},"
+  "\"clouds\":{\"all\":92},"
+  "\"dt\":1602956848,"
+  "\"sys\":{\"type\":3,\"id\":2035315,\"country\":\"DE\",\"sunrise\":1602914215,\"sunset\":1602952394},"
+  "\"timezone\":7200,\"id\":2950159,\"name\":\"Stuttgart\",\"cod\":200}";
+
+// two weather entries, rain object, escapes in strings, pretty printed
+const char OWM_RAIN[] =
+  "{\n"
+  "  \"coord\": {\"lon\": 9.18, \"lat\": 48.78},\n"
+  "  \"weather\": [\n"
+  "    {\"id\": 501, \"main\": \"Rain\", \"description\": \"moderate \\\"rain\\\"\", \"icon\": \"10d\"},\n"
+  "    {\"id\": 701, \"main\": \"Mist\", \"description\": \"mist\", \"icon\": \"50d\"}\n"
+  "  ],\n"
+  "  \"base\": \"stations\",\n"
+  "  \"main\": {\"temp\": 285.4, \"feels_like\": 284.87, \"temp_min\": 284.26, \"temp_max\": 286.48, \"pressure\": 1008, \"humidity\": 88},\n"
+  "  \"visibility\": 6000,\n"
+  "  \"wind\": {\"speed\": 4.12, \"deg\": 240, \"gust\": 8.75},\n"
+  "  \"rain\": {\"1h\": 1.46},\n"
+  "  \"clouds\": {\"all\": 100},\n"
+  "  \"dt\": 1633000400,\n"
+  "  \"sys\": {\"type\": 2, \"id\": 2008021, \"country\": \"DE\", \"sunrise\": 1632980120, \"sunset\": 1633022560},\n"
+  "  \"timezone\": 7200, \"id\": 2950159, \"name\": \"M\\u00fcnchen \\/ Schwabing\", \"cod\": 200\n"
+  "}\n";
+
+// frost, empty array, literals and an exponent
+const char OWM_FROST[] =
+  "{\"coord\":{\"lon\":-0.1257,\"lat\":51.5085},"
+  "\"weather\":[{\"id\":800,\"main\":\"Clear\",\"description\":\"clear sky\",\"icon\":\"01n\"}],"
+  "\"alerts\":[],\"snow\":null,\"sunny\":false,\"valid\":true,"
+  "\"main\":{\"temp\":2.6815e2,\"feels_like\":264.9,\"temp_min\":267.04,\"temp_max\":269.26,\"pressure\":1031,\"humidity\":93,\"sea_level\":1031,\"grnd_level\":1027},"
+  "\"visibility\":10000,"
+  "\"wind\":{\"speed\":2.06,\"deg\":0},"
+  "\"clouds\":{\"all\":0},"
+  "\"dt\":1612137600,"
+  "\"sys\":{\"type\":1,\"id\":1414,\"country\":\"GB\",\"sunrise\":1612165262,\"sunset\":1612198512},"
+  "\"timezone\":0,\"id\":2643743,\"name\":\"London\",\"cod\":200}";
+
+#endif
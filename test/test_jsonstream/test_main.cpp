@@ -0,0 +1,240 @@
+#include <unity.h>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ezTime.h>
+
+#include <string>
+#include <vector>
+
+#include "jsonstream.h"
+#include "weather.h"
+#include "owm_responses.h"
+
+// every value seen, as "path=value"
+struct Recorder {
+  std::vector<std::string> values;
+};
+
+void record(void *context, const char *path, const char *value) {
+  ((Recorder *) context)->values.push_back(std::string(path) + "=" + value);
+}
+
+// all values of a document fed at once
+std::vector<std::string> parseWhole(const char *json) {
+  Recorder r;
+  JsonStreamParser parser(record, &r);
+  parser.feed(json, strlen(json));
+  TEST_ASSERT_TRUE(parser.isDone());
+  return r.values;
+}
+
+bool contains(const std::vector<std::string> &values, const char *entry) {
+  for (const std::string &v : values) {
+    if (v == entry) return true;
+  }
+  return false;
+}
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+}
+
+void tearDown() {
+  fake::onConnect = nullptr;
+}
+
+void test_values_and_paths() {
+  std::vector<std::string> values = parseWhole(OWM_CLOUDS);
+  TEST_ASSERT_TRUE(contains(values, "coord.lon=9.18"));
+  TEST_ASSERT_TRUE(contains(values, "weather[0].icon=04n"));
+  TEST_ASSERT_TRUE(contains(values, "main.temp=280.69"));
+  TEST_ASSERT_TRUE(contains(values, "sys.sunset=1602952394"));
+  TEST_ASSERT_TRUE(contains(values, "cod=200"));
+
+  values = parseWhole(OWM_RAIN);
+  TEST_ASSERT_TRUE(contains(values, "weather[0].description=moderate \"rain\""));
+  TEST_ASSERT_TRUE(contains(values, "weather[1].icon=50d"));
+  TEST_ASSERT_TRUE(contains(values, "rain.1h=1.46"));
+  TEST_ASSERT_TRUE(contains(values, "wind.gust=8.75"));
+
+  values = parseWhole(OWM_FROST);
+  TEST_ASSERT_TRUE(contains(values, "main.temp=2.6815e2"));
+  TEST_ASSERT_TRUE(contains(values, "snow=null"));
+  TEST_ASSERT_TRUE(contains(values, "sunny=false"));
+  TEST_ASSERT_TRUE(contains(values, "main.grnd_level=1027"));
+}
+
+// the values don't depend on where the socket splits the response
+void replayInChunks(const char *json) {
+  std::vector<std::string> expected = parseWhole(json);
+  size_t len = strlen(json);
+  for (size_t chunk = 1; chunk <= len; ++chunk) {
+    Recorder r;
+    JsonStreamParser parser(record, &r);
+    for (size_t pos = 0; pos < len; pos += chunk) {
+      parser.feed(json + pos, min(chunk, len - pos));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(parser.isDone() && !parser.hasError(), "not done");
+    TEST_ASSERT_TRUE_MESSAGE(r.values == expected, "values differ");
+  }
+}
+
+void test_fixed_chunk_sizes() {
+  replayInChunks(OWM_CLOUDS);
+  replayInChunks(OWM_RAIN);
+  replayInChunks(OWM_FROST);
+}
+
+void test_random_chunk_boundaries() {
+  const char *responses[] = { OWM_CLOUDS, OWM_RAIN, OWM_FROST };
+  randomSeed(42);
+  for (const char *json : responses) {
+    std::vector<std::string> expected = parseWhole(json);
+    size_t len = strlen(json);
+    for (uint16_t run = 0; run < 200; ++run) {
+      Recorder r;
+      JsonStreamParser parser(record, &r);
+      size_t pos = 0;
+      while (pos < len) {
+        size_t chunk = min((size_t) random(1, 64), len - pos);
+        parser.feed(json + pos, chunk);
+        pos += chunk;
+      }
+      TEST_ASSERT_TRUE(parser.isDone());
+      TEST_ASSERT_TRUE_MESSAGE(r.values == expected, "values differ");
+    }
+  }
+}
+
+void test_reset_between_documents() {
+  Recorder r;
+  JsonStreamParser parser(record, &r);
+  // an aborted response
+  parser.feed(OWM_RAIN, 120);
+  parser.reset();
+  parser.feed(OWM_CLOUDS, strlen(OWM_CLOUDS));
+  TEST_ASSERT_TRUE(parser.isDone());
+  TEST_ASSERT_TRUE(r.values.size() > 0);
+  std::vector<std::string> expected = parseWhole(OWM_CLOUDS);
+  std::vector<std::string> tail(r.values.end() - expected.size(), r.values.end());
+  TEST_ASSERT_TRUE(tail == expected);
+}
+
+void test_truncated_and_broken_documents() {
+  Recorder r;
+  JsonStreamParser parser(record, &r);
+  parser.feed(OWM_CLOUDS, strlen(OWM_CLOUDS) - 1);
+  TEST_ASSERT_FALSE(parser.isDone());
+  TEST_ASSERT_FALSE(parser.hasError());
+
+  parser.reset();
+  parser.feed("{\"main\":{\"temp\" 280}}", 21);
+  TEST_ASSERT_TRUE(parser.hasError());
+}
+
+// the weather client on a socket that delivers the response in pieces
+WiFiClient *server = nullptr;
+
+void test_weather_client_with_chunked_response() {
+  fake::onConnect = [](WiFiClient &client, const char *host, uint16_t port) {
+    server = &client;
+    // the fake resolves every name to 192.0.2.1
+    return strcmp(host, "192.0.2.1") == 0 && port == 80;
+  };
+  std::string response = std::string("HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\n"
+    "Connection: close\r\n\r\n") + OWM_RAIN;
+
+  for (size_t chunk = 1; chunk < 40; ++chunk) {
+    WeatherClient wc;
+    wc.requestWeatherData();
+    TEST_ASSERT_TRUE(wc.isBusy());
+    TEST_ASSERT_TRUE(server->sent().find("GET /data/2.5/weather?id=") == 0);
+
+    bool updated = false;
+    for (size_t pos = 0; pos < response.size(); pos += chunk) {
+      server->respond(response.substr(pos, chunk), pos + chunk >= response.size());
+      updated = wc.loop() || updated;
+    }
+    TEST_ASSERT_TRUE(updated);
+    TEST_ASSERT_FALSE(wc.isBusy());
+    const WeatherData &d = wc.getWeatherData();
+    TEST_ASSERT_EQUAL_STRING("10d.bmp", d.icon);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 12.25, d.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1008, d.pressure);
+    TEST_ASSERT_EQUAL(88, d.humidity);
+    TEST_ASSERT_EQUAL(240, d.windDeg);
+    TEST_ASSERT_EQUAL(1633022560, d.sunset);
+    TEST_ASSERT_EQUAL(1633000400, d.dt);
+  }
+}
+
+void test_weather_server_is_resolved_once() {
+  bool up = true;
+  fake::onConnect = [&up](WiFiClient &client, const char *host, uint16_t port) {
+    (void) client;
+    (void) host;
+    return up && port == 80;
+  };
+  WiFi.connectedStatus = WL_CONNECTED;
+  WiFi.lookups = 0;
+  WeatherClient wc;
+  for (int i = 0; i < 3; ++i) {
+    wc.requestWeatherData();
+    TEST_ASSERT_TRUE(wc.isBusy());
+    fake::advance(11000); // past the response timeout
+    wc.loop();
+    TEST_ASSERT_FALSE(wc.isBusy());
+  }
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+
+  // again after a failed connect
+  up = false;
+  wc.requestWeatherData();
+  TEST_ASSERT_FALSE(wc.isBusy());
+  up = true;
+  wc.requestWeatherData();
+  TEST_ASSERT_TRUE(wc.isBusy());
+  TEST_ASSERT_EQUAL(2, WiFi.lookups);
+}
+
+void test_weather_age_from_fetch_time() {
+  fake::clearTime();
+  WeatherClient wc;
+  wc.setTtl(600);
+  WeatherData data = {};
+  strcpy(data.icon, "10d.bmp");
+  data.fetched = 1760875200;
+
+  // the time is not known yet: counted from when the data arrived
+  fake::advance(30000);
+  wc.setWeatherData(data);
+  fake::advance(5000);
+  TEST_ASSERT_EQUAL(5, wc.getAge());
+
+  // shared by the leader 500s after it was fetched
+  fake::setUtc(1760875700);
+  TEST_ASSERT_EQUAL(500, wc.getAge());
+  TEST_ASSERT_FALSE(wc.isExpired());
+  fake::advance(100000);
+  TEST_ASSERT_EQUAL(600, wc.getAge());
+  TEST_ASSERT_TRUE(wc.isExpired());
+
+  // the clock of the leader was ahead
+  fake::setUtc(1760875100);
+  TEST_ASSERT_EQUAL(0, wc.getAge());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_values_and_paths);
+  RUN_TEST(test_fixed_chunk_sizes);
+  RUN_TEST(test_random_chunk_boundaries);
+  RUN_TEST(test_reset_between_documents);
+  RUN_TEST(test_truncated_and_broken_documents);
+  RUN_TEST(test_weather_client_with_chunked_response);
+  RUN_TEST(test_weather_server_is_resolved_once);
+  RUN_TEST(test_weather_age_from_fetch_time);
+  return UNITY_END();
+}
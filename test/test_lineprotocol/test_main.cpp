@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <string.h>
+
+#include "lineprotocol.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_format_sensor_line() {
+  char buf[144];
+  size_t len = formatSensorLine(buf, sizeof(buf), "temperature", "living", "node-1", "DS18B20", "21.50");
+  TEST_ASSERT_EQUAL_STRING("temperature,location=living,node=node-1,sensor=DS18B20 value=21.50", buf);
+  TEST_ASSERT_EQUAL(strlen(buf), len);
+}
+
+void test_format_sensor_line_truncated() {
+  char buf[16];
+  size_t len = formatSensorLine(buf, sizeof(buf), "temperature", "living", "node-1", "DS18B20", "21.50");
+  // the full length is returned, as snprintf does
+  TEST_ASSERT_EQUAL(strlen("temperature,location=living,node=node-1,sensor=DS18B20 value=21.50"), len);
+  TEST_ASSERT_EQUAL_STRING("temperature,loc", buf);
+}
+
+void test_find_field() {
+  const char *line = "temperature,location=garden,node=n1,sensor=BME280 value=12.25,raw=12.0";
+  TEST_ASSERT_EQUAL_STRING("12.25,raw=12.0", findField(line, "value"));
+  TEST_ASSERT_EQUAL_STRING("12.0", findField(line, "raw"));
+  // tags are not fields
+  TEST_ASSERT_NULL(findField(line, "node"));
+  TEST_ASSERT_NULL(findField(line, "val"));
+  TEST_ASSERT_NULL(findField("temperature", "value"));
+}
+
+void test_copy_token() {
+  char buf[12];
+  TEST_ASSERT_EQUAL(11, copyToken(buf, sizeof(buf), "temperature,location=x"));
+  TEST_ASSERT_EQUAL_STRING("temperature", buf);
+  char small[8];
+  TEST_ASSERT_EQUAL(7, copyToken(small, sizeof(small), "temperature,location=x"));
+  TEST_ASSERT_EQUAL_STRING("tempera", small);
+  TEST_ASSERT_EQUAL(5, copyToken(small, sizeof(small), "12.25 rest"));
+  TEST_ASSERT_EQUAL_STRING("12.25", small);
+  TEST_ASSERT_EQUAL(0, copyToken(small, 0, "x"));
+}
+
+void test_form_value_decoded() {
+  char value[32];
+  TEST_ASSERT_TRUE(findFormValue("node=a+b&topic=home%2Fgarden%3a", "topic", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("home/garden:", value);
+  TEST_ASSERT_TRUE(findFormValue("node=a+b&topic=x", "node", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("a b", value);
+  // an invalid escape is kept
+  TEST_ASSERT_TRUE(findFormValue("tz=%zz1", "tz", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("%zz1", value);
+  TEST_ASSERT_TRUE(findFormValue("node=&x=1", "node", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("", value);
+}
+
+void test_form_value_missing() {
+  char value[8] = "old";
+  TEST_ASSERT_FALSE(findFormValue("node=a&topic=b", "altitude", value, sizeof(value)));
+  TEST_ASSERT_FALSE(findFormValue("", "node", value, sizeof(value)));
+  // a key without '=' is no field
+  TEST_ASSERT_FALSE(findFormValue("node&x=1", "node", value, sizeof(value)));
+}
+
+// The key has to start a field. The former String based lookup matched
+// anywhere, so "show" found the value of "remote-show" when it came first.
+void test_form_value_key_at_field_start() {
+  char value[16];
+  TEST_ASSERT_TRUE(findFormValue("remote-show=r&show=s", "show", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("s", value);
+  TEST_ASSERT_FALSE(findFormValue("remote-show=r", "show", value, sizeof(value)));
+  TEST_ASSERT_FALSE(findFormValue("xnode=1", "node", value, sizeof(value)));
+  // a value containing the key doesn't match either
+  TEST_ASSERT_TRUE(findFormValue("topic=node%3D1&node=n", "node", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("n", value);
+}
+
+void test_form_value_truncated() {
+  char value[4];
+  TEST_ASSERT_TRUE(findFormValue("node=abcdef", "node", value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("abc", value);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_format_sensor_line);
+  RUN_TEST(test_format_sensor_line_truncated);
+  RUN_TEST(test_find_field);
+  RUN_TEST(test_copy_token);
+  RUN_TEST(test_form_value_decoded);
+  RUN_TEST(test_form_value_missing);
+  RUN_TEST(test_form_value_key_at_field_start);
+  RUN_TEST(test_form_value_truncated);
+  return UNITY_END();
+}
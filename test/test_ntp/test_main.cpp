@@ -0,0 +1,127 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+// The NTP server stand-in in the WiFiUDP fake answers with fake::ntpReply.
+#define NTP_TIME 1700000000
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::clearTime();
+  fake::ntpReply = NTP_TIME;
+  fake::ntpQueries = 0;
+  WiFi.connectedStatus = WL_CONNECTED;
+  WiFi.lookups = 0;
+  timeSynced = false;
+  setInterval(0);
+}
+
+void tearDown() {}
+
+// calls loop() for ms of virtual time, one pass every 50 ms
+void run(NtpClient &client, uint32_t ms) {
+  uint32_t end = millis() + ms;
+  while ((int32_t) (millis() - end) < 0) {
+    client.loop();
+    fake::advance(50);
+  }
+}
+
+void test_sync_does_not_block() {
+  fake::advance(1234);
+  ntp.setServer("ntp.example.org");
+  ntp.update();
+
+  uint32_t start = millis();
+  clockTask();
+  TEST_ASSERT_EQUAL(start, millis());
+  TEST_ASSERT_EQUAL(1, fake::ntpQueries);
+  TEST_ASSERT_FALSE(timeSynced);
+
+  fake::advance(20);
+  clockTask();
+  TEST_ASSERT_TRUE(timeSynced);
+  TEST_ASSERT_EQUAL(timeSet, timeStatus());
+  // the time of the answer plus half of the round trip
+  TEST_ASSERT_EQUAL(NTP_TIME + 1, UTC.now());
+  TEST_ASSERT_EQUAL(20, ntp.getRoundTripMs());
+}
+
+void test_server_is_resolved_once() {
+  NtpClient client;
+  client.setServer("ntp.example.org");
+  client.setInterval(60);
+  run(client, 10 * 60000);
+  // the interval counts from the answer
+  TEST_ASSERT_EQUAL(10, client.getRequests());
+  TEST_ASSERT_EQUAL(0, client.getFailures());
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+}
+
+void test_network_down_backs_off() {
+  NtpClient client;
+  client.setServer("ntp.example.org");
+  WiFi.connectedStatus = WL_DISCONNECTED;
+  run(client, 10 * 60000);
+  // at 0, 16, 48, 112, 240 and 496 s
+  TEST_ASSERT_EQUAL(6, client.getFailures());
+  TEST_ASSERT_EQUAL(0, fake::ntpQueries);
+  TEST_ASSERT_EQUAL(0, WiFi.lookups);
+
+  WiFi.connectedStatus = WL_CONNECTED;
+  run(client, 17 * 60000);
+  TEST_ASSERT_EQUAL(1, fake::ntpQueries);
+  TEST_ASSERT_EQUAL(timeSet, timeStatus());
+}
+
+void test_unanswered_requests_back_off() {
+  NtpClient client;
+  client.setServer("ntp.example.org");
+  fake::ntpReply = 0;
+  run(client, 10 * 60000);
+  TEST_ASSERT_EQUAL(6, fake::ntpQueries);
+  TEST_ASSERT_EQUAL(6, client.getFailures());
+  // resolved again only after 4 timeouts in a row
+  TEST_ASSERT_EQUAL(2, WiFi.lookups);
+  TEST_ASSERT_EQUAL(timeNotSet, timeStatus());
+
+  // the next answer resets the backoff
+  fake::ntpReply = NTP_TIME;
+  run(client, 17 * 60000);
+  TEST_ASSERT_EQUAL(timeSet, timeStatus());
+  uint32_t failures = client.getFailures();
+  fake::ntpReply = 0;
+  fake::ntpQueries = 0;
+  client.update();
+  run(client, 60000);
+  TEST_ASSERT_EQUAL(failures + 3, client.getFailures());
+}
+
+void test_timeouts_alone_do_not_resolve_again() {
+  NtpClient client;
+  client.setServer("ntp.example.org");
+  fake::ntpReply = 0;
+  run(client, 60000); // at 0, 17 and 50 s
+  TEST_ASSERT_EQUAL(3, client.getFailures());
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+
+  // an answer starts the count again
+  fake::ntpReply = NTP_TIME;
+  run(client, 60000);
+  TEST_ASSERT_EQUAL(timeSet, timeStatus());
+  fake::ntpReply = 0;
+  client.update();
+  run(client, 60000);
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sync_does_not_block);
+  RUN_TEST(test_server_is_resolved_once);
+  RUN_TEST(test_network_down_backs_off);
+  RUN_TEST(test_unanswered_requests_back_off);
+  RUN_TEST(test_timeouts_alone_do_not_resolve_again);
+  return UNITY_END();
+}
@@ -0,0 +1,200 @@
+#include <unity.h>
+
+// the firmware is built into the test, so its globals and helpers are visible
+#include "../../src/main.cpp"
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::clearSensors();
+  fake::broker->reset();
+  memset(sensors, 0, sizeof(sensors));
+  oneWireDeviceCount = 0;
+  bmeAddr = "";
+  si70xxAddr = "";
+  htu21Addr = "";
+  rootTopic = DEFAULT_ROOT_TOPIC;
+  nodeName = DEFAULT_NODE_NAME;
+  nodeAltitude = 282.0f;
+  captureEnabled = false;
+  mqttMissedValues = 0;
+}
+
+void tearDown() {
+  mqttClient.disconnect();
+}
+
+void setupSensors() {
+  setupOneWireSensors();
+  setupI2CSensors();
+  setupAnalogSensor();
+}
+
+void test_onewire_sensors_are_added_by_address() {
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 4.25f);
+  setupSensors();
+
+  TEST_ASSERT_EQUAL(3, numberOfSensors());
+  TEST_ASSERT_EQUAL_STRING("28014C07D6013C81", sensors[0].id);
+  TEST_ASSERT_EQUAL_STRING("DS18B20", sensors[0].type);
+  TEST_ASSERT_EQUAL_STRING("temperature", sensors[0].measurand);
+  TEST_ASSERT_EQUAL_MEMORY(fake::oneWireDevices[1].addr, sensors[1].addr, 8);
+  // the location defaults to the id, the sensor is disabled until configured
+  TEST_ASSERT_EQUAL_STRING(sensors[1].id, sensors[1].location);
+  TEST_ASSERT_FALSE(sensors[1].enabled);
+  TEST_ASSERT_EQUAL_STRING("?", sensors[1].value);
+  TEST_ASSERT_EQUAL_STRING("a", sensors[2].id);
+  TEST_ASSERT_EQUAL_STRING("LDR", sensors[2].type);
+}
+
+void test_i2c_sensor_ids() {
+  fake::bme280.present = true;
+  fake::bme280.address = 0x77;
+  fake::si70xx.present = true;
+  fake::si70xx.model = SI_7013;
+  setupSensors();
+
+  TEST_ASSERT_EQUAL_STRING("77", bmeAddr.c_str());
+  TEST_ASSERT_EQUAL(6, numberOfSensors());
+  TEST_ASSERT_EQUAL_STRING("77h", sensors[0].id);
+  TEST_ASSERT_EQUAL_STRING("77p", sensors[1].id);
+  TEST_ASSERT_EQUAL_STRING("77t", sensors[2].id);
+  TEST_ASSERT_EQUAL_STRING("BME280", sensors[2].type);
+  TEST_ASSERT_EQUAL_STRING("40h", sensors[3].id);
+  TEST_ASSERT_EQUAL_STRING("Si7013", sensors[3].type);
+  TEST_ASSERT_EQUAL_STRING("40t", sensors[4].id);
+}
+
+void test_htu21_only_without_si70xx() {
+  // both answer on 0x40, the Si70xx wins
+  fake::si70xx.present = true;
+  fake::htu21.present = true;
+  setupSensors();
+  TEST_ASSERT_EQUAL(0, htu21Addr.length());
+
+  setUp();
+  fake::htu21.present = true;
+  setupSensors();
+  TEST_ASSERT_EQUAL_STRING("40", htu21Addr.c_str());
+  TEST_ASSERT_EQUAL_STRING("HTU21", getSensorData("40t").type);
+}
+
+void test_sensor_table_is_limited() {
+  for (uint8_t i = 0; i < MAX_SENSORS + 2; ++i) {
+    fake::addOneWireDevice(i, 20.0f);
+  }
+  setupSensors();
+  TEST_ASSERT_EQUAL(MAX_SENSORS, numberOfSensors());
+  // unknown ids get the scratch entry
+  TEST_ASSERT_TRUE(&getSensorData("a") == &tmpSensor);
+  TEST_ASSERT_TRUE(&getSensorData("nope") == &tmpSensor);
+}
+
+void test_values_are_read_and_corrected() {
+  fake::addOneWireDevice(1, 21.5f);
+  fake::bme280.present = true;
+  fake::bme280.pressure = 95000.0f;
+  fake::analogValue = 300;
+  setupSensors();
+  getSensorData("28014C07D6013C81").correction = -0.5f;
+
+  fetchSensorValues();
+  TEST_ASSERT_EQUAL_STRING("21.00", sensors[0].value);
+  TEST_ASSERT_EQUAL_STRING("45.00", getSensorData("76h").value);
+  TEST_ASSERT_EQUAL_STRING("21.50", getSensorData("76t").value);
+  // the pressure is reduced to sea level with the node altitude
+  char expected[SENSOR_VALUE_LENGTH];
+  snprintf(expected, sizeof(expected), "%.2f", 95000.0f / pow(1.0 - 282.0 / 44330.0, 5.255));
+  TEST_ASSERT_EQUAL_STRING(expected, getSensorData("76p").value);
+  TEST_ASSERT_EQUAL_STRING("300.00", getSensorData("a").value);
+}
+
+void test_version_changes_with_the_value_only() {
+  fake::addOneWireDevice(1, 21.5f);
+  setupSensors();
+  fetchSensorValues();
+  uint32_t version = sensors[0].version;
+
+  fetchSensorValues();
+  TEST_ASSERT_EQUAL(version, sensors[0].version);
+  fake::oneWireDevices[0].tempC = 21.504f; // rounds to the same value
+  fetchSensorValues();
+  TEST_ASSERT_EQUAL(version, sensors[0].version);
+  fake::oneWireDevices[0].tempC = 22.0f;
+  fetchSensorValues();
+  TEST_ASSERT_GREATER_THAN(version, sensors[0].version);
+}
+
+void test_topic_from_root_topic_and_location() {
+  setupSensors();
+  rootTopic = "home.ground";
+  strlcpy(sensors[0].location, "kitchen.window", SENSOR_LOCATION_LENGTH);
+  updateSensorTopics();
+  TEST_ASSERT_EQUAL_STRING("home/ground/kitchen/window", sensors[0].topic);
+}
+
+void test_payload_of_enabled_sensors() {
+  fake::addOneWireDevice(1, 21.5f);
+  setupSensors();
+  nodeName = "node-7";
+  strlcpy(sensors[0].location, "living", SENSOR_LOCATION_LENGTH);
+  updateSensorTopics();
+  sensors[0].enabled = true;
+  TEST_ASSERT_TRUE(mqttClient.connect("test"));
+  fetchSensorValues();
+
+  sendMQTTData();
+  TEST_ASSERT_EQUAL(1, fake::broker->publishes);
+  const fake::MqttMessage *m = fake::broker->last();
+  TEST_ASSERT_EQUAL_STRING("tmp/living", m->topic);
+  TEST_ASSERT_EQUAL_STRING("temperature,location=living,node=node-7,sensor=DS18B20 value=21.50", m->payload);
+  TEST_ASSERT_FALSE(m->retained);
+}
+
+void test_values_are_counted_as_missed_while_disconnected() {
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 21.5f);
+  setupSensors();
+  sensors[0].enabled = true;
+  sensors[1].enabled = true;
+
+  sendMQTTData();
+  TEST_ASSERT_EQUAL(0, fake::broker->publishes);
+  TEST_ASSERT_EQUAL(2, mqttMissedValues);
+}
+
+void test_long_stats_lines_are_not_cut() {
+  LatencyHistogram latency;
+  latency.record(4000000000UL);
+  latency.record(4100000000UL);
+  TEST_ASSERT_TRUE(mqttClient.connect("test"));
+
+  nodeName = "a-node-name-of-thirty-letters";
+  publishLatency("stats", latency, "fetchSensorValues");
+  TEST_ASSERT_EQUAL(1, fake::broker->publishes);
+  const fake::MqttMessage *m = fake::broker->last();
+  TEST_ASSERT_EQUAL(strlen(m->payload), m->length);
+  TEST_ASSERT_EQUAL('i', m->payload[m->length - 1]);
+  TEST_ASSERT_TRUE(strstr(m->payload, ",max=4100000000i,") != nullptr);
+
+  // longer than the line is sized for: skipped rather than cut
+  nodeName = "a-node-name-that-is-much-longer-than-thirty-letters";
+  publishLatency("stats", latency, "fetchSensorValues");
+  TEST_ASSERT_EQUAL(1, fake::broker->publishes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_onewire_sensors_are_added_by_address);
+  RUN_TEST(test_i2c_sensor_ids);
+  RUN_TEST(test_htu21_only_without_si70xx);
+  RUN_TEST(test_sensor_table_is_limited);
+  RUN_TEST(test_values_are_read_and_corrected);
+  RUN_TEST(test_version_changes_with_the_value_only);
+  RUN_TEST(test_topic_from_root_topic_and_location);
+  RUN_TEST(test_payload_of_enabled_sensors);
+  RUN_TEST(test_values_are_counted_as_missed_while_disconnected);
+  RUN_TEST(test_long_stats_lines_are_not_cut);
+  return UNITY_END();
+}
@@ -0,0 +1,182 @@
+#include <unity.h>
+
+#include "../../src/main.cpp"
+
+#include <string>
+#include <vector>
+
+// syslogTask() sends to a socket on the loopback, the tests read the datagrams back
+#define COLLECTOR_PORT 45514
+
+WiFiUDP collector;
+
+void setUp() {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::clearTime();
+  timeSynced = false;
+  WiFi.connectedStatus = WL_CONNECTED;
+  WiFi.lookups = 0;
+  nodeName = "cellar";
+  syslogPlain = false;
+  syslogSent = 0;
+  syslogDropped = 0;
+  setSyslogServer("127.0.0.1:45514");
+  TEST_ASSERT_TRUE(collector.begin(COLLECTOR_PORT));
+  while (collector.parsePacket() > 0) {}
+  syslogSentId = logRing.getNextId();
+}
+
+void tearDown() {
+  collector.stop();
+}
+
+std::vector<std::string> receive() {
+  std::vector<std::string> datagrams;
+  int len;
+  while ((len = collector.parsePacket()) > 0) {
+    std::string d(len, '\0');
+    collector.read((uint8_t *) &d[0], len);
+    datagrams.push_back(d);
+  }
+  return datagrams;
+}
+
+void test_rfc5424_one_record_per_datagram() {
+  logp(LOGLEVEL_INFO, PSTR("reading %d"), 7);
+  logp(LOGLEVEL_ERROR, PSTR("sensor %s lost"), "28014C07D6013C81");
+  syslogTask();
+
+  std::vector<std::string> d = receive();
+  TEST_ASSERT_EQUAL(2, d.size());
+  // local0.info, no timestamp before NTP is synced
+  TEST_ASSERT_EQUAL_STRING_LEN("<134>1 - cellar sensornode - - - ", d[0].c_str(), 33);
+  TEST_ASSERT_TRUE(d[0].find("reading 7") != std::string::npos);
+  TEST_ASSERT_EQUAL_STRING_LEN("<131>1 - cellar", d[1].c_str(), 15);
+  TEST_ASSERT_TRUE(d[1].find("sensor 28014C07D6013C81 lost") != std::string::npos);
+  TEST_ASSERT_EQUAL(2, syslogSent);
+
+  // nothing new, nothing sent
+  syslogTask();
+  TEST_ASSERT_EQUAL(0, receive().size());
+}
+
+void test_rfc5424_timestamp_when_synced() {
+  fake::setUtc(1760875200); // 2025-10-19 12:00:00 UTC
+  timeSynced = true;
+  logp(LOGLEVEL_WARN, PSTR("late"));
+  syslogTask();
+
+  std::vector<std::string> d = receive();
+  TEST_ASSERT_EQUAL(1, d.size());
+  TEST_ASSERT_EQUAL_STRING_LEN("<132>1 2025-10-19T12:00:00Z cellar sensornode - - - ", d[0].c_str(), 52);
+}
+
+void test_plain_lines_are_packed_into_datagrams() {
+  syslogPlain = true;
+  for (int i = 0; i < 40; ++i) {
+    logp(LOGLEVEL_INFO, PSTR("a longer plain line to fill the datagrams, number %d"), i);
+  }
+  syslogTask();
+
+  std::vector<std::string> d = receive();
+  TEST_ASSERT_TRUE(d.size() > 1);
+  TEST_ASSERT_TRUE(d.size() < 40);
+  size_t lines = 0;
+  for (const std::string &datagram : d) {
+    TEST_ASSERT_TRUE(datagram.size() <= SYSLOG_DATAGRAM_SIZE);
+    TEST_ASSERT_EQUAL('\n', datagram.back());
+    TEST_ASSERT_EQUAL_STRING_LEN("cellar INFO ", datagram.c_str(), 12);
+    for (char c : datagram) lines += c == '\n';
+  }
+  TEST_ASSERT_EQUAL(40, lines);
+  TEST_ASSERT_TRUE(d[0].find("number 0\n") != std::string::npos);
+  TEST_ASSERT_TRUE(d.back().find("number 39\n") != std::string::npos);
+}
+
+void test_oldest_records_are_dropped() {
+  syslogPlain = true;
+  for (int i = 0; i < SYSLOG_QUEUE_MAX + 10; ++i) {
+    logp(LOGLEVEL_INFO, PSTR("record %d"), i);
+  }
+  syslogTask();
+
+  TEST_ASSERT_EQUAL(10, syslogDropped);
+  TEST_ASSERT_EQUAL(SYSLOG_QUEUE_MAX, syslogSent);
+  std::vector<std::string> d = receive();
+  TEST_ASSERT_TRUE(d.size() > 0);
+  TEST_ASSERT_TRUE(d[0].find("record 10\n") != std::string::npos);
+  TEST_ASSERT_TRUE(d[0].find("record 9\n") == std::string::npos);
+}
+
+void test_server_is_resolved_once() {
+  logp(LOGLEVEL_INFO, PSTR("one"));
+  syslogTask();
+  logp(LOGLEVEL_INFO, PSTR("two"));
+  syslogTask();
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+  TEST_ASSERT_EQUAL(2, receive().size());
+
+  // again after a change of the configuration
+  LittleFS.clear();
+  LittleFS.setContent("/config.cfg", "node=cellar\r\nsyslog=127.0.0.1:45514\r\n");
+  TEST_ASSERT_TRUE(LittleFS.begin());
+  loadConfigFile();
+  LittleFS.end();
+  logp(LOGLEVEL_INFO, PSTR("three"));
+  syslogTask();
+  TEST_ASSERT_EQUAL(2, WiFi.lookups);
+  std::vector<std::string> d = receive();
+  TEST_ASSERT_TRUE(d.back().find("three") != std::string::npos);
+}
+
+void test_records_wait_for_the_network() {
+  WiFi.connectedStatus = WL_DISCONNECTED;
+  logp(LOGLEVEL_INFO, PSTR("offline"));
+  syslogTask();
+  TEST_ASSERT_EQUAL(0, receive().size());
+
+  WiFi.connectedStatus = WL_CONNECTED;
+  syslogTask();
+  TEST_ASSERT_EQUAL(1, WiFi.lookups);
+  TEST_ASSERT_EQUAL(1, receive().size());
+}
+
+void test_nothing_is_dropped_after_boot() {
+  // as setup() does after the log ids are restored
+  logRing = LogRing();
+  logRing.setFirstId(100000);
+  syslogSentId = logRing.getFirstId();
+  logp(LOGLEVEL_INFO, PSTR("booted"));
+  syslogTask();
+  TEST_ASSERT_EQUAL(0, syslogDropped);
+  TEST_ASSERT_EQUAL(1, receive().size());
+}
+
+void test_repeats_name_the_message() {
+  for (int i = 0; i < 4; ++i) {
+    log_printf(LOGMODULE_SYSTEM, LOGLEVEL_WARN, "Sensor %s lost", "28014C07D6013C81");
+  }
+  fake::advance(LOG_REPEAT_WINDOW_MS);
+  logRepeatedSites();
+
+  LogRecord rec;
+  char line[LOGLINE_LENGTH];
+  TEST_ASSERT_TRUE(logRing.readLast(rec));
+  LogRing::format(rec, line, sizeof(line));
+  TEST_ASSERT_TRUE(strstr(line, "'Sensor %s lost' repeated 3 times") != nullptr);
+  TEST_ASSERT_EQUAL(LOGLEVEL_WARN, rec.level);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rfc5424_one_record_per_datagram);
+  RUN_TEST(test_rfc5424_timestamp_when_synced);
+  RUN_TEST(test_plain_lines_are_packed_into_datagrams);
+  RUN_TEST(test_oldest_records_are_dropped);
+  RUN_TEST(test_server_is_resolved_once);
+  RUN_TEST(test_records_wait_for_the_network);
+  RUN_TEST(test_nothing_is_dropped_after_boot);
+  RUN_TEST(test_repeats_name_the_message);
+  return UNITY_END();
+}
@@ -0,0 +1,184 @@
+// Host benchmark of the hot paths: pio run -e bench -t exec [-a <iterations>]
+// One JSON line per benchmark on stdout:
+// {"bench":"<name>","iterations":N,"ns_per_op":..,"allocs_per_op":..,"alloc_bytes_per_op":..,"bytes_per_op":..}
+// ns_per_op is host time and only comparable between runs on the same machine,
+// allocations and bytes are exact.
+
+#include "../../src/main.cpp"
+
+#include <alloccount.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#define BENCH_ITERATIONS 2000
+
+uint32_t iterations = BENCH_ITERATIONS;
+
+// runs op, which returns the bytes it produced
+void bench(const char *name, std::function<size_t(uint32_t)> op) {
+  // warm up, first calls fill caches and reserve buffers
+  for (uint32_t i = 0; i < 10; ++i) op(i);
+
+  fake::AllocCounter allocs;
+  uint64_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    bytes += op(i);
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  uint64_t allocCount = allocs.allocs();
+  uint64_t allocBytes = allocs.bytes();
+
+  printf("{\"bench\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"alloc_bytes_per_op\":%.1f,\"bytes_per_op\":%.1f}\n",
+    name, (unsigned long) iterations, (double) ns / iterations, (double) allocCount / iterations,
+    (double) allocBytes / iterations, (double) bytes / iterations);
+  fflush(stdout);
+}
+
+// the form the config page posts, for the current config
+std::string configForm() {
+  std::string form = "node=" + std::string(nodeName.c_str()) + "&topic=" + rootTopic.c_str()
+    + "&altitude=" + String(nodeAltitude, 2).c_str() + "&sensorcycle=" + std::to_string(updateSensorsTimeout)
+    + "&forecastcycle=" + std::to_string(updateWeatherForecastTimeout) + "&hasDisplay=on"
+    + "&remote-0=home.garden.temperature&remote-1=&remote-2=&remote-3=&outdoor=owm"
+    + "&tz=CET-1CEST%2CM3.5.0%2CM10.5.0%2F3&heaplimit=4096";
+  for (uint8_t i = 0; i < LOGMODULE_COUNT; ++i) {
+    form += std::string("&log-") + logModuleNames[i] + "=" + std::to_string(logLevels[i]);
+  }
+  form += "&syslog=";
+  for (uint8_t i = 0; i < numberOfSensors(); ++i) {
+    form += std::string("&loc-") + sensors[i].id + "=" + sensors[i].location;
+    if (sensors[i].enabled) form += std::string("&en-") + sensors[i].id + "=on";
+    form += std::string("&cor-") + sensors[i].id + "=" + String(sensors[i].correction, 2).c_str();
+  }
+  form += std::string("&show=") + sensors[0].id;
+  return form;
+}
+
+void setupNode() {
+  fake::serialQuiet = true;
+  fake::ntpReply = 1700000000;
+  fake::addOneWireDevice(1, 21.5f);
+  fake::addOneWireDevice(2, 4.25f);
+  fake::addOneWireDevice(3, 18.0f);
+  fake::bme280.present = true;
+  fake::si70xx.present = true;
+  LittleFS.setContent("/config.html", "<html>config</html>");
+  LittleFS.setContent("/config.cfg",
+    "node=bench\r\n"
+    "topic=home.ground\r\n"
+    "altitude=282.00\r\n"
+    "sto=30\r\n"
+    "wfcto=300\r\n"
+    "tz=CET-1CEST,M3.5.0,M10.5.0/3\r\n"
+    "heaplimit=4096\r\n"
+    "loglevels=222222\r\n"
+    "hasDisplay\r\n"
+    "outdoor=owm\r\n"
+    "remote-0=home.garden.temperature\r\n"
+    "show=28014C07D6013C81\r\n"
+    "sensor-28014C07D6013C81=living.window\r\n"
+    "sensor.enabled-28014C07D6013C81=1\r\n"
+    "sensor.correction-28014C07D6013C81=-0.25\r\n"
+    "sensor-28024C07D6013C82=garden\r\n"
+    "sensor.enabled-28024C07D6013C82=1\r\n"
+    "sensor.correction-28024C07D6013C82=0.00\r\n"
+    "sensor-28034C07D6013C83=cellar\r\n"
+    "sensor.enabled-28034C07D6013C83=1\r\n"
+    "sensor.correction-28034C07D6013C83=0.50\r\n"
+    "sensor-76h=living.humidity\r\n"
+    "sensor.enabled-76h=1\r\n"
+    "sensor.correction-76h=0.00\r\n"
+    "sensor-76p=living.pressure\r\n"
+    "sensor.enabled-76p=1\r\n"
+    "sensor.correction-76p=0.00\r\n"
+    "sensor-76t=living.bme\r\n"
+    "sensor.enabled-76t=1\r\n"
+    "sensor.correction-76t=-1.20\r\n"
+    "sensor-40h=bath.humidity\r\n"
+    "sensor.enabled-40h=1\r\n"
+    "sensor.correction-40h=0.00\r\n"
+    "sensor-40t=bath\r\n"
+    "sensor.enabled-40t=1\r\n"
+    "sensor.correction-40t=0.00\r\n"
+    "sensor-a=living.light\r\n"
+    "sensor.enabled-a=1\r\n"
+    "sensor.correction-a=0.00\r\n");
+  setup();
+  mqttReconnect();
+
+  // a full log
+  for (uint16_t i = 0; i < 200; ++i) {
+    log_printf(LOGMODULE_SENSOR, LOGLEVEL_INFO, "Sensor %u read %d.%02d in %lu ms", i % 9, 20 + i % 5, i % 100, 12UL + i % 7);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) iterations = max(1L, atol(argv[1]));
+  setupNode();
+
+  bench("fetchSensorValues", [](uint32_t i) {
+    // values change every cycle, as in reality
+    for (uint8_t d = 0; d < fake::oneWireDeviceCount; ++d) {
+      fake::oneWireDevices[d].tempC = 18.0f + d + (i % 50) * 0.0625f;
+    }
+    fake::bme280.temperature = 21.0f + (i % 10) * 0.01f;
+    fetchSensorValues();
+    size_t bytes = 0;
+    for (uint8_t s = 0; s < numberOfSensors(); ++s) bytes += strlen(sensors[s].value);
+    return bytes;
+  });
+
+  bench("sendMQTTData", [](uint32_t i) {
+    (void) i;
+    uint64_t before = fake::broker->payloadBytes;
+    sendMQTTData();
+    return (size_t) (fake::broker->payloadBytes - before);
+  });
+
+  bench("handleGetSensors", [](uint32_t i) {
+    (void) i;
+    espServer.request(HTTP_GET, "/sensors");
+    return espServer.body.size();
+  });
+
+  bench("handleGetLogs", [](uint32_t i) {
+    (void) i;
+    espServer.request(HTTP_GET, "/logs", "id=0");
+    return espServer.body.size();
+  });
+
+  // bytes are the SPI bytes sent to the panel
+  bench("display value", [](uint32_t i) {
+    uint64_t before = tft.spiStats().bytes;
+    display(tft, i % 2 ? "21.5°C" : "21.6°C", "4.3°C", "04d.bmp", "12:34", "19.10.");
+    return (size_t) (tft.spiStats().bytes - before);
+  });
+
+  bench("display full", [](uint32_t i) {
+    (void) i;
+    uint64_t before = tft.spiStats().bytes;
+    shown.valid = false;
+    display(tft, "21.5°C", "4.3°C", "04d.bmp", "12:34", "19.10.");
+    return (size_t) (tft.spiStats().bytes - before);
+  });
+
+  std::string form = configForm();
+  bench("handlePostRoot", [&form](uint32_t i) {
+    (void) i;
+    espServer.request(HTTP_POST, "/", nullptr, form.c_str());
+    return (size_t) LittleFS.data("/config.cfg")->size();
+  });
+
+  bench("loadConfigFile", [](uint32_t i) {
+    (void) i;
+    LittleFS.begin();
+    loadConfigFile();
+    LittleFS.end();
+    return (size_t) LittleFS.data("/config.cfg")->size();
+  });
+
+  return 0;
+}
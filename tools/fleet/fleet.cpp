@@ -0,0 +1,259 @@
+// Fleet simulator: many nodes running the firmware against one broker stand-in.
+//   pio run -e fleet, then .pio/build/fleet/program [options]
+//   --nodes=50 --duration=600 --cycle=30 --boot-spread=20
+//   --outage-at=120 --outage=60 --connect-delay=2000 --tick=250 --series
+// Each node is a forked process with the real setup()/loop() on its own
+// virtual clock and random seed. The broker lives in shared memory and the
+// nodes run one after the other for each tick, so there are no races and a
+// run is reproducible. Output is JSON lines: with --series one line per
+// second (broker side), then a summary with the publish rate, the reconnect
+// convergence after the outage and the per-node backlog (values missed while
+// disconnected).
+
+#include "../../src/main.cpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FLEET_MAX_NODES FAKE_MQTT_SESSIONS
+
+struct FleetOptions {
+  uint16_t nodes = 50;
+  uint32_t durationSec = 600;
+  uint16_t cycleSec = 30;
+  uint32_t bootSpreadSec = 20;
+  uint32_t outageAtSec = 120;
+  uint32_t outageSec = 60;
+  uint32_t connectDelayMs = MQTT_CONNECT_TIMEOUT_MS;
+  uint32_t tickMs = 250;
+  bool series = false;
+};
+
+// written by a node after each tick, read by the parent
+struct NodeSlot {
+  bool booted;
+  bool connected;
+  uint32_t missed;    // values not published while disconnected, reset on reconnect
+  uint32_t maxMissed; // the largest backlog seen
+  uint32_t loops;
+};
+
+struct Shared {
+  fake::MqttBroker broker;
+  NodeSlot nodes[FLEET_MAX_NODES];
+};
+
+Shared *shared;
+FleetOptions options;
+
+void parseOptions(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *eq = strchr(arg, '=');
+    uint32_t value = eq != nullptr ? strtoul(eq + 1, nullptr, 10) : 0;
+    if (strncmp(arg, "--nodes=", 8) == 0) options.nodes = constrain(value, 1U, (uint32_t) FLEET_MAX_NODES);
+    else if (strncmp(arg, "--duration=", 11) == 0) options.durationSec = value;
+    else if (strncmp(arg, "--cycle=", 8) == 0) options.cycleSec = max(value, 1U);
+    else if (strncmp(arg, "--boot-spread=", 14) == 0) options.bootSpreadSec = value;
+    else if (strncmp(arg, "--outage-at=", 12) == 0) options.outageAtSec = value;
+    else if (strncmp(arg, "--outage=", 9) == 0) options.outageSec = value;
+    else if (strncmp(arg, "--connect-delay=", 16) == 0) options.connectDelayMs = value;
+    else if (strncmp(arg, "--tick=", 7) == 0) options.tickMs = max(value, 10U);
+    else if (strcmp(arg, "--series") == 0) options.series = true;
+    else {
+      fprintf(stderr, "unknown option %s\n", arg);
+      exit(2);
+    }
+  }
+}
+
+// --- node process ---
+
+void bootNode(uint16_t id) {
+  fake::powerOn();
+  fake::serialQuiet = true;
+  fake::ntpReply = 1700000000;
+  randomSeed(0x5eed0000 + id);
+  fake::addOneWireDevice(id & 0xff, 20.0f);
+  fake::addOneWireDevice((id + 128) & 0xff, 5.0f);
+
+  char config[512];
+  snprintf(config, sizeof(config),
+    "node=node-%u\r\n"
+    "topic=fleet\r\n"
+    "sto=%u\r\n"
+    "sensor-a=node-%u.light\r\n"
+    "sensor.enabled-a=1\r\n", id, options.cycleSec, id);
+  LittleFS.setContent("/config.cfg", config);
+  setup();
+  // the DS18B20s have their address as location, enable them too
+  for (uint8_t i = 0; i < numberOfSensors(); ++i) sensors[i].enabled = true;
+}
+
+// runs loop() until the node's uptime reaches until (ms)
+void runNode(uint16_t id, uint32_t until) {
+  NodeSlot &slot = shared->nodes[id];
+  while (millis() < until) {
+    // the readings drift a little
+    fake::oneWireDevices[0].tempC = 20.0f + (millis() / 60000 % 20) * 0.125f;
+    loop();
+    ++slot.loops;
+    // a pass without work takes a few ms on the device
+    fake::advance(50);
+  }
+  slot.connected = mqttClient.connected();
+  slot.missed = mqttMissedValues;
+  slot.maxMissed = max(slot.maxMissed, mqttMissedValues);
+}
+
+void nodeProcess(uint16_t id, uint32_t bootAtMs, int commands, int acks) {
+  uint32_t now;
+  while (read(commands, &now, sizeof(now)) == sizeof(now)) {
+    if (now == UINT32_MAX) break;
+    if (now >= bootAtMs) {
+      if (!shared->nodes[id].booted) {
+        bootNode(id);
+        shared->nodes[id].booted = true;
+      }
+      runNode(id, now - bootAtMs);
+    }
+    char ack = 'k';
+    if (write(acks, &ack, 1) != 1) break;
+  }
+  _exit(0);
+}
+
+// --- simulation ---
+
+struct Node {
+  pid_t pid;
+  int commands;
+  int acks;
+};
+
+int main(int argc, char *argv[]) {
+  parseOptions(argc, argv);
+
+  shared = (Shared *) mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  memset(shared, 0, sizeof(Shared));
+  shared->broker.reset();
+  shared->broker.connectDelayMs = options.connectDelayMs;
+  fake::broker = &shared->broker;
+
+  randomSeed(42);
+  std::vector<Node> nodes(options.nodes);
+  for (uint16_t i = 0; i < options.nodes; ++i) {
+    int commands[2];
+    int acks[2];
+    if (pipe(commands) != 0 || pipe(acks) != 0) {
+      perror("pipe");
+      return 1;
+    }
+    uint32_t bootAtMs = random(options.bootSpreadSec * 1000 + 1);
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(commands[1]);
+      close(acks[0]);
+      nodeProcess(i, bootAtMs, commands[0], acks[1]);
+    }
+    close(commands[0]);
+    close(acks[1]);
+    nodes[i] = Node{ pid, commands[1], acks[0] };
+  }
+
+  fake::MqttBroker &b = shared->broker;
+  const uint32_t outageStart = options.outageAtSec * 1000;
+  const uint32_t outageEnd = outageStart + options.outageSec * 1000;
+  const uint32_t endMs = options.durationSec * 1000;
+  bool allBooted = false;
+  uint32_t allConnectedAt = 0;    // first time all nodes are connected after the boot
+  uint32_t convergedAt = 0;       // after the outage
+  uint32_t lastPublishes = 0;
+  uint32_t lastConnects = 0;
+  uint32_t lastFailures = 0;
+  uint32_t peakConnectRate = 0;
+  std::vector<uint32_t> publishRates;
+
+  for (uint32_t now = options.tickMs; now <= endMs; now += options.tickMs) {
+    if (options.outageSec > 0) {
+      if (now > outageStart && now <= outageEnd && b.up) b.setUp(false);
+      if (now > outageEnd && !b.up) b.setUp(true);
+    }
+    for (Node &n : nodes) {
+      char ack;
+      if (write(n.commands, &now, sizeof(now)) != sizeof(now) || read(n.acks, &ack, 1) != 1) {
+        fprintf(stderr, "node %d died\n", (int) n.pid);
+        return 1;
+      }
+    }
+
+    uint16_t connected = b.connectedCount();
+    if (!allBooted) {
+      allBooted = true;
+      for (uint16_t i = 0; i < options.nodes; ++i) allBooted = allBooted && shared->nodes[i].booted;
+    }
+    if (allConnectedAt == 0 && allBooted && connected == options.nodes) allConnectedAt = now;
+    if (convergedAt == 0 && now > outageEnd && connected == options.nodes) convergedAt = now;
+
+    if (now % 1000 == 0) {
+      uint32_t publishes = b.publishes - lastPublishes;
+      uint32_t connects = b.connects - lastConnects;
+      uint32_t failures = b.connectFailures - lastFailures;
+      lastPublishes = b.publishes;
+      lastConnects = b.connects;
+      lastFailures = b.connectFailures;
+      publishRates.push_back(publishes);
+      if (now > outageEnd) peakConnectRate = max(peakConnectRate, connects);
+      if (options.series) {
+        printf("{\"t\":%lu,\"broker_up\":%s,\"connected\":%u,\"publishes\":%lu,\"connects\":%lu,\"connect_failures\":%lu}\n",
+          (unsigned long) (now / 1000), b.up ? "true" : "false", connected, (unsigned long) publishes,
+          (unsigned long) connects, (unsigned long) failures);
+      }
+    }
+  }
+
+  for (Node &n : nodes) {
+    uint32_t quit = UINT32_MAX;
+    if (write(n.commands, &quit, sizeof(quit)) != sizeof(quit)) kill(n.pid, SIGKILL);
+    waitpid(n.pid, nullptr, 0);
+  }
+
+  std::vector<uint32_t> backlog;
+  uint64_t backlogSum = 0;
+  for (uint16_t i = 0; i < options.nodes; ++i) {
+    backlog.push_back(shared->nodes[i].maxMissed);
+    backlogSum += shared->nodes[i].maxMissed;
+  }
+  std::sort(backlog.begin(), backlog.end());
+  uint64_t publishSum = 0;
+  uint32_t publishPeak = 0;
+  for (uint32_t r : publishRates) {
+    publishSum += r;
+    publishPeak = max(publishPeak, r);
+  }
+
+  printf("{\"nodes\":%u,\"duration_s\":%lu,\"cycle_s\":%u,\"outage_at_s\":%lu,\"outage_s\":%lu,"
+    "\"publishes\":%lu,\"publish_rate_avg\":%.2f,\"publish_rate_peak\":%lu,"
+    "\"all_connected_after_boot_ms\":%ld,\"reconnect_convergence_ms\":%ld,\"connect_rate_peak\":%lu,"
+    "\"connects\":%lu,\"connect_failures\":%lu,"
+    "\"backlog_max\":%lu,\"backlog_p50\":%lu,\"backlog_avg\":%.2f}\n",
+    options.nodes, (unsigned long) options.durationSec, options.cycleSec,
+    (unsigned long) options.outageAtSec, (unsigned long) options.outageSec,
+    (unsigned long) b.publishes, publishRates.empty() ? 0.0 : (double) publishSum / publishRates.size(),
+    (unsigned long) publishPeak,
+    allConnectedAt > 0 ? (long) allConnectedAt : -1L,
+    options.outageSec == 0 ? 0L : (convergedAt > 0 ? (long) (convergedAt - outageEnd) : -1L),
+    (unsigned long) peakConnectRate,
+    (unsigned long) b.connects, (unsigned long) b.connectFailures,
+    (unsigned long) backlog.back(), (unsigned long) backlog[backlog.size() / 2], (double) backlogSum / options.nodes);
+  return 0;
+}
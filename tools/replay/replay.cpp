@@ -0,0 +1,173 @@
+// Replays a capture file (see Capture in main.cpp) through the firmware's processing
+// and publishing at full speed:
+//   pio run -e replay, then .pio/build/replay/program <capture.bin> [options]
+//   --correction=<sensor id>:<value>  replaces the captured correction (repeatable)
+//   --repeat=N                        replays the file N times, for stable timings
+// The readings go through setSensorDataValue() (processReading()) and each cycle
+// is published with sendMQTTData() to the broker stand-in. Output is one JSON
+// line: the cycles and readings, the host time per cycle, the MQTT publishes
+// and payload bytes and how often each sensor's value changed.
+
+#include "../../src/main.cpp"
+
+#include <chrono>
+#include <vector>
+
+#define REPLAY_MAX_CORRECTIONS 16
+
+struct Correction {
+  char id[SENSOR_ID_LENGTH];
+  float value;
+};
+
+struct ReplayOptions {
+  const char *file = nullptr;
+  uint32_t repeat = 1;
+  uint8_t correctionCount = 0;
+  Correction corrections[REPLAY_MAX_CORRECTIONS];
+};
+
+struct ReplayStats {
+  uint32_t cycles;
+  uint32_t readings;
+  uint32_t invalid;     // readings of an unknown sensor
+  uint32_t tables;      // sensor tables in the file
+  uint32_t changes[MAX_SENSORS];
+};
+
+ReplayOptions options;
+ReplayStats stats;
+
+void parseOptions(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--repeat=", 9) == 0) {
+      options.repeat = max(strtoul(arg + 9, nullptr, 10), 1UL);
+    } else if (strncmp(arg, "--correction=", 13) == 0) {
+      const char *colon = strchr(arg + 13, ':');
+      if (colon == nullptr || options.correctionCount == REPLAY_MAX_CORRECTIONS) {
+        fprintf(stderr, "invalid option %s\n", arg);
+        exit(2);
+      }
+      Correction &c = options.corrections[options.correctionCount++];
+      strlcpy(c.id, arg + 13, min((size_t) (colon - arg - 13 + 1), sizeof(c.id)));
+      c.value = atof(colon + 1);
+    } else if (arg[0] != '-' && options.file == nullptr) {
+      options.file = arg;
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg);
+      exit(2);
+    }
+  }
+  if (options.file == nullptr) {
+    fprintf(stderr, "usage: replay <capture.bin> [--correction=<id>:<value>] [--repeat=N]\n");
+    exit(2);
+  }
+}
+
+// a node with the captured sensors, all enabled, connected to the broker
+void setupNode(const CaptureSensor *table, uint8_t count) {
+  memset(sensors, 0, sizeof(sensors));
+  for (uint8_t i = 0; i < count && i < MAX_SENSORS; ++i) {
+    SensorData &sd = sensors[i];
+    memcpy(sd.id, table[i].id, SENSOR_ID_LENGTH);
+    sd.id[SENSOR_ID_LENGTH - 1] = '\0';
+    memcpy(sd.measurand, table[i].measurand, SENSOR_MEASURAND_LENGTH);
+    sd.measurand[SENSOR_MEASURAND_LENGTH - 1] = '\0';
+    strlcpy(sd.location, sd.id, SENSOR_LOCATION_LENGTH);
+    strlcpy(sd.type, "replay", sizeof(sd.type));
+    sd.correction = table[i].correction;
+    for (uint8_t c = 0; c < options.correctionCount; ++c) {
+      if (strcmp(options.corrections[c].id, sd.id) == 0) sd.correction = options.corrections[c].value;
+    }
+    sd.enabled = true;
+    updateSensorTopic(sd);
+  }
+}
+
+void publishCycle() {
+  sendMQTTData();
+  ++stats.cycles;
+}
+
+// replays the whole file once
+void replay(const std::vector<uint8_t> &data) {
+  size_t pos = 0;
+  uint32_t seen = 0; // the sensors read in the current cycle
+  while (pos < data.size()) {
+    if (data.size() - pos >= 5 && memcmp(&data[pos], CAPTURE_MAGIC, 4) == 0) {
+      if (seen != 0) publishCycle();
+      seen = 0;
+      uint8_t count = data[pos + 4];
+      pos += 5;
+      if (data.size() - pos < count * sizeof(CaptureSensor)) break;
+      setupNode((const CaptureSensor *) &data[pos], count);
+      pos += count * sizeof(CaptureSensor);
+      ++stats.tables;
+      continue;
+    }
+    if (data.size() - pos < sizeof(CaptureRecord)) break;
+    CaptureRecord cr;
+    memcpy(&cr, &data[pos], sizeof(cr));
+    pos += sizeof(cr);
+
+    uint8_t idx = cr.sensor & ~CAPTURE_UPTIME;
+    if (idx >= numberOfSensors()) {
+      ++stats.invalid;
+      continue;
+    }
+    // a sensor read twice starts the next cycle
+    if (seen & (1UL << idx)) {
+      publishCycle();
+      seen = 0;
+    }
+    seen |= 1UL << idx;
+    uint32_t version = sensors[idx].version;
+    setSensorDataValue(idx, cr.raw);
+    if (sensors[idx].version != version) ++stats.changes[idx];
+    ++stats.readings;
+  }
+  if (seen != 0) publishCycle();
+}
+
+int main(int argc, char *argv[]) {
+  parseOptions(argc, argv);
+
+  std::vector<uint8_t> data;
+  FILE *in = fopen(options.file, "rb");
+  if (in == nullptr) {
+    perror(options.file);
+    return 1;
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(in);
+  if (data.size() < 5 || memcmp(data.data(), CAPTURE_MAGIC, 4) != 0) {
+    fprintf(stderr, "%s is no capture file\n", options.file);
+    return 1;
+  }
+
+  fake::serialQuiet = true;
+  WiFi.begin();
+  mqttClient.connect("replay");
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < options.repeat; ++i) replay(data);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  const fake::MqttBroker &b = *fake::broker;
+  printf("{\"file\":\"%s\",\"bytes\":%lu,\"repeat\":%lu,\"tables\":%lu,\"cycles\":%lu,\"readings\":%lu,\"invalid\":%lu,"
+    "\"ns_per_cycle\":%.1f,\"publishes\":%lu,\"payload_bytes\":%llu,\"publishes_per_cycle\":%.2f,\"sensors\":[",
+    options.file, (unsigned long) data.size(), (unsigned long) options.repeat, (unsigned long) stats.tables,
+    (unsigned long) stats.cycles, (unsigned long) stats.readings, (unsigned long) stats.invalid,
+    stats.cycles > 0 ? (double) ns / stats.cycles : 0.0, (unsigned long) b.publishes,
+    (unsigned long long) b.payloadBytes, stats.cycles > 0 ? (double) b.publishes / stats.cycles : 0.0);
+  for (uint8_t i = 0; i < numberOfSensors(); ++i) {
+    printf("%s{\"id\":\"%s\",\"measurand\":\"%s\",\"correction\":%.2f,\"changes\":%lu,\"last\":\"%s\"}",
+      i > 0 ? "," : "", sensors[i].id, sensors[i].measurand, sensors[i].correction,
+      (unsigned long) stats.changes[i], sensors[i].value);
+  }
+  printf("]}\n");
+  return 0;
+}